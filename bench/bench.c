@@ -0,0 +1,727 @@
+/**
+ * Microbenchmarks for the game's hot paths: generating a board, flood filling
+ * a region of blanks, chording, composing a full frame, and parsing typed
+ * moves, plus generating on bitplanes instead of a board, resetting a board
+ * in bands of rows across threads, and whole games played on boards from a
+ * pool. Each one runs over a
+ * range of board sizes and mine densities, with warmup runs first, and reports
+ * the median and 99th percentile time of the timed runs as CSV or JSON.
+ *
+ * The bench is linked with the allocator wrapped, so it counts every heap
+ * allocation. Games on pooled boards must not allocate at all once the pool
+ * is warm, and the run fails if any of them do. Benchmarks of alternate ways
+ * to build a board also check, untimed, that they build the same board, and
+ * the run fails if one doesn't.
+ *
+ * Given a baseline, in the CSV this prints, each result is compared with the
+ * matching one in the baseline, and the run fails if any median got slower by
+ * more than the threshold.
+ */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include "../src/board.h"
+#include "../src/render.h"
+#include "../src/input.h"
+#include "../src/pool.h"
+#include "../src/bitboard.h"
+#include "../src/log.h"
+
+/** Most timed runs kept for one result. */
+#define REPS_MAX 1000
+/** Fewest timed runs for one result, however long they take. */
+#define REPS_MIN 3
+/** Number of moves parsed in each run of the parse benchmark. */
+#define PARSE_LINES 1024
+/** Most results read from a baseline file. */
+#define BASELINE_MAX 1024
+/** Most random moves made in each game of the steady benchmark. */
+#define STEADY_MOVES 64
+
+/** Board sizes benchmarked, from beginner to huge. */
+static const int SIZES[][2] = {
+  { 9, 9 }, { 30, 16 }, { 100, 100 }, { 512, 512 }, { 1024, 1024 },
+  { 4096, 4096 }
+};
+/** Fraction of tiles that are mines. Beginner, intermediate, and expert. */
+static const double DENSITIES[] = { 0.12, 0.16, 0.21 };
+
+/**
+ * Board and buffers shared by the runs of one result.
+ */
+typedef struct Fixture {
+  int width;
+  int height;
+  int mines;
+  // Board reused between runs, reset with a new seed for each
+  Board *board;
+  // Bitplanes of the same size, for the bitgen and bandreset benchmarks
+  Bitboard *bits;
+  // Threads for the bandreset benchmark
+  BandPool *bands;
+  // Pool the steady benchmark takes its boards from
+  BoardPool pool;
+  // Frame for the render benchmark
+  Frame frame;
+  // Moves for the parse benchmark
+  char (*lines)[32];
+} Fixture;
+
+/**
+ * One benchmark. Its run function sets up the fixture for the given seed,
+ * times only the work being measured, and reports how many operations it
+ * did, so the cost per operation can be worked out.
+ */
+typedef struct Bench {
+  const char *name;
+  // Whether it only depends on the board size, so it's run once per size
+  // instead of once per density
+  bool per_size;
+  // Whether a run must not allocate, checked once warmup has filled the pool
+  bool no_alloc;
+  size_t (*run)(Fixture *fixture, uint64_t seed, double *ns);
+  // Checks, untimed, that the work comes out right for a seed, printing what
+  // differs if it doesn't. May be NULL.
+  bool (*check)(Fixture *fixture, uint64_t seed);
+} Bench;
+
+/**
+ * One result from a baseline file.
+ */
+typedef struct Baseline {
+  char name[32];
+  int width;
+  int height;
+  int mines;
+  double median_ns;
+} Baseline;
+
+/** Heap allocations made so far, counted by the wrappers below. */
+static unsigned long long allocations;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *block, size_t size);
+
+/**
+ * Counts an allocation, then makes it. The linker sends every call to malloc
+ * here, through --wrap=malloc.
+ */
+void *__wrap_malloc(size_t size) {
+  allocations++;
+  return __real_malloc(size);
+}
+
+/**
+ * Counts an allocation, then makes it, for calloc.
+ */
+void *__wrap_calloc(size_t count, size_t size) {
+  allocations++;
+  return __real_calloc(count, size);
+}
+
+/**
+ * Counts an allocation, then makes it, for realloc.
+ */
+void *__wrap_realloc(void *block, size_t size) {
+  allocations++;
+  return __real_realloc(block, size);
+}
+
+/**
+ * Gets the current time in nanoseconds from a monotonic clock.
+ *
+ * @return the current time in nanoseconds
+ */
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * Generate: allocate a board and place its mines.
+ */
+static size_t run_gen(Fixture *fixture, uint64_t seed, double *ns) {
+  double start = now_ns();
+  Board *board = newBoardSeeded(fixture -> width, fixture -> height,
+      fixture -> mines, seed);
+  board_free(board);
+  *ns = now_ns() - start;
+  return 1;
+}
+
+/**
+ * Reset: place a reused board's mines again, counting each into its
+ * neighbors one at a time.
+ */
+static size_t run_reset(Fixture *fixture, uint64_t seed, double *ns) {
+  double start = now_ns();
+  board_reset(fixture -> board, seed);
+  *ns = now_ns() - start;
+  return (size_t) fixture -> width * fixture -> height;
+}
+
+/**
+ * Bitgen: place the same mines on bitplanes instead, and work out every
+ * count a word at a time.
+ */
+static size_t run_bitgen(Fixture *fixture, uint64_t seed, double *ns) {
+  Bitboard *bits = fixture -> bits;
+  Rng rng;
+  double start = now_ns();
+  rng_seed(&rng, seed);
+  bitboard_clear(bits);
+  bitboard_place_mines(bits, &rng, fixture -> mines);
+  bitboard_count(bits);
+  *ns = now_ns() - start;
+  return (size_t) fixture -> width * fixture -> height;
+}
+
+/**
+ * Compares the tiles of two boards of the same size, border ring included.
+ *
+ * @param name the benchmark checking, for the message
+ * @param expected the board as it should be
+ * @param actual the board to check
+ * @return true if every tile matches
+ */
+static bool same_cells(const char *name, const Board *expected,
+    const Board *actual) {
+  size_t len_total = (size_t) expected -> stride * ( expected -> height + 2 );
+  for ( size_t i = 0; i < len_total; i++ ) {
+    if ( expected -> cells[i] != actual -> cells[i] ) {
+      fprintf(stderr, "bench: %s %dx%d/%lld tile (%d, %d) is 0x%02x, expected"
+          " 0x%02x\n", name, expected -> width, expected -> height,
+          (long long) expected -> mineCount,
+          (int) ( i % expected -> stride ) - 1,
+          (int) ( i / expected -> stride ) - 1, actual -> cells[i],
+          expected -> cells[i]);
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Checks bitgen's conversions: a board partway through a game, read onto
+ * bitplanes, counted, and written to a second board, must come out tile for
+ * tile the same.
+ */
+static bool check_bitgen(Fixture *fixture, uint64_t seed) {
+  Board *board = fixture -> board;
+  board_reset(board, seed);
+  board_expose_safe(board);
+  // Flag a few hidden tiles, so every plane has something on it
+  for ( int i = 0; i < 16; i++ ) {
+    int x = rng_below(&board -> rng, board -> width);
+    int y = rng_below(&board -> rng, board -> height);
+    if ( !( *board_tile(board, x, y) & TILE_EXPOSED ) ) {
+      board_flag(board, x, y);
+    }
+  }
+  // Written over, but its generator is seeded for the recount
+  Board *copy = newBoardSeeded(board -> width, board -> height, 0, seed);
+  if ( !copy ) {
+    fprintf(stderr, "bench: bitgen %dx%d has no memory to check with\n",
+        board -> width, board -> height);
+    return false;
+  }
+  bitboard_from_board(fixture -> bits, board);
+  bitboard_count(fixture -> bits);
+  bitboard_to_board(fixture -> bits, copy);
+  bool same = same_cells("bitgen", board, copy);
+  board_free(copy);
+  return same;
+}
+
+/**
+ * Bandreset: the same reset as reset, counted and recounted in bands of rows
+ * across threads, coming out the same.
+ */
+static size_t run_bandreset(Fixture *fixture, uint64_t seed, double *ns) {
+  double start = now_ns();
+  bitboard_reset_board(fixture -> bits, fixture -> board, seed,
+      fixture -> bands);
+  *ns = now_ns() - start;
+  return (size_t) fixture -> width * fixture -> height;
+}
+
+/**
+ * Finds what, past its tiles, differs between two boards reset from the same
+ * seed.
+ *
+ * @param expected the board as it should be
+ * @param actual the board to check
+ * @return what differs, or NULL if nothing does
+ */
+static const char *reset_difference(const Board *expected,
+    const Board *actual) {
+  for ( int y = 0; y < expected -> height; y++ ) {
+    for ( int x = 0; x < expected -> width; x++ ) {
+      size_t i = board_index(expected, x, y);
+      if ( expected -> around[i] != actual -> around[i] ) {
+        return "counts around its tiles";
+      }
+    }
+  }
+  if ( expected -> safe_pick != actual -> safe_pick ) {
+    return "starting tile";
+  }
+  if ( memcmp(expected -> rng.state, actual -> rng.state,
+      sizeof(expected -> rng.state)) != 0 ) {
+    return "generator state";
+  }
+  if ( expected -> bbbv != actual -> bbbv ) {
+    return "3BV";
+  }
+  if ( expected -> regions != actual -> regions ) {
+    return "region count";
+  }
+  return NULL;
+}
+
+/**
+ * Checks bandreset against reset: a board reset in bands must match one reset
+ * serially from the same seed in its tiles, the counts around them, its
+ * starting tile, its regions and 3BV, and where its generator was left.
+ */
+static bool check_bandreset(Fixture *fixture, uint64_t seed) {
+  Board *board = fixture -> board;
+  Board *serial = newBoardSeeded(board -> width, board -> height, 0, seed);
+  if ( !serial ) {
+    fprintf(stderr, "bench: bandreset %dx%d has no memory to check with\n",
+        board -> width, board -> height);
+    return false;
+  }
+  serial -> mineCount = board -> mineCount;
+  board_reset(serial, seed);
+  bitboard_reset_board(fixture -> bits, board, seed, fixture -> bands);
+
+  bool same = same_cells("bandreset", serial, board);
+  const char *differs = same ? reset_difference(serial, board) : NULL;
+  if ( differs ) {
+    fprintf(stderr, "bench: bandreset %dx%d/%lld differs from reset in its"
+        " %s\n", board -> width, board -> height,
+        (long long) board -> mineCount, differs);
+  }
+  board_free(serial);
+  return same && !differs;
+}
+
+/**
+ * Flood: expose a blank tile, exposing the whole region of blanks around it.
+ * Tries the tiles in order from a random start until it finds a blank.
+ */
+static size_t run_flood(Fixture *fixture, uint64_t seed, double *ns) {
+  Board *board = fixture -> board;
+  board_reset(board, seed);
+  size_t tiles = (size_t) board -> width * board -> height;
+  size_t start_tile = rng_below(&board -> rng, tiles);
+  int x = 0;
+  int y = 0;
+  for ( size_t i = 0; i < tiles; i++ ) {
+    size_t tile = ( start_tile + i ) % tiles;
+    x = tile % board -> width;
+    y = tile / board -> width;
+    if ( tile_bomb(*board_tile(board, x, y)) == 0 ) {
+      break;
+    }
+  }
+
+  double start = now_ns();
+  board_expose_pick(board, x, y);
+  *ns = now_ns() - start;
+  return (size_t) board -> exposed;
+}
+
+/**
+ * Chord: with every mine flagged and one region exposed, chord each exposed
+ * number in turn. Exposing the tiles around one number can expose more
+ * numbers further on, so this sweeps across most of the board.
+ */
+static size_t run_chord(Fixture *fixture, uint64_t seed, double *ns) {
+  Board *board = fixture -> board;
+  board_reset(board, seed);
+  for ( int y = 0; y < board -> height; y++ ) {
+    for ( int x = 0; x < board -> width; x++ ) {
+      if ( tile_is_mine(*board_tile(board, x, y)) ) {
+        board_flag(board, x, y);
+      }
+    }
+  }
+  board_expose_safe(board);
+
+  size_t chords = 0;
+  double start = now_ns();
+  for ( int y = 0; y < board -> height; y++ ) {
+    for ( int x = 0; x < board -> width; x++ ) {
+      size_t index = board_index(board, x, y);
+      Tile tile = board -> cells[index];
+      if ( tile_is_exposed(tile) && tile_count(tile) > 0 &&
+          board_nearby_blanks(board, index) > 0 ) {
+        board_expose_pick(board, x, y);
+        chords++;
+      }
+    }
+  }
+  *ns = now_ns() - start;
+  return chords;
+}
+
+/**
+ * Render: compose the whole board, partly exposed, into a frame.
+ */
+static size_t run_render(Fixture *fixture, uint64_t seed, double *ns) {
+  Board *board = fixture -> board;
+  board_reset(board, seed);
+  board_expose_safe(board);
+  fixture -> frame.length = 0;
+
+  double start = now_ns();
+  render_board(&fixture -> frame, board);
+  *ns = now_ns() - start;
+  return (size_t) board -> width * board -> height;
+}
+
+/**
+ * Parse: read typed moves, the way line mode does.
+ */
+static size_t run_parse(Fixture *fixture, uint64_t seed, double *ns) {
+  Board *board = fixture -> board;
+  Rng rng;
+  rng_seed(&rng, seed);
+  for ( size_t i = 0; i < PARSE_LINES; i++ ) {
+    char column[COLUMN_NAME_MAX];
+    board_column_name(rng_below(&rng, board -> width), column);
+    snprintf(fixture -> lines[i], sizeof(fixture -> lines[i]), "%c%s%d\n",
+        rng_below(&rng, 2) ? 'e' : 'F', column,
+        (int) rng_below(&rng, board -> height) + 1);
+  }
+
+  size_t parsed = 0;
+  double start = now_ns();
+  for ( size_t i = 0; i < PARSE_LINES; i++ ) {
+    Move move;
+    parsed += input_parse_move(board, fixture -> lines[i], &move) ==
+        EXIT_SUCCESS;
+  }
+  *ns = now_ns() - start;
+  return parsed;
+}
+
+/**
+ * Steady: play a whole game the way a simulation worker does. Take a board
+ * from the pool, open it, expose random tiles until the game ends or the
+ * moves run out, and give the board back.
+ */
+static size_t run_steady(Fixture *fixture, uint64_t seed, double *ns) {
+  size_t moves = 0;
+  double start = now_ns();
+  Board *board = pool_take(&fixture -> pool, fixture -> width,
+      fixture -> height, fixture -> mines, seed, false);
+  board_expose_safe(board);
+  while ( moves < STEADY_MOVES && board -> exposed < board_safe_tiles(board) ) {
+    int x = rng_below(&board -> rng, board -> width);
+    int y = rng_below(&board -> rng, board -> height);
+    if ( *board_tile(board, x, y) & ( TILE_EXPOSED | TILE_FLAGGED ) ) {
+      continue;
+    }
+    moves++;
+    if ( board_expose_pick(board, x, y) == LOSE_MINE ) {
+      break;
+    }
+  }
+  pool_give(&fixture -> pool, board);
+  *ns = now_ns() - start;
+  return moves + 1;
+}
+
+static const Bench BENCHES[] = {
+  { "gen", false, false, run_gen, NULL },
+  { "reset", false, false, run_reset, NULL },
+  { "bitgen", false, false, run_bitgen, check_bitgen },
+  { "bandreset", false, false, run_bandreset, check_bandreset },
+  { "flood", false, false, run_flood, NULL },
+  { "chord", false, false, run_chord, NULL },
+  { "render", false, false, run_render, NULL },
+  { "parse", true, false, run_parse, NULL },
+  { "steady", false, true, run_steady, NULL },
+};
+
+/**
+ * Compares two doubles, for qsort.
+ */
+static int compare_double(const void *a, const void *b) {
+  double first = *(const double *) a;
+  double second = *(const double *) b;
+  return ( first > second ) - ( first < second );
+}
+
+/**
+ * Reads the results from a CSV file this benchmark printed before.
+ *
+ * @param path the path of the file to read
+ * @param baselines where to place the results
+ * @return the number of results read, or -1 if the file couldn't be opened
+ */
+static int read_baseline(const char *path, Baseline baselines[BASELINE_MAX]) {
+  FILE *file = fopen(path, "r");
+  if ( file == NULL ) {
+    return -1;
+  }
+  int count = 0;
+  char line[256];
+  while ( count < BASELINE_MAX && fgets(line, sizeof(line), file) != NULL ) {
+    Baseline *baseline = &baselines[count];
+    // bench,width,height,mines,reps,ops,median_ns,...
+    if ( sscanf(line, "%31[^,],%d,%d,%d,%*d,%*d,%lf", baseline -> name,
+        &baseline -> width, &baseline -> height, &baseline -> mines,
+        &baseline -> median_ns) == 5 ) {
+      count++;
+    }
+  }
+  fclose(file);
+  return count;
+}
+
+/**
+ * Finds the baseline for a result.
+ *
+ * @return the matching baseline, or NULL if there isn't one
+ */
+static const Baseline *find_baseline(const Baseline *baselines, int count,
+    const char *name, const Fixture *fixture) {
+  for ( int i = 0; i < count; i++ ) {
+    if ( strcmp(baselines[i].name, name) == 0 &&
+        baselines[i].width == fixture -> width &&
+        baselines[i].height == fixture -> height &&
+        baselines[i].mines == fixture -> mines ) {
+      return &baselines[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Prints how to use the benchmark, to stderr.
+ */
+static void usage(void) {
+  fprintf(stderr,
+      "usage: bench [options]\n"
+      "  --json              print JSON instead of CSV\n"
+      "  --reps N            timed runs per result, at most (default 15)\n"
+      "  --warmup N          untimed runs before those (default 2)\n"
+      "  --budget SECONDS    stop a result early after this long, once it\n"
+      "                      has %d runs (default 2)\n"
+      "  --bench NAMES       only run these, comma separated: gen, reset,\n"
+      "                      bitgen, bandreset, flood, chord, render, parse,\n"
+      "                      steady\n"
+      "  --max-tiles N       skip boards with more tiles than this\n"
+      "  --baseline FILE     compare with a CSV from an earlier run\n"
+      "  --threshold PCT     slowdown past the baseline that fails the run\n"
+      "                      (default 10)\n"
+      "  --threads N         threads for bandreset (default one per core)\n",
+      REPS_MIN);
+}
+
+/**
+ * Runs the benchmarks and prints the results.
+ *
+ * @param argc the number of arguments
+ * @param argv the arguments
+ * @return 0 if successful, else 1 if the arguments were bad, a result got
+ *  slower than its baseline allows, a game on a pooled board allocated, or a
+ *  board came out wrong
+ */
+int main(int argc, char *argv[]) {
+  bool json = false;
+  int reps = 15;
+  int warmup = 2;
+  double budget = 2;
+  const char *only = NULL;
+  long long max_tiles = LLONG_MAX;
+  const char *baseline_path = NULL;
+  double threshold = 10;
+  int threads = 0;
+
+  // Read options
+  for ( int i = 1; i < argc; i++ ) {
+    bool has_value = i + 1 < argc;
+    if ( strcmp(argv[i], "--json") == 0 ) {
+      json = true;
+    } else if ( strcmp(argv[i], "--reps") == 0 && has_value ) {
+      reps = atoi(argv[++i]);
+    } else if ( strcmp(argv[i], "--warmup") == 0 && has_value ) {
+      warmup = atoi(argv[++i]);
+    } else if ( strcmp(argv[i], "--budget") == 0 && has_value ) {
+      budget = atof(argv[++i]);
+    } else if ( strcmp(argv[i], "--bench") == 0 && has_value ) {
+      only = argv[++i];
+    } else if ( strcmp(argv[i], "--max-tiles") == 0 && has_value ) {
+      max_tiles = atoll(argv[++i]);
+    } else if ( strcmp(argv[i], "--baseline") == 0 && has_value ) {
+      baseline_path = argv[++i];
+    } else if ( strcmp(argv[i], "--threshold") == 0 && has_value ) {
+      threshold = atof(argv[++i]);
+    } else if ( strcmp(argv[i], "--threads") == 0 && has_value ) {
+      threads = atoi(argv[++i]);
+    } else {
+      usage();
+      return EXIT_FAILURE;
+    }
+  }
+  if ( reps < 1 || reps > REPS_MAX || warmup < 0 ) {
+    fprintf(stderr, "bench: --reps must be 1-%d, --warmup at least 0\n",
+        REPS_MAX);
+    return EXIT_FAILURE;
+  }
+
+  // Read the baseline
+  static Baseline baselines[BASELINE_MAX];
+  int baseline_count = 0;
+  if ( baseline_path != NULL ) {
+    baseline_count = read_baseline(baseline_path, baselines);
+    if ( baseline_count < 0 ) {
+      fprintf(stderr, "bench: can't read baseline %s\n", baseline_path);
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Keep the board code quiet
+  log_set_level(LOG_LEVEL_ERROR);
+  static BandPool bands;
+  if ( bands_init(&bands, threads) != EXIT_SUCCESS ) {
+    return EXIT_FAILURE;
+  }
+
+  if ( json ) {
+    printf("[");
+  } else {
+    printf("bench,width,height,mines,reps,ops,median_ns,p99_ns,ns_per_op%s\n",
+        baseline_path != NULL ? ",baseline_ns,change_pct" : "");
+  }
+
+  static double samples[REPS_MAX];
+  bool first_result = true;
+  int failures = 0;
+  size_t bench_count = sizeof(BENCHES) / sizeof(BENCHES[0]);
+  size_t size_count = sizeof(SIZES) / sizeof(SIZES[0]);
+  size_t density_count = sizeof(DENSITIES) / sizeof(DENSITIES[0]);
+
+  for ( size_t s = 0; s < size_count; s++ ) {
+    Fixture fixture = { 0 };
+    fixture.width = SIZES[s][0];
+    fixture.height = SIZES[s][1];
+    if ( (long long) fixture.width * fixture.height > max_tiles ) {
+      continue;
+    }
+    fixture.board = newBoardSeeded(fixture.width, fixture.height, 0, 1);
+    frame_init(&fixture.frame);
+    fixture.lines = malloc(PARSE_LINES * sizeof(*fixture.lines));
+    fixture.bits = newBitboard(fixture.width, fixture.height);
+    fixture.bands = &bands;
+    pool_init(&fixture.pool, 1);
+
+    for ( size_t d = 0; d < density_count; d++ ) {
+      fixture.mines = DENSITIES[d] * fixture.width * fixture.height;
+      fixture.board -> mineCount = fixture.mines;
+
+      for ( size_t b = 0; b < bench_count; b++ ) {
+        const Bench *bench = &BENCHES[b];
+        if ( ( only != NULL && strstr(only, bench -> name) == NULL ) ||
+            ( bench -> per_size && d > 0 ) ) {
+          continue;
+        }
+
+        // Warm up, then time runs until there are enough or the budget is
+        // spent
+        uint64_t seed = 1;
+        size_t ops = 0;
+        for ( int i = 0; i < warmup; i++ ) {
+          bench -> run(&fixture, seed++, &samples[0]);
+        }
+        int done = 0;
+        double spent = 0;
+        unsigned long long allocated = allocations;
+        while ( done < reps && ( done < REPS_MIN || spent < budget * 1e9 ) ) {
+          ops = bench -> run(&fixture, seed++, &samples[done]);
+          spent += samples[done];
+          done++;
+        }
+        allocated = allocations - allocated;
+        if ( bench -> no_alloc && allocated > 0 ) {
+          fprintf(stderr, "bench: %s %dx%d/%d made %llu heap allocations in "
+              "%d runs, expected none\n", bench -> name, fixture.width,
+              fixture.height, fixture.mines, allocated, done);
+          failures++;
+        }
+        if ( bench -> check && !bench -> check(&fixture, seed) ) {
+          failures++;
+        }
+        qsort(samples, done, sizeof(double), compare_double);
+        double median = done % 2 ? samples[done / 2] :
+            ( samples[done / 2 - 1] + samples[done / 2] ) / 2;
+        double p99 = samples[( done * 99 + 99 ) / 100 - 1];
+        double per_op = ops > 0 ? median / ops : 0;
+
+        // Compare with the baseline
+        const Baseline *baseline = find_baseline(baselines, baseline_count,
+            bench -> name, &fixture);
+        double change = 0;
+        if ( baseline != NULL && baseline -> median_ns > 0 ) {
+          change = ( median / baseline -> median_ns - 1 ) * 100;
+          if ( change > threshold ) {
+            fprintf(stderr, "bench: %s %dx%d/%d is %.1f%% slower than the "
+                "baseline\n", bench -> name, fixture.width, fixture.height,
+                fixture.mines, change);
+            failures++;
+          }
+        }
+
+        if ( json ) {
+          printf("%s\n  {\"bench\": \"%s\", \"width\": %d, \"height\": %d, "
+              "\"mines\": %d, \"reps\": %d, \"ops\": %zu, \"median_ns\": %.0f, "
+              "\"p99_ns\": %.0f, \"ns_per_op\": %.2f", first_result ? "" : ",",
+              bench -> name, fixture.width, fixture.height, fixture.mines,
+              done, ops, median, p99, per_op);
+          if ( baseline != NULL ) {
+            printf(", \"baseline_ns\": %.0f, \"change_pct\": %.1f",
+                baseline -> median_ns, change);
+          }
+          printf("}");
+        } else {
+          printf("%s,%d,%d,%d,%d,%zu,%.0f,%.0f,%.2f", bench -> name,
+              fixture.width, fixture.height, fixture.mines, done, ops, median,
+              p99, per_op);
+          if ( baseline != NULL ) {
+            printf(",%.0f,%.1f", baseline -> median_ns, change);
+          } else if ( baseline_path != NULL ) {
+            printf(",,");
+          }
+          printf("\n");
+        }
+        fflush(stdout);
+        first_result = false;
+      }
+    }
+
+    pool_free(&fixture.pool);
+    bitboard_free(fixture.bits);
+    free(fixture.lines);
+    frame_free(&fixture.frame);
+    board_free(fixture.board);
+  }
+
+  if ( json ) {
+    printf("\n]\n");
+  }
+  bands_free(&bands);
+  return failures > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
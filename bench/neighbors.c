@@ -0,0 +1,153 @@
+/**
+ * Microbenchmark for neighbor iteration on the board.
+ *
+ * Compares the old approach, where list_nearby() bounds checked all 8
+ * positions around a tile and filled an array for the caller to walk, against
+ * the border-padded layout, where every tile has 8 neighbors at fixed offsets.
+ * Both count nearby blanks for every tile on the board, like print_row() does,
+ * and report the cost per neighbor visited.
+ */
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <time.h>
+#include "../src/tile.h"
+
+/** Number of times each pass is repeated. */
+#define REPETITIONS 20
+
+/**
+ * Gets the current time in nanoseconds from a monotonic clock.
+ *
+ * @return the current time in nanoseconds
+ */
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * Before: list nearby indices with bounds checks, then walk the list.
+ */
+static short list_nearby(const Tile *cells, short width, short height,
+    short x, short y, size_t nearby[8]) {
+  short tile_idx = 0;
+  for ( int offset_y = -1; offset_y <= 1; offset_y++ ) {
+    for ( int offset_x = -1; offset_x <= 1; offset_x++ ) {
+      if ( offset_x == 0 && offset_y == 0 ) {
+        continue;
+      }
+      size_t near_y = y + offset_y;
+      size_t near_x = x + offset_x;
+      if ( near_y >= (size_t) height || near_x >= (size_t) width ) {
+        continue;
+      }
+      nearby[tile_idx++] = near_y * width + near_x;
+    }
+  }
+  (void) cells;
+  return tile_idx;
+}
+
+static long pass_before(const Tile *cells, short width, short height) {
+  long total = 0;
+  for ( short y = 0; y < height; y++ ) {
+    for ( short x = 0; x < width; x++ ) {
+      size_t nearby[8];
+      short nearby_count = list_nearby(cells, width, height, x, y, nearby);
+      for ( short i = 0; i < nearby_count; i++ ) {
+        Tile tile_near = cells[nearby[i]];
+        if ( !tile_is_exposed(tile_near) && !tile_is_flagged(tile_near) ) {
+          total++;
+        }
+      }
+    }
+  }
+  return total;
+}
+
+/**
+ * After: border-padded layout with a fixed table of neighbor offsets.
+ */
+static long pass_after(const Tile *cells, short width, short height,
+    const ptrdiff_t nearby[8]) {
+  long total = 0;
+  int stride = width + 2;
+  for ( short y = 0; y < height; y++ ) {
+    const Tile *tile = cells + (size_t) ( y + 1 ) * stride + 1;
+    for ( short x = 0; x < width; x++, tile++ ) {
+      short nearby_blanks = 0;
+      for ( int i = 0; i < 8; i++ ) {
+        nearby_blanks +=
+          ( tile[nearby[i]] & ( TILE_EXPOSED | TILE_FLAGGED ) ) == 0;
+      }
+      total += nearby_blanks;
+    }
+  }
+  return total;
+}
+
+/**
+ * Runs both passes over one board size and prints the results.
+ *
+ * @param width the width of the board to test
+ * @param height the height of the board to test
+ */
+static void run(short width, short height) {
+  int stride = width + 2;
+  Tile *flat = malloc((size_t) width * height);
+  Tile *padded = calloc((size_t) stride * ( height + 2 ), 1);
+  ptrdiff_t nearby[8] = {
+    -stride - 1, -stride, -stride + 1, -1, 1, stride - 1, stride, stride + 1
+  };
+
+  // Borders are exposed, interior gets a random mix of states
+  for ( size_t i = 0; i < (size_t) stride * ( height + 2 ); i++ ) {
+    padded[i] = TILE_BORDER | TILE_EXPOSED;
+  }
+  srand(1);
+  for ( short y = 0; y < height; y++ ) {
+    for ( short x = 0; x < width; x++ ) {
+      int roll = rand() % 10;
+      Tile tile = roll < 4 ? TILE_EXPOSED : roll < 5 ? TILE_FLAGGED : 0;
+      flat[(size_t) y * width + x] = tile;
+      padded[(size_t) ( y + 1 ) * stride + x + 1] = tile;
+    }
+  }
+
+  // Neighbors visited per pass: every in-bounds neighbor of every tile
+  double visits = 8.0 * width * height - 6.0 * ( width + height ) + 4.0;
+
+  long check_before = 0;
+  long check_after = 0;
+  double start = now_ns();
+  for ( int r = 0; r < REPETITIONS; r++ ) {
+    check_before += pass_before(flat, width, height);
+  }
+  double before = ( now_ns() - start ) / REPETITIONS / visits;
+
+  start = now_ns();
+  for ( int r = 0; r < REPETITIONS; r++ ) {
+    check_after += pass_after(padded, width, height, nearby);
+  }
+  double after = ( now_ns() - start ) / REPETITIONS / visits;
+
+  printf("%5dx%-5d  before %6.3f ns/neighbor  after %6.3f ns/neighbor"
+      "  speedup %5.2fx%s\n", width, height, before, after, before / after,
+      check_before == check_after ? "" : "  MISMATCH");
+
+  free(flat);
+  free(padded);
+}
+
+int main(void) {
+  run(9, 9);
+  run(30, 16);
+  run(256, 256);
+  run(1024, 1024);
+  run(4096, 4096);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,265 @@
+#include "analyze.h"
+#include "batch.h"
+#include "solver.h"
+#include "log.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/** Slot value for a board whose 3BV wasn't worked out, or wasn't analyzed. */
+#define UNMEASURED UINT32_MAX
+/** Widest bar in a histogram, in characters. */
+#define BAR_WIDTH 40
+
+/**
+ * A batch of boards being analyzed, shared by every worker's callbacks.
+ */
+typedef struct AnalyzeBatch {
+  // Each board's measures, one slot per board
+  uint32_t *bbbv;
+  uint32_t *regions;
+  uint32_t *isolated;
+  AnalyzeResult *result;
+} AnalyzeBatch;
+
+/**
+ * One worker's solver, and its totals.
+ */
+typedef struct AnalyzeWorker {
+  Solver *solver;
+  unsigned long long guessing;
+  unsigned long long measured;
+} AnalyzeWorker;
+
+/**
+ * Makes a worker's solver, for the board it analyzes on.
+ *
+ * @param context the AnalyzeBatch
+ * @param state the worker's AnalyzeWorker
+ * @param board the worker's board
+ * @return true if the solver was made
+ */
+static bool start_worker(void *context, void *state, Board *board) {
+  (void) context;
+  AnalyzeWorker *worker = state;
+  worker -> solver = newSolver(board);
+  return worker -> solver != NULL;
+}
+
+/**
+ * Analyzes one board of the batch.
+ *
+ * @param context the AnalyzeBatch
+ * @param state the worker's AnalyzeWorker
+ * @param board the board, reset for its seed
+ * @param index the board's place in the batch
+ */
+static void run_board(void *context, void *state, Board *board,
+    unsigned long long index) {
+  AnalyzeBatch *batch = context;
+  AnalyzeWorker *worker = state;
+  // Open the way a game does, so boards waiting for their first pick get
+  // their mines, and their regions, before they're measured
+  board_expose_safe(board);
+  if ( board -> bbbv >= 0 ) {
+    batch -> bbbv[index] = board -> bbbv;
+    batch -> regions[index] = board -> regions;
+    batch -> isolated[index] = board -> bbbv - board -> regions;
+    worker -> measured++;
+  }
+  if ( !solver_clear(worker -> solver) ) {
+    worker -> guessing++;
+  }
+}
+
+/**
+ * Adds up a worker's totals, and frees its solver.
+ *
+ * @param context the AnalyzeBatch
+ * @param state the worker's AnalyzeWorker
+ * @param first the worker's first board
+ * @param count how many boards it analyzed
+ */
+static void finish_worker(void *context, void *state,
+    unsigned long long first, unsigned long long count) {
+  (void) first;
+  (void) count;
+  AnalyzeResult *result = ( (AnalyzeBatch *) context ) -> result;
+  AnalyzeWorker *worker = state;
+  result -> guessing += worker -> guessing;
+  result -> measured += worker -> measured;
+  solver_free(worker -> solver);
+}
+
+/**
+ * Works out how one measure spread out, by counting how many boards had each
+ * value. Measures only range as far as a board has tiles, so this takes one
+ * pass over the boards instead of a sort.
+ *
+ * @param values the measure for each board
+ * @param bbbv each board's 3BV, UNMEASURED for boards to leave out
+ * @param count how many boards there are
+ * @param measured how many of them have a measure, at least 1
+ * @param stat where to place the spread
+ * @return 0 if successful, else 1 if there isn't enough memory
+ */
+static int measure(const uint32_t *values, const uint32_t *bbbv,
+    unsigned long long count, unsigned long long measured, AnalyzeStat *stat) {
+  memset(stat, 0, sizeof(AnalyzeStat));
+  stat -> min = UINT32_MAX;
+  double sum = 0;
+  for ( unsigned long long i = 0; i < count; i++ ) {
+    if ( bbbv[i] != UNMEASURED ) {
+      stat -> min = values[i] < stat -> min ? values[i] : stat -> min;
+      stat -> max = values[i] > stat -> max ? values[i] : stat -> max;
+      sum += values[i];
+    }
+  }
+  stat -> mean = sum / measured;
+
+  // Count the boards with each value
+  size_t range = (size_t) ( stat -> max - stat -> min ) + 1;
+  unsigned long long *tally = calloc(range, sizeof(unsigned long long));
+  if ( !tally ) {
+    LOG_ERROR("Not enough memory to tally %zu values.", range);
+    return EXIT_FAILURE;
+  }
+  for ( unsigned long long i = 0; i < count; i++ ) {
+    if ( bbbv[i] != UNMEASURED ) {
+      tally[values[i] - stat -> min]++;
+    }
+  }
+
+  // Walk the tally once for every percentile and bar
+  static const double percents[] = { 10, 50, 90, 99 };
+  uint32_t *marks[] = { &stat -> p10, &stat -> p50, &stat -> p90,
+    &stat -> p99 };
+  int next = 0;
+  unsigned long long seen = 0;
+  stat -> bucket_width = range / ANALYZE_BUCKETS + 1;
+  for ( size_t v = 0; v < range; v++ ) {
+    seen += tally[v];
+    while ( next < 4 && seen > (unsigned long long)
+        ( percents[next] / 100 * ( measured - 1 ) + 0.5 ) ) {
+      *marks[next++] = stat -> min + v;
+    }
+    stat -> buckets[v / stat -> bucket_width] += tally[v];
+  }
+  free(tally);
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Generates a batch of boards, spread across worker threads, and measures
+ * each one: its 3BV, its regions of zeros and numbers next to none, and
+ * whether the solver needs a guess to clear it from the opening tile. Each
+ * worker takes one board from the pool and resets it for each seed, so no
+ * memory is allocated per board.
+ *
+ * @param config the boards to analyze
+ * @param result where to place what they looked like
+ * @return 0 if successful, else 1 if the workers couldn't be started or
+ *  couldn't get or set up boards, in which case only the boards analyzed are
+ *  counted
+ */
+int analyze_run(const AnalyzeConfig *config, AnalyzeResult *result) {
+  memset(result, 0, sizeof(AnalyzeResult));
+  size_t slot_count = 3 * ( config -> boards + 1 );
+  uint32_t *slots = malloc(sizeof(uint32_t) * slot_count);
+  if ( !slots ) {
+    LOG_ERROR("Not enough memory to analyze %llu boards.", config -> boards);
+    return EXIT_FAILURE;
+  }
+  // Boards that aren't measured, or whose worker never got a board, stay
+  // left out
+  for ( size_t i = 0; i < slot_count; i++ ) {
+    slots[i] = UNMEASURED;
+  }
+  AnalyzeBatch batch = { slots, slots + config -> boards + 1,
+    slots + 2 * ( config -> boards + 1 ), result };
+
+  LOG_DEBUG("Analyzing %llu boards...", config -> boards);
+  BatchConfig boards = { config -> width, config -> height, config -> mines,
+    config -> seed, config -> first_zero, config -> boards, config -> threads,
+    config -> pool, NULL, &batch, sizeof(AnalyzeWorker), start_worker,
+    run_board, finish_worker };
+  BatchResult run;
+  int status = batch_run(&boards, &run);
+  result -> boards = run.boards;
+  result -> threads = run.threads;
+  result -> seconds = run.seconds;
+
+  if ( result -> measured > 0 && ( measure(batch.bbbv, batch.bbbv,
+      config -> boards, result -> measured, &result -> bbbv) != EXIT_SUCCESS
+      || measure(batch.regions, batch.bbbv, config -> boards,
+      result -> measured, &result -> regions) != EXIT_SUCCESS
+      || measure(batch.isolated, batch.bbbv, config -> boards,
+      result -> measured, &result -> isolated) != EXIT_SUCCESS ) ) {
+    result -> measured = 0;
+    status = EXIT_FAILURE;
+  }
+
+  free(slots);
+  return status;
+}
+
+/**
+ * Prints the spread of one measure, and its histogram.
+ *
+ * @param name the measure's name, padded to line up
+ * @param stat the spread to print
+ * @param measured how many boards it covers
+ * @param out where to print it
+ */
+static void print_stat(const char *name, const AnalyzeStat *stat,
+    unsigned long long measured, FILE *out) {
+  fprintf(out, "  %s min %u, p10 %u, p50 %u, p90 %u, p99 %u, max %u,"
+      " mean %.2f\n", name, stat -> min, stat -> p10, stat -> p50, stat -> p90,
+      stat -> p99, stat -> max, stat -> mean);
+  unsigned long long tallest = 0;
+  for ( int b = 0; b < ANALYZE_BUCKETS; b++ ) {
+    tallest = stat -> buckets[b] > tallest ? stat -> buckets[b] : tallest;
+  }
+  for ( int b = 0; b < ANALYZE_BUCKETS; b++ ) {
+    uint32_t low = stat -> min + b * stat -> bucket_width;
+    if ( low > stat -> max ) {
+      break;
+    }
+    int bar = (int) ( stat -> buckets[b] * BAR_WIDTH / tallest );
+    fprintf(out, "    %7u-%-7u %-*.*s %llu (%.2f%%)\n", low,
+        low + stat -> bucket_width - 1, BAR_WIDTH, bar,
+        "########################################", stat -> buckets[b],
+        100.0 * stat -> buckets[b] / measured);
+  }
+}
+
+/**
+ * Prints a report of a batch of analyzed boards, with a histogram of each
+ * measure.
+ *
+ * @param config the boards that were analyzed
+ * @param result what they looked like
+ * @param out where to print the report
+ */
+void analyze_print(const AnalyzeConfig *config, const AnalyzeResult *result,
+    FILE *out) {
+  double boards = result -> boards > 0 ? result -> boards : 1;
+  fprintf(out, "Analyzed %llu boards: %dx%d with %lld mines, seeds %llu-%llu,"
+      " %d threads\n", result -> boards, config -> width, config -> height,
+      (long long) config -> mines, (unsigned long long) config -> seed,
+      (unsigned long long) ( config -> seed + config -> boards - 1 ),
+      result -> threads);
+  fprintf(out, "  Time:     %.3f s, %.0f boards/s\n", result -> seconds,
+      result -> seconds > 0 ? result -> boards / result -> seconds : 0);
+  fprintf(out, "  Guessing: %llu (%.2f%%) can't be solved from the opening"
+      " without a guess\n", result -> guessing,
+      100 * result -> guessing / boards);
+  if ( result -> measured == 0 ) {
+    fprintf(out, "  3BV:      not kept on boards over %lld tiles\n",
+        (long long) BOARD_REGION_TILES_MAX);
+    return;
+  }
+  print_stat("3BV:     ", &result -> bbbv, result -> measured, out);
+  print_stat("Regions: ", &result -> regions, result -> measured, out);
+  print_stat("Isolated:", &result -> isolated, result -> measured, out);
+}
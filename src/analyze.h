@@ -0,0 +1,96 @@
+#ifndef ANALYZE_H
+#define ANALYZE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "board.h"
+#include "pool.h"
+
+/** Bars in each histogram of an analysis report. */
+#define ANALYZE_BUCKETS 12
+
+/**
+ * Settings for a batch of boards to analyze. Board i is seeded with seed + i,
+ * like a simulated game, so results don't depend on how many threads
+ * analyze them.
+ */
+typedef struct AnalyzeConfig {
+  int width;
+  int height;
+  int64_t mines;
+  uint64_t seed;
+  // Whether the mines wait for the first tile exposed, so it's a blank
+  bool first_zero;
+  unsigned long long boards;
+  // Worker threads to analyze on, or 0 for one per core
+  int threads;
+  // Pool to take boards from and give them back to, or NULL for one just
+  // for this batch
+  BoardPool *pool;
+} AnalyzeConfig;
+
+/**
+ * How one measure spread out over a batch of boards, with its percentiles
+ * and a histogram of ANALYZE_BUCKETS bars of equal width from min up.
+ */
+typedef struct AnalyzeStat {
+  uint32_t min;
+  uint32_t max;
+  double mean;
+  uint32_t p10;
+  uint32_t p50;
+  uint32_t p90;
+  uint32_t p99;
+  // Values each bar covers, and how many boards fell in each
+  uint32_t bucket_width;
+  unsigned long long buckets[ANALYZE_BUCKETS];
+} AnalyzeStat;
+
+/**
+ * What a batch of boards looked like.
+ */
+typedef struct AnalyzeResult {
+  unsigned long long boards;
+  // Boards the solver couldn't clear from the opening without a guess
+  unsigned long long guessing;
+  // Boards with their 3BV worked out. Boards too big to keep their regions
+  // of zeros only count toward guessing.
+  unsigned long long measured;
+  int threads;
+  // Wall clock time for the whole batch
+  double seconds;
+  // Each board's 3BV, its regions of zeros, and its numbered tiles next to
+  // no zero, which each take a click of their own
+  AnalyzeStat bbbv;
+  AnalyzeStat regions;
+  AnalyzeStat isolated;
+} AnalyzeResult;
+
+/**
+ * Generates a batch of boards, spread across worker threads, and measures
+ * each one: its 3BV, its regions of zeros and numbers next to none, and
+ * whether the solver needs a guess to clear it from the opening tile. Each
+ * worker takes one board from the pool and resets it for each seed, so no
+ * memory is allocated per board.
+ *
+ * @param config the boards to analyze
+ * @param result where to place what they looked like
+ * @return 0 if successful, else 1 if the workers couldn't be started or
+ *  couldn't get or set up boards, in which case only the boards analyzed are
+ *  counted
+ */
+int analyze_run(const AnalyzeConfig *config, AnalyzeResult *result);
+
+/**
+ * Prints a report of a batch of analyzed boards, with a histogram of each
+ * measure.
+ *
+ * @param config the boards that were analyzed
+ * @param result what they looked like
+ * @param out where to print the report
+ */
+void analyze_print(const AnalyzeConfig *config, const AnalyzeResult *result,
+    FILE *out);
+
+#endif
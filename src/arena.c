@@ -0,0 +1,54 @@
+#include "arena.h"
+
+#include <stdlib.h>
+
+/**
+ * Allocates the block for an arena.
+ *
+ * @param arena the arena to set up
+ * @param size the number of bytes it holds
+ * @return 0 if successful, else 1 if there isn't enough memory
+ */
+int arena_init(Arena *arena, size_t size) {
+  arena -> base = malloc(size);
+  arena -> size = arena -> base ? size : 0;
+  arena -> used = 0;
+  return arena -> base ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * Carves an array out of an arena. Checks that count * size doesn't
+ * overflow.
+ *
+ * @param arena the arena to carve from
+ * @param count the number of elements
+ * @param size the size of each element
+ * @return the array, aligned to ARENA_ALIGN, or NULL if it doesn't fit
+ */
+void *arena_alloc(Arena *arena, size_t count, size_t size) {
+  if ( size != 0 && count > SIZE_MAX / size ) {
+    return NULL;
+  }
+  size_t bytes = arena_round(count * size);
+  if ( ( bytes == 0 && count * size != 0 )
+      || bytes > arena -> size - arena -> used ) {
+    return NULL;
+  }
+  void *block = arena -> base + arena -> used;
+  arena -> used += bytes;
+  return block;
+}
+
+/**
+ * Frees an arena's block, and everything carved out of it. The arena itself
+ * may live inside the block, so it isn't touched once the block is freed.
+ *
+ * @param arena the arena to release
+ */
+void arena_release(Arena *arena) {
+  unsigned char *base = arena -> base;
+  arena -> base = NULL;
+  arena -> size = 0;
+  arena -> used = 0;
+  free(base);
+}
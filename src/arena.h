@@ -0,0 +1,66 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Alignment of every block handed out by an arena. */
+#define ARENA_ALIGN 16
+
+/**
+ * A single block of memory that smaller blocks are carved out of, one after
+ * another. Nothing is freed on its own: the whole arena is released at once,
+ * so something made of many pieces costs one allocation and one free.
+ */
+typedef struct Arena {
+  // Start of the block, and how much of it there is
+  unsigned char *base;
+  size_t size;
+  // How much has been handed out so far
+  size_t used;
+} Arena;
+
+
+/**
+ * Rounds a size up to the arena's alignment, for working out how big an
+ * arena needs to be.
+ *
+ * @param bytes the size to round up
+ * @return the rounded size, or 0 if it would wrap around
+ */
+static inline size_t arena_round(size_t bytes) {
+  if ( bytes > SIZE_MAX - ( ARENA_ALIGN - 1 ) ) {
+    return 0;
+  }
+  return ( bytes + ARENA_ALIGN - 1 ) & ~(size_t) ( ARENA_ALIGN - 1 );
+}
+
+/**
+ * Allocates the block for an arena.
+ *
+ * @param arena the arena to set up
+ * @param size the number of bytes it holds
+ * @return 0 if successful, else 1 if there isn't enough memory
+ */
+int arena_init(Arena *arena, size_t size);
+
+/**
+ * Carves an array out of an arena. Checks that count * size doesn't
+ * overflow.
+ *
+ * @param arena the arena to carve from
+ * @param count the number of elements
+ * @param size the size of each element
+ * @return the array, aligned to ARENA_ALIGN, or NULL if it doesn't fit
+ */
+void *arena_alloc(Arena *arena, size_t count, size_t size);
+
+/**
+ * Frees an arena's block, and everything carved out of it. The arena itself
+ * may live inside the block, so it isn't touched once the block is freed.
+ *
+ * @param arena the arena to release
+ */
+void arena_release(Arena *arena);
+
+#endif
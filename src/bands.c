@@ -0,0 +1,166 @@
+#define _XOPEN_SOURCE 700
+
+#include "bands.h"
+#include "batch.h"
+#include "log.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Waits for jobs and runs this worker's band of each, until the pool stops.
+ *
+ * @param arg the BandWorker to run
+ * @return NULL
+ */
+static void *run_worker(void *arg) {
+  BandWorker *worker = arg;
+  BandPool *pool = worker -> pool;
+  unsigned long done_job = 0;
+  for ( ;; ) {
+    // Wait for a job newer than the last one done
+    pthread_mutex_lock(&pool -> lock);
+    while ( pool -> job == done_job && !pool -> stopping ) {
+      pthread_cond_wait(&pool -> wake, &pool -> lock);
+    }
+    if ( pool -> stopping ) {
+      pthread_mutex_unlock(&pool -> lock);
+      return NULL;
+    }
+    done_job = pool -> job;
+    BandWork work = pool -> work;
+    void *work_arg = pool -> arg;
+    int first;
+    int last;
+    bands_split(pool -> first, pool -> last, pool -> threads, worker -> band,
+        &first, &last);
+    pthread_mutex_unlock(&pool -> lock);
+
+    work(work_arg, worker -> band, first, last);
+
+    // The last band done wakes the caller
+    pthread_mutex_lock(&pool -> lock);
+    if ( --pool -> busy == 0 ) {
+      pthread_cond_signal(&pool -> done);
+    }
+    pthread_mutex_unlock(&pool -> lock);
+  }
+}
+
+/**
+ * Starts a pool's threads.
+ *
+ * @param pool the pool to set up
+ * @param threads bands to split each job into, or 0 for one per core
+ * @return 0 if successful, else 1 if not even the lock could be set up. If
+ *  some threads couldn't be started, the pool runs with fewer.
+ */
+int bands_init(BandPool *pool, int threads) {
+  memset(pool, 0, sizeof(BandPool));
+  threads = batch_threads(threads);
+  if ( pthread_mutex_init(&pool -> lock, NULL) != 0 ) {
+    LOG_ERROR("Couldn't set up the lock for a band pool.");
+    return EXIT_FAILURE;
+  }
+  pthread_cond_init(&pool -> wake, NULL);
+  pthread_cond_init(&pool -> done, NULL);
+
+  // The caller takes band 0, so it needs one thread fewer
+  pool -> threads = 1;
+  pool -> workers = threads > 1 ? calloc(threads - 1, sizeof(BandWorker))
+    : NULL;
+  if ( threads > 1 && !pool -> workers ) {
+    LOG_ERROR("Not enough memory for %d band threads, using 1.", threads);
+    return EXIT_SUCCESS;
+  }
+  for ( int band = 1; band < threads; band++ ) {
+    BandWorker *worker = &pool -> workers[band - 1];
+    worker -> pool = pool;
+    worker -> band = band;
+    if ( pthread_create(&worker -> thread, NULL, run_worker, worker) != 0 ) {
+      LOG_ERROR("Couldn't start band thread %d, using %d.", band,
+          pool -> threads);
+      break;
+    }
+    pool -> threads++;
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Works out which rows one band of a job covers.
+ *
+ * @param first the job's first row
+ * @param last one past the job's last row
+ * @param bands how many bands the job is split into
+ * @param band the band to work out, from 0
+ * @param band_first where to place the band's first row
+ * @param band_last where to place one past the band's last row
+ */
+void bands_split(int first, int last, int bands, int band, int *band_first,
+    int *band_last) {
+  int64_t rows = last - first;
+  *band_first = first + (int) ( rows * band / bands );
+  *band_last = first + (int) ( rows * ( band + 1 ) / bands );
+}
+
+/**
+ * Splits rows first up to last into one band per thread, runs work on every
+ * band at once, and waits for all of them.
+ *
+ * @param pool the pool to run on
+ * @param first the first row
+ * @param last one past the last row
+ * @param work the work to do on each band
+ * @param arg passed along to work
+ */
+void bands_run(BandPool *pool, int first, int last, BandWork work, void *arg) {
+  if ( pool -> threads == 1 ) {
+    work(arg, 0, first, last);
+    return;
+  }
+
+  // Hand out the job and take the first band
+  pthread_mutex_lock(&pool -> lock);
+  pool -> work = work;
+  pool -> arg = arg;
+  pool -> first = first;
+  pool -> last = last;
+  pool -> busy = pool -> threads - 1;
+  pool -> job++;
+  pthread_cond_broadcast(&pool -> wake);
+  pthread_mutex_unlock(&pool -> lock);
+
+  int band_first;
+  int band_last;
+  bands_split(first, last, pool -> threads, 0, &band_first, &band_last);
+  work(arg, 0, band_first, band_last);
+
+  // Wait for the rest
+  pthread_mutex_lock(&pool -> lock);
+  while ( pool -> busy > 0 ) {
+    pthread_cond_wait(&pool -> done, &pool -> lock);
+  }
+  pthread_mutex_unlock(&pool -> lock);
+}
+
+/**
+ * Stops a pool's threads and frees what it holds.
+ *
+ * @param pool the pool to free
+ */
+void bands_free(BandPool *pool) {
+  pthread_mutex_lock(&pool -> lock);
+  pool -> stopping = true;
+  pthread_cond_broadcast(&pool -> wake);
+  pthread_mutex_unlock(&pool -> lock);
+  for ( int band = 1; band < pool -> threads; band++ ) {
+    pthread_join(pool -> workers[band - 1].thread, NULL);
+  }
+  free(pool -> workers);
+  pool -> workers = NULL;
+  pthread_cond_destroy(&pool -> wake);
+  pthread_cond_destroy(&pool -> done);
+  pthread_mutex_destroy(&pool -> lock);
+}
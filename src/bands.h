@@ -0,0 +1,94 @@
+#ifndef BANDS_H
+#define BANDS_H
+
+#include <stdbool.h>
+#include <pthread.h>
+
+/**
+ * Work done on one band of rows: rows first up to but not including last.
+ * Bands never share a row, so work that only writes its own rows needs no
+ * locking.
+ */
+typedef void (*BandWork)(void *arg, int band, int first, int last);
+
+/**
+ * One thread waiting in a BandPool.
+ */
+typedef struct BandWorker {
+  struct BandPool *pool;
+  // Band this worker always takes, from 1; the caller takes band 0
+  int band;
+  pthread_t thread;
+} BandWorker;
+
+/**
+ * Threads that stay around between jobs, so splitting a board into bands of
+ * rows and working on them at once costs a wakeup instead of starting a
+ * thread per band. Each job splits its rows into one band per thread, and
+ * the thread that runs the job takes the first band itself.
+ */
+typedef struct BandPool {
+  // Bands per job, counting the caller's
+  int threads;
+  BandWorker *workers;
+  pthread_mutex_t lock;
+  // Signaled when a job starts or the pool stops, and when a job's last
+  // band is done
+  pthread_cond_t wake;
+  pthread_cond_t done;
+  // The job being run, and which one it is, so workers can tell a new job
+  // from the one they just finished
+  BandWork work;
+  void *arg;
+  int first;
+  int last;
+  unsigned long job;
+  // Bands of the job not done yet, not counting the caller's
+  int busy;
+  bool stopping;
+} BandPool;
+
+
+/**
+ * Starts a pool's threads.
+ *
+ * @param pool the pool to set up
+ * @param threads bands to split each job into, or 0 for one per core
+ * @return 0 if successful, else 1 if not even the lock could be set up. If
+ *  some threads couldn't be started, the pool runs with fewer.
+ */
+int bands_init(BandPool *pool, int threads);
+
+/**
+ * Works out which rows one band of a job covers.
+ *
+ * @param first the job's first row
+ * @param last one past the job's last row
+ * @param bands how many bands the job is split into
+ * @param band the band to work out, from 0
+ * @param band_first where to place the band's first row
+ * @param band_last where to place one past the band's last row
+ */
+void bands_split(int first, int last, int bands, int band, int *band_first,
+    int *band_last);
+
+/**
+ * Splits rows first up to last into one band per thread, runs work on every
+ * band at once, and waits for all of them.
+ *
+ * @param pool the pool to run on
+ * @param first the first row
+ * @param last one past the last row
+ * @param work the work to do on each band
+ * @param arg passed along to work
+ */
+void bands_run(BandPool *pool, int first, int last, BandWork work, void *arg);
+
+/**
+ * Stops a pool's threads and frees what it holds.
+ *
+ * @param pool the pool to free
+ */
+void bands_free(BandPool *pool);
+
+#endif
@@ -0,0 +1,215 @@
+#define _XOPEN_SOURCE 700
+
+#include "batch.h"
+#include "log.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+/**
+ * One worker's share of a batch: a contiguous run of boards, and the state
+ * the callbacks keep for them.
+ */
+typedef struct Worker {
+  pthread_t thread;
+  const BatchConfig *config;
+  // Pool to take the worker's board from
+  BoardPool *pool;
+  // First board to run, and how many
+  unsigned long long first;
+  unsigned long long count;
+  void *state;
+  // Whether the worker got a board and ran its boards
+  bool ran;
+} Worker;
+
+/**
+ * Works out how many threads to run on.
+ *
+ * @param threads threads asked for, or 0 or less for one per core
+ * @return the threads to run on, at least 1
+ */
+int batch_threads(int threads) {
+  if ( threads > 0 ) {
+    return threads;
+  }
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  return cores > 0 ? cores : 1;
+}
+
+/**
+ * @return nanoseconds on a clock that only moves forward
+ */
+uint64_t batch_now_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t) now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+/**
+ * Orders latencies from fastest to slowest, for qsort.
+ */
+static int compare_latency(const void *a, const void *b) {
+  uint64_t left = *(const uint64_t *) a;
+  uint64_t right = *(const uint64_t *) b;
+  return ( left > right ) - ( left < right );
+}
+
+/**
+ * Sorts latencies from fastest to slowest.
+ *
+ * @param latencies the latencies to sort
+ * @param count how many there are
+ */
+void batch_sort_latencies(uint64_t *latencies, unsigned long long count) {
+  qsort(latencies, count, sizeof(uint64_t), compare_latency);
+}
+
+/**
+ * Finds a percentile of sorted latencies.
+ *
+ * @param sorted the latencies, fastest first
+ * @param count how many latencies there are, at least 1
+ * @param percent the percentile to find, 0-100
+ * @return the latency at that percentile
+ */
+uint64_t batch_percentile(const uint64_t *sorted, unsigned long long count,
+    double percent) {
+  return sorted[(unsigned long long) ( percent / 100 * ( count - 1 ) + 0.5 )];
+}
+
+/**
+ * Runs a worker's share of the boards on one reused board.
+ *
+ * @param arg the Worker to run
+ * @return NULL
+ */
+static void *run_worker(void *arg) {
+  Worker *worker = arg;
+  const BatchConfig *config = worker -> config;
+  if ( worker -> count == 0 ) {
+    return NULL;
+  }
+
+  // Everything this worker needs is set up once, up front
+  Board *board = pool_take(worker -> pool, config -> width, config -> height,
+      config -> mines, config -> seed + worker -> first, config -> first_zero);
+  if ( !board ) {
+    LOG_ERROR("Couldn't make a %dx%d board for a batch.", config -> width,
+        config -> height);
+    return NULL;
+  }
+  if ( config -> start
+      && !config -> start(config -> context, worker -> state, board) ) {
+    pool_give(worker -> pool, board);
+    return NULL;
+  }
+
+  // Every board is reset inside its timing, the first too, though the pool
+  // already reset it, so every latency covers the same work
+  for ( unsigned long long i = 0; i < worker -> count; i++ ) {
+    unsigned long long index = worker -> first + i;
+    uint64_t start = batch_now_ns();
+    board_reset(board, config -> seed + index);
+    config -> run(config -> context, worker -> state, board, index);
+    if ( config -> latencies ) {
+      config -> latencies[index] = batch_now_ns() - start;
+    }
+  }
+
+  pool_give(worker -> pool, board);
+  worker -> ran = true;
+  return NULL;
+}
+
+/**
+ * Runs a batch of boards, spread across worker threads.
+ *
+ * @param config the boards to run, and what to run on them
+ * @param result where to place what it took
+ * @return 0 if successful, else 1 if the workers couldn't be started or
+ *  couldn't get or set up boards, in which case only the boards run are
+ *  counted
+ */
+int batch_run(const BatchConfig *config, BatchResult *result) {
+  memset(result, 0, sizeof(BatchResult));
+  int threads = batch_threads(config -> threads);
+  if ( (unsigned long long) threads > config -> boards ) {
+    threads = config -> boards > 0 ? config -> boards : 1;
+  }
+  result -> threads = threads;
+
+  // Without a pool to share, make one that holds every worker's board
+  BoardPool own_pool;
+  BoardPool *pool = config -> pool;
+  if ( !pool ) {
+    if ( pool_init(&own_pool, threads) != EXIT_SUCCESS ) {
+      return EXIT_FAILURE;
+    }
+    pool = &own_pool;
+  }
+
+  size_t state_size = config -> state_size > 0 ? config -> state_size : 1;
+  Worker *workers = calloc(threads, sizeof(Worker));
+  char *states = calloc(threads, state_size);
+  if ( !workers || !states ) {
+    LOG_ERROR("Not enough memory to run %llu boards.", config -> boards);
+    free(workers);
+    free(states);
+    if ( pool == &own_pool ) {
+      pool_free(pool);
+    }
+    return EXIT_FAILURE;
+  }
+
+  // Split the boards into one contiguous run per worker
+  LOG_DEBUG("Running %llu boards on %d threads...", config -> boards,
+      threads);
+  uint64_t start = batch_now_ns();
+  int started = 0;
+  unsigned long long first = 0;
+  for ( int t = 0; t < threads; t++ ) {
+    Worker *worker = &workers[t];
+    worker -> config = config;
+    worker -> pool = pool;
+    worker -> first = first;
+    worker -> count = config -> boards / threads
+      + ( (unsigned long long) t < config -> boards % threads );
+    worker -> state = states + state_size * t;
+    first += worker -> count;
+    if ( pthread_create(&worker -> thread, NULL, run_worker, worker) != 0 ) {
+      LOG_ERROR("Couldn't start batch thread %d.", t);
+      break;
+    }
+    started++;
+  }
+  for ( int t = 0; t < started; t++ ) {
+    pthread_join(workers[t].thread, NULL);
+  }
+  result -> seconds = ( batch_now_ns() - start ) / 1e9;
+
+  // Hand each worker that ran back to the caller to add up
+  bool failed = started < threads;
+  for ( int t = 0; t < started; t++ ) {
+    Worker *worker = &workers[t];
+    if ( !worker -> ran ) {
+      failed = failed || worker -> count > 0;
+      continue;
+    }
+    if ( config -> finish ) {
+      config -> finish(config -> context, worker -> state, worker -> first,
+          worker -> count);
+    }
+    result -> boards += worker -> count;
+  }
+
+  free(workers);
+  free(states);
+  if ( pool == &own_pool ) {
+    pool_free(pool);
+  }
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "board.h"
+#include "pool.h"
+
+/**
+ * A batch of boards to run something on, spread across worker threads. Board
+ * i is seeded with seed + i, and each worker runs one contiguous run of
+ * boards on one board from the pool, reset for each seed, so results don't
+ * depend on the thread count and no memory is allocated per board.
+ *
+ * Each worker gets state_size bytes of zeroed state of its own, which the
+ * callbacks share between the worker's boards.
+ */
+typedef struct BatchConfig {
+  int width;
+  int height;
+  int64_t mines;
+  uint64_t seed;
+  // Whether the mines wait for the first tile exposed, so it's a blank
+  bool first_zero;
+  unsigned long long boards;
+  // Worker threads to run on, or 0 for one per core
+  int threads;
+  // Pool to take boards from and give them back to, or NULL for one just
+  // for this batch
+  BoardPool *pool;
+  // Where to put how long each board took to reset and run, in nanoseconds,
+  // one slot per board, or NULL
+  uint64_t *latencies;
+  // Passed to every callback
+  void *context;
+  size_t state_size;
+  // Sets up a worker's state, on the worker's thread, once it has its board.
+  // Returns false if it couldn't, and the worker gives its board back and
+  // runs none of its boards. May be NULL.
+  bool (*start)(void *context, void *state, Board *board);
+  // Runs board index of the batch, reset for its seed
+  void (*run)(void *context, void *state, Board *board,
+      unsigned long long index);
+  // Adds up a worker's totals and frees what start made, on the caller's
+  // thread once every worker is done. Called for each worker that ran its
+  // boards, in order of their boards, with the run of boards it ran. May be
+  // NULL.
+  void (*finish)(void *context, void *state, unsigned long long first,
+      unsigned long long count);
+} BatchConfig;
+
+/**
+ * What running a batch took.
+ */
+typedef struct BatchResult {
+  // Boards run, leaving out any whose worker couldn't get a board
+  unsigned long long boards;
+  int threads;
+  // Wall clock time for the whole batch
+  double seconds;
+} BatchResult;
+
+
+/**
+ * Works out how many threads to run on.
+ *
+ * @param threads threads asked for, or 0 or less for one per core
+ * @return the threads to run on, at least 1
+ */
+int batch_threads(int threads);
+
+/**
+ * @return nanoseconds on a clock that only moves forward
+ */
+uint64_t batch_now_ns(void);
+
+/**
+ * Sorts latencies from fastest to slowest.
+ *
+ * @param latencies the latencies to sort
+ * @param count how many there are
+ */
+void batch_sort_latencies(uint64_t *latencies, unsigned long long count);
+
+/**
+ * Finds a percentile of sorted latencies.
+ *
+ * @param sorted the latencies, fastest first
+ * @param count how many latencies there are, at least 1
+ * @param percent the percentile to find, 0-100
+ * @return the latency at that percentile
+ */
+uint64_t batch_percentile(const uint64_t *sorted, unsigned long long count,
+    double percent);
+
+/**
+ * Runs a batch of boards, spread across worker threads.
+ *
+ * @param config the boards to run, and what to run on them
+ * @param result where to place what it took
+ * @return 0 if successful, else 1 if the workers couldn't be started or
+ *  couldn't get or set up boards, in which case only the boards run are
+ *  counted
+ */
+int batch_run(const BatchConfig *config, BatchResult *result);
+
+#endif
@@ -0,0 +1,613 @@
+#include "bitboard.h"
+#include "words.h"
+#include "log.h"
+
+#include <stdlib.h>
+#include <string.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/** Planes a bitboard holds: mines, exposed, flagged, and the count bits. */
+#define PLANES ( 3 + BITBOARD_COUNT_PLANES )
+
+/**
+ * Adds up eight one-bit inputs in every lane at once, bit-sliced: sum[0]
+ * gets the ones bit of each lane's total, sum[1] the twos, and so on up to
+ * eight. Full adders boil three inputs down to a sum and a carry, so the
+ * whole network is a couple dozen logic operations however wide the lanes
+ * are. AND, OR, and XOR are the operations for the lane type T, so plain
+ * words and vectors share it.
+ */
+#define BIT_SUM8(T, AND, OR, XOR, in, sum) do { \
+    T up_half = XOR(in[0], in[1]); \
+    T up_sum = XOR(up_half, in[2]); \
+    T up_carry = OR(AND(in[0], in[1]), AND(up_half, in[2])); \
+    T down_half = XOR(in[5], in[6]); \
+    T down_sum = XOR(down_half, in[7]); \
+    T down_carry = OR(AND(in[5], in[6]), AND(down_half, in[7])); \
+    T side_sum = XOR(in[3], in[4]); \
+    T side_carry = AND(in[3], in[4]); \
+    T ones_half = XOR(up_sum, down_sum); \
+    sum[0] = XOR(ones_half, side_sum); \
+    T ones_carry = OR(AND(up_sum, down_sum), AND(ones_half, side_sum)); \
+    T twos_half = XOR(up_carry, down_carry); \
+    T twos_sum = XOR(twos_half, side_carry); \
+    T twos_carry = OR(AND(up_carry, down_carry), AND(twos_half, side_carry)); \
+    sum[1] = XOR(twos_sum, ones_carry); \
+    T fours_carry = AND(twos_sum, ones_carry); \
+    sum[2] = XOR(twos_carry, fours_carry); \
+    sum[3] = AND(twos_carry, fours_carry); \
+  } while ( 0 )
+
+#define WORD_AND(a, b) ( ( a ) & ( b ) )
+#define WORD_OR(a, b) ( ( a ) | ( b ) )
+#define WORD_XOR(a, b) ( ( a ) ^ ( b ) )
+
+/**
+ * Spreads 8 bits out to the low bit of 8 bytes: bit i of the input becomes
+ * the low bit of byte i. Copies the bits into every byte, keeps bit i of
+ * byte i, and carries whatever is left up to the byte's top bit.
+ */
+#define SPREAD(bits) ( ( ( ( ( ( bits ) * BYTE_LOWS ) & 0x8040201008040201ULL ) \
+    + 0x7F7F7F7F7F7F7F7FULL ) >> 7 ) & BYTE_LOWS )
+#define SPREAD4(bits) SPREAD(bits), SPREAD(bits + 1), SPREAD(bits + 2), \
+  SPREAD(bits + 3)
+#define SPREAD16(bits) SPREAD4(bits), SPREAD4(bits + 4), SPREAD4(bits + 8), \
+  SPREAD4(bits + 12)
+#define SPREAD64(bits) SPREAD16(bits), SPREAD16(bits + 16), \
+  SPREAD16(bits + 32), SPREAD16(bits + 48)
+
+/** Every byte spread out by SPREAD, so a spread is one lookup. */
+static const uint64_t SPREAD_TABLE[256] = {
+  SPREAD64(0ULL), SPREAD64(64ULL), SPREAD64(128ULL), SPREAD64(192ULL)
+};
+
+/**
+ * Gathers the low bit of 8 bytes into 8 bits, the reverse of SPREAD.
+ *
+ * @param bytes a word with byte i either 0 or 1
+ * @return the bits, bit i from byte i
+ */
+static inline uint64_t gather_bits(uint64_t bytes) {
+  return ( bytes * 0x0102040810204080ULL ) >> 56;
+}
+
+/**
+ * Writes up to 8 tiles from a word, the low byte first.
+ *
+ * @param tiles where to write the tiles
+ * @param word the tiles
+ * @param count how many to write, 1-8
+ */
+static inline void store_tiles(Tile *tiles, uint64_t word, int count) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  // The low byte is already first in memory
+  if ( count == 8 ) {
+    memcpy(tiles, &word, sizeof(word));
+    return;
+  }
+#endif
+  for ( int i = 0; i < count; i++ ) {
+    tiles[i] = word >> ( 8 * i );
+  }
+}
+
+/**
+ * Works out how much memory a bitboard of a given size takes: a little under
+ * a byte per tile, for all seven planes.
+ *
+ * @param width the horizontal count of tiles across the board
+ * @param height the vertical count of tiles across the board
+ * @return the number of bytes, or 0 if the size is out of range or too big to
+ *  address
+ */
+size_t bitboard_bytes(int width, int height) {
+  if ( width < 1 || width > BOARD_SIDE_MAX || height < 1
+      || height > BOARD_SIDE_MAX ) {
+    return 0;
+  }
+  // Every plane has the border ring and padding, and the play mask one row
+  size_t row_words = ( (size_t) width + 2 + 63 ) / 64 + 2;
+  size_t rows = (size_t) height + 4;
+  if ( rows > SIZE_MAX / sizeof(uint64_t) / row_words / ( PLANES + 1 ) ) {
+    return 0;
+  }
+  return arena_round(sizeof(Bitboard))
+    + PLANES * arena_round(sizeof(uint64_t) * row_words * rows)
+    + arena_round(sizeof(uint64_t) * row_words);
+}
+
+/**
+ * Constructor for a Bitboard, with every plane clear.
+ *
+ * @param width the horizontal count of tiles across the board
+ * @param height the vertical count of tiles across the board
+ * @return the newly created Bitboard, or NULL if the size is out of range or
+ *  there isn't enough memory
+ */
+Bitboard *newBitboard(int width, int height) {
+  size_t bytes = bitboard_bytes(width, height);
+  if ( bytes == 0 ) {
+    LOG_ERROR("Can't make a %dx%d bitboard: sides must be from 1 to %d.",
+        width, height, BOARD_SIDE_MAX);
+    return NULL;
+  }
+  size_t words = ( (size_t) width + 2 + 63 ) / 64;
+  size_t row_words = words + 2;
+  size_t rows = (size_t) height + 4;
+
+  // Carve the struct and its planes out of one block
+  Arena arena;
+  if ( arena_init(&arena, bytes) != EXIT_SUCCESS ) {
+    LOG_ERROR("Not enough memory for a %dx%d bitboard, which needs %zu bytes.",
+        width, height, bytes);
+    return NULL;
+  }
+  Bitboard *bits = arena_alloc(&arena, 1, sizeof(Bitboard));
+  memset(bits, 0, sizeof(Bitboard));
+  bits -> arena = arena;
+  bits -> width = width;
+  bits -> height = height;
+  bits -> words = words;
+  bits -> row_words = row_words;
+  uint64_t **planes[PLANES] = { &bits -> mines, &bits -> exposed,
+    &bits -> flagged, &bits -> count[0], &bits -> count[1], &bits -> count[2],
+    &bits -> count[3] };
+  for ( int i = 0; i < PLANES; i++ ) {
+    *planes[i] = arena_alloc(&bits -> arena, row_words * rows,
+        sizeof(uint64_t));
+  }
+  bits -> play = arena_alloc(&bits -> arena, row_words, sizeof(uint64_t));
+
+  // Mark the tiles in play: bits 1 to width of each row
+  memset(bits -> play, 0, sizeof(uint64_t) * row_words);
+  uint64_t *play = bits -> play + 1;
+  for ( int x = 0; x < width; x++ ) {
+    play[( x + 1 ) / 64] |= (uint64_t) 1 << ( ( x + 1 ) % 64 );
+  }
+
+  bitboard_clear(bits);
+  for ( int i = 0; i < BITBOARD_COUNT_PLANES; i++ ) {
+    memset(bits -> count[i], 0, sizeof(uint64_t) * row_words * rows);
+  }
+  return bits;
+}
+
+/**
+ * Frees a Bitboard and everything it holds.
+ *
+ * @param bits the bitboard to free
+ */
+void bitboard_free(Bitboard *bits) {
+  arena_release(&bits -> arena);
+}
+
+/**
+ * Clears every plane: no mines, nothing exposed or flagged.
+ *
+ * @param bits the bitboard to clear
+ */
+void bitboard_clear(Bitboard *bits) {
+  size_t plane_words = bits -> row_words * ( (size_t) bits -> height + 4 );
+  memset(bits -> mines, 0, sizeof(uint64_t) * plane_words);
+  memset(bits -> exposed, 0, sizeof(uint64_t) * plane_words);
+  memset(bits -> flagged, 0, sizeof(uint64_t) * plane_words);
+}
+
+/**
+ * Places mines on a clear bitboard, drawing from a generator exactly the way
+ * a Board places them, so the same generator state puts them in the same
+ * spots.
+ *
+ * @param bits the bitboard to place mines on, with no mines yet
+ * @param rng the generator to draw from
+ * @param mineCount the number of mines, at most one per tile
+ */
+void bitboard_place_mines(Bitboard *bits, Rng *rng, int64_t mineCount) {
+  // Floyd's sampling, the same draws as place_mines in board.c
+  size_t len_play = (size_t) bits -> width * bits -> height;
+  for ( size_t j = len_play - mineCount; j < len_play; j++ ) {
+    size_t pick = rng_below(rng, j + 1);
+    int x = pick % bits -> width;
+    int y = pick / bits -> width;
+    if ( bitboard_test(bits, bits -> mines, x, y) ) {
+      x = j % bits -> width;
+      y = j / bits -> width;
+    }
+    bitboard_row(bits, bits -> mines, y)[( x + 1 ) / 64] |=
+      (uint64_t) 1 << ( ( x + 1 ) % 64 );
+  }
+}
+
+/**
+ * Counts the mines around one word of tiles.
+ *
+ * @param up the word in the row above
+ * @param mid the word itself
+ * @param down the word in the row below
+ * @param sum where to place the four bitplanes of the counts
+ */
+static inline void count_word(const uint64_t *up, const uint64_t *mid,
+    const uint64_t *down, uint64_t sum[BITBOARD_COUNT_PLANES]) {
+  // Shift each neighbor's bit over to the tile it's next to, carrying
+  // across words. The padding words make the ends read zeros.
+  uint64_t in[8] = {
+    up[0] << 1 | up[-1] >> 63, up[0], up[0] >> 1 | up[1] << 63,
+    mid[0] << 1 | mid[-1] >> 63, mid[0] >> 1 | mid[1] << 63,
+    down[0] << 1 | down[-1] >> 63, down[0], down[0] >> 1 | down[1] << 63,
+  };
+  BIT_SUM8(uint64_t, WORD_AND, WORD_OR, WORD_XOR, in, sum);
+}
+
+#if defined(__AVX2__)
+/** Loads 4 words from anywhere. */
+#define LANES_LOAD(p) _mm256_loadu_si256((const __m256i *) ( p ))
+/** Shifts 4 words' west neighbors onto them, carrying across words. */
+#define LANES_WEST(p) _mm256_or_si256(_mm256_slli_epi64(LANES_LOAD(p), 1), \
+    _mm256_srli_epi64(LANES_LOAD(( p ) - 1), 63))
+/** Shifts 4 words' east neighbors onto them, carrying across words. */
+#define LANES_EAST(p) _mm256_or_si256(_mm256_srli_epi64(LANES_LOAD(p), 1), \
+    _mm256_slli_epi64(LANES_LOAD(( p ) + 1), 63))
+
+/**
+ * Counts the mines around 4 words of tiles at once with AVX2, like
+ * count_word.
+ */
+static inline void count_lanes(const uint64_t *up, const uint64_t *mid,
+    const uint64_t *down, uint64_t *out[BITBOARD_COUNT_PLANES]) {
+  __m256i in[8] = {
+    LANES_WEST(up), LANES_LOAD(up), LANES_EAST(up),
+    LANES_WEST(mid), LANES_EAST(mid),
+    LANES_WEST(down), LANES_LOAD(down), LANES_EAST(down),
+  };
+  __m256i sum[BITBOARD_COUNT_PLANES];
+  BIT_SUM8(__m256i, _mm256_and_si256, _mm256_or_si256, _mm256_xor_si256, in,
+      sum);
+  for ( int i = 0; i < BITBOARD_COUNT_PLANES; i++ ) {
+    _mm256_storeu_si256((__m256i *) out[i], sum[i]);
+  }
+}
+#define LANE_WORDS 4
+#elif defined(__SSE2__)
+/** Loads 2 words from anywhere. */
+#define LANES_LOAD(p) _mm_loadu_si128((const __m128i *) ( p ))
+/** Shifts 2 words' west neighbors onto them, carrying across words. */
+#define LANES_WEST(p) _mm_or_si128(_mm_slli_epi64(LANES_LOAD(p), 1), \
+    _mm_srli_epi64(LANES_LOAD(( p ) - 1), 63))
+/** Shifts 2 words' east neighbors onto them, carrying across words. */
+#define LANES_EAST(p) _mm_or_si128(_mm_srli_epi64(LANES_LOAD(p), 1), \
+    _mm_slli_epi64(LANES_LOAD(( p ) + 1), 63))
+
+/**
+ * Counts the mines around 2 words of tiles at once with SSE2, like
+ * count_word.
+ */
+static inline void count_lanes(const uint64_t *up, const uint64_t *mid,
+    const uint64_t *down, uint64_t *out[BITBOARD_COUNT_PLANES]) {
+  __m128i in[8] = {
+    LANES_WEST(up), LANES_LOAD(up), LANES_EAST(up),
+    LANES_WEST(mid), LANES_EAST(mid),
+    LANES_WEST(down), LANES_LOAD(down), LANES_EAST(down),
+  };
+  __m128i sum[BITBOARD_COUNT_PLANES];
+  BIT_SUM8(__m128i, _mm_and_si128, _mm_or_si128, _mm_xor_si128, in, sum);
+  for ( int i = 0; i < BITBOARD_COUNT_PLANES; i++ ) {
+    _mm_storeu_si128((__m128i *) out[i], sum[i]);
+  }
+}
+#define LANE_WORDS 2
+#endif
+
+/**
+ * Works out every tile's count of nearby bombs from the mines plane, a
+ * word at a time, border ring included.
+ *
+ * @param bits the bitboard to count
+ */
+void bitboard_count(Bitboard *bits) {
+  bitboard_count_rows(bits, -1, bits -> height + 1);
+}
+
+/**
+ * Works out the counts for a run of rows only, leaving the rest alone. Rows
+ * only read the mines next to them, so runs that don't overlap can be
+ * counted at the same time.
+ *
+ * @param bits the bitboard to count
+ * @param first the first row to count, from -1 for the top border
+ * @param last one past the last row to count, at most height + 1
+ */
+void bitboard_count_rows(Bitboard *bits, int first, int last) {
+  size_t words = bits -> words;
+  for ( int y = first; y < last; y++ ) {
+    const uint64_t *up = bitboard_row(bits, bits -> mines, y - 1);
+    const uint64_t *mid = bitboard_row(bits, bits -> mines, y);
+    const uint64_t *down = bitboard_row(bits, bits -> mines, y + 1);
+    uint64_t *out[BITBOARD_COUNT_PLANES];
+    for ( int i = 0; i < BITBOARD_COUNT_PLANES; i++ ) {
+      out[i] = bitboard_row(bits, bits -> count[i], y);
+    }
+
+    // As many words at a time as the vector unit holds, then the rest one
+    // by one
+    size_t w = 0;
+#if defined(LANE_WORDS)
+    for ( ; w + LANE_WORDS <= words; w += LANE_WORDS ) {
+      uint64_t *lanes_out[BITBOARD_COUNT_PLANES] = {
+        out[0] + w, out[1] + w, out[2] + w, out[3] + w };
+      count_lanes(up + w, mid + w, down + w, lanes_out);
+    }
+#endif
+    for ( ; w < words; w++ ) {
+      uint64_t sum[BITBOARD_COUNT_PLANES];
+      count_word(up + w, mid + w, down + w, sum);
+      for ( int i = 0; i < BITBOARD_COUNT_PLANES; i++ ) {
+        out[i][w] = sum[i];
+      }
+    }
+  }
+}
+
+/**
+ * Reads the mines, exposed tiles, and flags from a Board of the same size.
+ * Counts aren't read; use bitboard_count to work them out.
+ *
+ * @param bits the bitboard to fill
+ * @param board the board to read
+ */
+void bitboard_from_board(Bitboard *bits, const Board *board) {
+  if ( bits -> width != board -> width || bits -> height != board -> height ) {
+    LOG_ERROR("Can't read a %dx%d board into a %dx%d bitboard.",
+        board -> width, board -> height, bits -> width, bits -> height);
+    return;
+  }
+  int stride = board -> stride;
+  const uint64_t *play = bits -> play + 1;
+  for ( int y = 0; y < board -> height; y++ ) {
+    const Tile *tiles = board -> cells + (size_t) ( y + 1 ) * stride;
+    uint64_t *mines = bitboard_row(bits, bits -> mines, y);
+    uint64_t *exposed = bitboard_row(bits, bits -> exposed, y);
+    uint64_t *flagged = bitboard_row(bits, bits -> flagged, y);
+
+    // Gather each bit from 8 tiles at a time. The border tiles' bits are
+    // masked off after, since they're exposed but not in play.
+    for ( size_t w = 0; w < bits -> words; w++ ) {
+      uint64_t mine_word = 0;
+      uint64_t exposed_word = 0;
+      uint64_t flagged_word = 0;
+      for ( int shift = 0; shift < 64; shift += 8 ) {
+        int x = (int) ( w * 64 ) + shift;
+        if ( x >= stride ) {
+          break;
+        }
+        int count = stride - x < 8 ? stride - x : 8;
+        uint64_t word = load_tiles(tiles + x, count, 0);
+        mine_word |= gather_bits(( word >> 4 ) & BYTE_LOWS) << shift;
+        exposed_word |= gather_bits(( word >> 5 ) & BYTE_LOWS) << shift;
+        flagged_word |= gather_bits(( word >> 6 ) & BYTE_LOWS) << shift;
+      }
+      mines[w] = mine_word & play[w];
+      exposed[w] = exposed_word & play[w];
+      flagged[w] = flagged_word & play[w];
+    }
+  }
+}
+
+/**
+ * Writes a run of a Board's rows from a counted bitboard of the same size.
+ *
+ * @param bits the bitboard to read, with those rows' counts worked out
+ * @param board the board to write
+ * @param first the first row to write, from -1 for the top border
+ * @param last one past the last row to write, at most height + 1
+ * @return the number of mines in the rows
+ */
+static int64_t write_rows(const Bitboard *bits, Board *board, int first,
+    int last) {
+  int stride = board -> stride;
+  int64_t mines = 0;
+  for ( int y = first; y < last; y++ ) {
+    Tile *tiles = board -> cells + (size_t) ( y + 1 ) * stride;
+    const uint64_t *planes[PLANES] = {
+      bitboard_row(bits, bits -> count[0], y),
+      bitboard_row(bits, bits -> count[1], y),
+      bitboard_row(bits, bits -> count[2], y),
+      bitboard_row(bits, bits -> count[3], y),
+      bitboard_row(bits, bits -> mines, y),
+      bitboard_row(bits, bits -> exposed, y),
+      bitboard_row(bits, bits -> flagged, y),
+    };
+
+    // Spread each plane's bits out to 8 tiles at a time. The planes are in
+    // the order of the tile's bits, count first, so plane i lands on bit i.
+    for ( size_t w = 0; w < bits -> words; w++ ) {
+      uint64_t plane_words[PLANES];
+      for ( int i = 0; i < PLANES; i++ ) {
+        plane_words[i] = planes[i][w];
+      }
+      mines += bit_count(plane_words[4]);
+      int left = stride - (int) ( w * 64 );
+      for ( int shift = 0; shift < 64 && shift < left; shift += 8 ) {
+        uint64_t word = 0;
+        for ( int i = 0; i < PLANES; i++ ) {
+          word |= SPREAD_TABLE[( plane_words[i] >> shift ) & 0xFF] << i;
+        }
+        Tile *to = tiles + w * 64 + shift;
+        if ( left - shift >= 8 ) {
+          store_tiles(to, word, 8);
+        } else {
+          store_tiles(to, word, left - shift);
+        }
+      }
+    }
+
+    // The border ring looks exposed, and is marked as the border
+    if ( y < 0 || y == bits -> height ) {
+      for ( int x = 0; x < stride; x++ ) {
+        tiles[x] |= TILE_BORDER | TILE_EXPOSED;
+      }
+    } else {
+      tiles[0] |= TILE_BORDER | TILE_EXPOSED;
+      tiles[stride - 1] |= TILE_BORDER | TILE_EXPOSED;
+    }
+  }
+  return mines;
+}
+
+/**
+ * Writes every tile of a Board of the same size from a counted bitboard,
+ * border ring included, then recounts the board so it's ready to play.
+ *
+ * @param bits the bitboard to read, with its counts worked out
+ * @param board the board to write
+ */
+void bitboard_to_board(const Bitboard *bits, Board *board) {
+  if ( bits -> width != board -> width || bits -> height != board -> height ) {
+    LOG_ERROR("Can't write a %dx%d bitboard to a %dx%d board.",
+        bits -> width, bits -> height, board -> width, board -> height);
+    return;
+  }
+  board -> mineCount = write_rows(bits, board, -1, bits -> height + 1);
+  board -> changes_overflow = true;
+  board_recount(board);
+}
+
+/**
+ * A parallel reset in progress: what every band works on.
+ */
+typedef struct BandReset {
+  Bitboard *bits;
+  Board *board;
+  // One tally per band, for board_recount_join
+  RecountBand *recounts;
+} BandReset;
+
+/**
+ * Counts a band's rows on the bitboard and writes them to the board. Reads
+ * the mines in the rows just outside the band, which nothing writes.
+ */
+static void count_band(void *arg, int band, int first, int last) {
+  BandReset *reset = arg;
+  (void) band;
+  bitboard_count_rows(reset -> bits, first, last);
+  write_rows(reset -> bits, reset -> board, first, last);
+}
+
+/**
+ * Recounts a band of the board's rows, once every row's tiles are written.
+ */
+static void recount_band(void *arg, int band, int first, int last) {
+  BandReset *reset = arg;
+  board_recount_rows(reset -> board, first, last, &reset -> recounts[band]);
+}
+
+/**
+ * Starts a new game on a board like board_reset does, with the mines placed
+ * and counted on a bitboard of the same size. The board comes out exactly as
+ * board_reset would leave it. Boards waiting to place their mines on the
+ * first pick are just reset.
+ *
+ * Given a pool, the counting, writing, and recounting are split into bands of
+ * rows run at once. The mines are still placed one after another, since each
+ * draw depends on the last.
+ *
+ * @param bits the bitboard to work on, overwritten
+ * @param board the board to reset
+ * @param seed the seed for placing mines
+ * @param pool threads to split the work across, or NULL to do it all here
+ */
+void bitboard_reset_board(Bitboard *bits, Board *board, uint64_t seed,
+    BandPool *pool) {
+  if ( ( board -> first_zero && board -> mineCount > 0 )
+      || bits -> width != board -> width || bits -> height != board -> height ) {
+    board_reset(board, seed);
+    return;
+  }
+  board -> cur_x = 0;
+  board -> cur_y = 0;
+  board -> seed = seed;
+  board -> mines_pending = false;
+  rng_seed(&board -> rng, seed);
+  board_changes_clear(board);
+
+  bitboard_clear(bits);
+  LOG_DEBUG("Assigning mines on a bitboard with seed %llu...",
+      (unsigned long long) seed);
+  bitboard_place_mines(bits, &board -> rng, board -> mineCount);
+  RecountBand *recounts = pool && pool -> threads > 1
+    ? malloc(sizeof(RecountBand) * pool -> threads) : NULL;
+  if ( !recounts ) {
+    bitboard_count(bits);
+    bitboard_to_board(bits, board);
+    board_changes_clear(board);
+    return;
+  }
+
+  // Count and write the tiles, then recount the board once every row is
+  // there, then pick the start from every band's tallies
+  BandReset reset = { bits, board, recounts };
+  bands_run(pool, -1, bits -> height + 1, count_band, &reset);
+  bands_run(pool, 0, bits -> height, recount_band, &reset);
+  board_recount_join(board, recounts, pool -> threads);
+  free(recounts);
+}
+
+/**
+ * Exposes every tile in play, like board_expose_all.
+ *
+ * @param bits the bitboard to expose
+ */
+void bitboard_expose_all(Bitboard *bits) {
+  const uint64_t *play = bits -> play + 1;
+  for ( int y = 0; y < bits -> height; y++ ) {
+    uint64_t *exposed = bitboard_row(bits, bits -> exposed, y);
+    for ( size_t w = 0; w < bits -> words; w++ ) {
+      exposed[w] |= play[w];
+    }
+  }
+}
+
+/**
+ * Tells whether a game is won: every tile without a mine is exposed.
+ *
+ * @param bits the bitboard to check
+ * @return true if there's no hidden safe tile left
+ */
+bool bitboard_won(const Bitboard *bits) {
+  const uint64_t *play = bits -> play + 1;
+  for ( int y = 0; y < bits -> height; y++ ) {
+    const uint64_t *mines = bitboard_row(bits, bits -> mines, y);
+    const uint64_t *exposed = bitboard_row(bits, bits -> exposed, y);
+    for ( size_t w = 0; w < bits -> words; w++ ) {
+      if ( play[w] & ~mines[w] & ~exposed[w] ) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Counts the mines, exposed tiles, and flags, and how many flags are right.
+ *
+ * @param bits the bitboard to count
+ * @param census where to place the totals
+ */
+void bitboard_census(const Bitboard *bits, BitboardCensus *census) {
+  memset(census, 0, sizeof(BitboardCensus));
+  for ( int y = 0; y < bits -> height; y++ ) {
+    const uint64_t *mines = bitboard_row(bits, bits -> mines, y);
+    const uint64_t *exposed = bitboard_row(bits, bits -> exposed, y);
+    const uint64_t *flagged = bitboard_row(bits, bits -> flagged, y);
+    for ( size_t w = 0; w < bits -> words; w++ ) {
+      census -> mines += bit_count(mines[w]);
+      census -> exposed += bit_count(exposed[w]);
+      census -> flagged += bit_count(flagged[w]);
+      census -> flags_right += bit_count(flagged[w] & mines[w]);
+    }
+  }
+  census -> flags_wrong = census -> flagged - census -> flags_right;
+}
@@ -0,0 +1,211 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "board.h"
+#include "rng.h"
+#include "arena.h"
+#include "bands.h"
+
+/** Number of bitplanes holding each tile's count of nearby bombs, 0-8. */
+#define BITBOARD_COUNT_PLANES 4
+
+/**
+ * A board stored as bitplanes, one bit per tile per plane: mines, exposed
+ * tiles, flags, and the four bits of each tile's nearby bomb count. Whole
+ * rows are worked on 64 tiles at a time, or more with SSE2 or AVX2, so
+ * counting every tile's neighbors, exposing everything, or checking for a win
+ * takes a few instructions per word instead of a loop per tile.
+ *
+ * Rows are laid out like a Board's cells: row y covers x from -1 to width,
+ * with bit x + 1 for tile x, so the border ring has bits too and counts come
+ * out for it just as a Board keeps them. Each row also has a word of zeros on
+ * either side, and each plane a row of zeros above and below, so neighbors
+ * never need bounds checks.
+ */
+typedef struct Bitboard {
+  int width;
+  int height;
+  // Words holding one row, and words from one row to the next, counting the
+  // words of padding on either side
+  size_t words;
+  size_t row_words;
+  uint64_t *mines;
+  uint64_t *exposed;
+  uint64_t *flagged;
+  // Bit i of each tile's count, filled in by bitboard_count
+  uint64_t *count[BITBOARD_COUNT_PLANES];
+  // One row with the bits of tiles in play set, leaving out the border
+  uint64_t *play;
+  // Block everything above was carved out of
+  Arena arena;
+} Bitboard;
+
+/**
+ * Totals of a bitboard's tiles, from bitboard_census.
+ */
+typedef struct BitboardCensus {
+  int64_t mines;
+  int64_t exposed;
+  int64_t flagged;
+  // Flags on mines, and flags on safe tiles
+  int64_t flags_right;
+  int64_t flags_wrong;
+} BitboardCensus;
+
+
+/**
+ * Gets a row of one of a bitboard's planes.
+ *
+ * @param bits the bitboard the plane belongs to
+ * @param plane the plane, like bits -> mines
+ * @param y the row, from -1 for the top border to height for the bottom one
+ * @return the row's first word, holding tiles x = -1 to 62
+ */
+static inline uint64_t *bitboard_row(const Bitboard *bits, uint64_t *plane,
+    int y) {
+  return plane + (size_t) ( y + 2 ) * bits -> row_words + 1;
+}
+
+/**
+ * Tells whether a tile's bit is set in one of a bitboard's planes.
+ *
+ * @param bits the bitboard the plane belongs to
+ * @param plane the plane, like bits -> mines
+ * @param x the x position of the tile
+ * @param y the y position of the tile
+ * @return true if the tile's bit is set
+ */
+static inline bool bitboard_test(const Bitboard *bits, uint64_t *plane, int x,
+    int y) {
+  const uint64_t *row = bitboard_row(bits, plane, y);
+  return ( row[( x + 1 ) / 64] >> ( ( x + 1 ) % 64 ) ) & 1;
+}
+
+/**
+ * Works out how much memory a bitboard of a given size takes: a little under
+ * a byte per tile, for all seven planes.
+ *
+ * @param width the horizontal count of tiles across the board
+ * @param height the vertical count of tiles across the board
+ * @return the number of bytes, or 0 if the size is out of range or too big to
+ *  address
+ */
+size_t bitboard_bytes(int width, int height);
+
+/**
+ * Constructor for a Bitboard, with every plane clear.
+ *
+ * @param width the horizontal count of tiles across the board
+ * @param height the vertical count of tiles across the board
+ * @return the newly created Bitboard, or NULL if the size is out of range or
+ *  there isn't enough memory
+ */
+Bitboard *newBitboard(int width, int height);
+
+/**
+ * Frees a Bitboard and everything it holds.
+ *
+ * @param bits the bitboard to free
+ */
+void bitboard_free(Bitboard *bits);
+
+/**
+ * Clears every plane: no mines, nothing exposed or flagged.
+ *
+ * @param bits the bitboard to clear
+ */
+void bitboard_clear(Bitboard *bits);
+
+/**
+ * Places mines on a clear bitboard, drawing from a generator exactly the way
+ * a Board places them, so the same generator state puts them in the same
+ * spots.
+ *
+ * @param bits the bitboard to place mines on, with no mines yet
+ * @param rng the generator to draw from
+ * @param mineCount the number of mines, at most one per tile
+ */
+void bitboard_place_mines(Bitboard *bits, Rng *rng, int64_t mineCount);
+
+/**
+ * Works out every tile's count of nearby bombs from the mines plane, a
+ * word at a time, border ring included.
+ *
+ * @param bits the bitboard to count
+ */
+void bitboard_count(Bitboard *bits);
+
+/**
+ * Works out the counts for a run of rows only, leaving the rest alone. Rows
+ * only read the mines next to them, so runs that don't overlap can be
+ * counted at the same time.
+ *
+ * @param bits the bitboard to count
+ * @param first the first row to count, from -1 for the top border
+ * @param last one past the last row to count, at most height + 1
+ */
+void bitboard_count_rows(Bitboard *bits, int first, int last);
+
+/**
+ * Reads the mines, exposed tiles, and flags from a Board of the same size.
+ * Counts aren't read; use bitboard_count to work them out.
+ *
+ * @param bits the bitboard to fill
+ * @param board the board to read
+ */
+void bitboard_from_board(Bitboard *bits, const Board *board);
+
+/**
+ * Writes every tile of a Board of the same size from a counted bitboard,
+ * border ring included, then recounts the board so it's ready to play.
+ *
+ * @param bits the bitboard to read, with its counts worked out
+ * @param board the board to write
+ */
+void bitboard_to_board(const Bitboard *bits, Board *board);
+
+/**
+ * Starts a new game on a board like board_reset does, with the mines placed
+ * and counted on a bitboard of the same size. The board comes out exactly as
+ * board_reset would leave it. Boards waiting to place their mines on the
+ * first pick are just reset.
+ *
+ * Given a pool, the counting, writing, and recounting are split into bands of
+ * rows run at once. The mines are still placed one after another, since each
+ * draw depends on the last.
+ *
+ * @param bits the bitboard to work on, overwritten
+ * @param board the board to reset
+ * @param seed the seed for placing mines
+ * @param pool threads to split the work across, or NULL to do it all here
+ */
+void bitboard_reset_board(Bitboard *bits, Board *board, uint64_t seed,
+    BandPool *pool);
+
+/**
+ * Exposes every tile in play, like board_expose_all.
+ *
+ * @param bits the bitboard to expose
+ */
+void bitboard_expose_all(Bitboard *bits);
+
+/**
+ * Tells whether a game is won: every tile without a mine is exposed.
+ *
+ * @param bits the bitboard to check
+ * @return true if there's no hidden safe tile left
+ */
+bool bitboard_won(const Bitboard *bits);
+
+/**
+ * Counts the mines, exposed tiles, and flags, and how many flags are right.
+ *
+ * @param bits the bitboard to count
+ * @param census where to place the totals
+ */
+void bitboard_census(const Bitboard *bits, BitboardCensus *census);
+
+#endif
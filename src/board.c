@@ -1,58 +1,25 @@
 #include "board.h"
+#include "words.h"
+#include "log.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 #include <stdbool.h>
+#include <ctype.h>
+#include <string.h>
 
 /**
  * Minesweeper board data, containing board size, board contents, and mine
  * count.
  */
 
-///** Resets all color / format settings. */
-//#define COLOR_NC "\033[0m"
-///** Fades the foreground color when printed. */
-//#define COLOR_FADE "\033[2m"
-///** Underlines the foreground when printed. */
-//#define COLOR_UNDERLINE "\033[4m"
-///** Inverts the background and foreground colors when printed. */
-//#define COLOR_INV "\033[7m"
-
-/** Format code for clearing all formatting. */
-#define FMT_NONE 0
-/** Format code for dimming. */
-#define FMT_DIM 2
-/** Format code for underlining. */
-#define FMT_UND 4
-/** Format for inverting foreground and background colors. */
-#define FMT_INV 7
-/** Color code for red */
-#define COLOR_RED 31 // To be used for 5's as "Maroon"
-/** Color code for green */
-#define COLOR_GREEN 33
-/** Color code for blue */
-#define COLOR_BLUE 34
-/** Color code for magenta */
-#define COLOR_MAGENTA 35
-/** Color code for cyan */
-#define COLOR_CYAN 36
-/** Color code for light gray */
-#define COLOR_L_GRAY 37
-/** Color code for background red */
-#define COLOR_BG_RED 41
-/** Color code for dark gray */
-#define COLOR_D_GRAY 90
-/** Color code for light red */
-#define COLOR_L_RED 91
-/** Color code for light green */
-#define COLOR_L_GREEN 92
-/** Color code for light yellow */
-#define COLOR_L_YELLOW 93
-/** Color code for whilte */
-#define COLOR_WHITE 97
-/** Color code for background as light red */
-#define COLOR_BG_L_RED 101
+/**
+ * Smallest number of entries in a board's fill queue. The queue holds the
+ * edge of a region being exposed, so it only needs to grow with the board's
+ * perimeter, not its area.
+ */
+#define FILL_QUEUE_MIN 4096
 
 /**
  * Checks the submitted bounds.
@@ -64,7 +31,7 @@
  * @param y the y position to check
  * @return 0 if OK, else ERR_OUT_OF_BOUNDS.
  */
-static int check_bounds(Board *board, short x, short y) {
+static int check_bounds(Board *board, int x, int y) {
   if ( x < 0 || x >= board -> width || y < 0 || y >= board -> height ) {
     return ERR_OUT_OF_BOUNDS;
   }
@@ -72,95 +39,159 @@ static int check_bounds(Board *board, short x, short y) {
 }
 
 /**
- * Finds the list of nearby tiles on the board within a distance of 1 (including
- * diagonals).
- * Won't return out of bounds tiles, or the same tile as passed in.
- * Tiles are placed in the provided array. Any array positions not used up to
- * index 7 are set to NULL.
+ * Marks a blank tile as exposed, and updates the counts of nearby blanks
+ * around it.
  *
- * @param board the board of tiles to search through
- * @param x the x position to get nearby tiles around
- * @param y the y position to get nearby tiles around
- * @param nearby a provided array to place found tiles into
+ * @param board the board the tile is on
+ * @param index the index of a tile that is neither exposed nor flagged
  */
-static void list_nearby(Board *board, short x, short y, Tile *nearby[8]) {
-  // Loop over nearby tiles
-  short tile_idx = 0;
-  for ( int offset_y = -1; offset_y <= 1; offset_y++ ) {
-    for ( int offset_x = -1; offset_x <= 1; offset_x++ ) {
-      // If we're on the bomb tile itself, skip it
-      if ( offset_x == 0 && offset_y == 0 ) {
-        continue;
-      }
+static inline void mark_exposed(Board *board, size_t index) {
+  board -> cells[index] |= TILE_EXPOSED;
+  board -> exposed++;
+  board_note_change(board, index);
+  unsigned char *around = board -> around + index;
+  for ( int i = 0; i < 8; i++ ) {
+    around[board -> nearby[i]]--;
+  }
+}
 
-      // Save the nearby absolute position
-      size_t near_y = y + offset_y;
-      size_t near_x = x + offset_x;
+/**
+ * Finds the spot a mine goes in from its place among the spots allowed to
+ * have mines, stepping over the ones that aren't.
+ *
+ * @param board the board the mine goes on
+ * @param place the mine's place among the allowed spots
+ * @param avoid the spots without mines, as y * width + x, in increasing order
+ * @param avoid_count the number of spots without mines
+ * @return the tile the mine goes in
+ */
+static inline Tile *mine_spot(Board *board, size_t place, const size_t *avoid,
+    int avoid_count) {
+  for ( int i = 0; i < avoid_count && place >= avoid[i]; i++ ) {
+    place++;
+  }
+  return board_tile(board, place % board -> width, place / board -> width);
+}
 
-      // If this tile is out of bounds, skip it
-      if ( near_y < 0 || near_y >= board -> height ||
-          near_x < 0 || near_x >= board -> width) {
-        continue;
-      }
+/**
+ * Places the board's mines, and counts them into their neighbors. Uses
+ * Floyd's sampling: for each of the last mineCount positions j, pick a random
+ * position up to j, falling back to j itself if that one's already mined.
+ * Every arrangement of mines is equally likely, and it takes exactly
+ * mineCount random picks no matter how dense the board is.
+ *
+ * @param board the board to place mines on, with no mines yet
+ * @param avoid spots to keep clear of mines, as y * width + x, in increasing
+ *  order
+ * @param avoid_count the number of spots to keep clear, leaving room for
+ *  every mine
+ */
+static void place_mines(Board *board, const size_t *avoid, int avoid_count) {
+  size_t len_play = (size_t) board -> width * board -> height - avoid_count;
+  for ( size_t j = len_play - board -> mineCount; j < len_play; j++ ) {
 
-      // Add this tile into the list of nearby tiles
-      nearby[tile_idx++] = board -> board[near_y][near_x];
+    // Pick a random spot to mine, or j if that spot is taken
+    size_t pick = rng_below(&board -> rng, j + 1);
+    Tile *rand_tile = mine_spot(board, pick, avoid, avoid_count);
+    if ( tile_is_mine(*rand_tile) ) {
+      LOG_TRACE("Spot %zu already has a mine, using %zu instead.", pick, j);
+      rand_tile = mine_spot(board, j, avoid, avoid_count);
+    }
+
+    // Assign a bomb to this spot
+    *rand_tile |= TILE_MINE;
+
+    // Increment nearby tiles' bomb count. Bombs and border tiles keep a
+    // count too; it's hidden behind TILE_MINE or TILE_BORDER.
+    for ( int i = 0; i < 8; i++ ) {
+      rand_tile[board -> nearby[i]]++;
     }
   }
-  // Reset any array indices we didn't use
-  for ( ; tile_idx < 8; tile_idx++ ) {
-    nearby[tile_idx] = NULL;
-  }
-  // All done!
 }
 
 /**
- * Counts the number of nearby flags to a tile.
+ * Works out how many entries a board's fill queue gets. It only ever holds
+ * the edge of a region, so it's sized by the board's perimeter.
  *
- * @param board the board to check on
- * @param x the x position of the tile to check
- * @param y the y position of the tile to check
- * @return the number of nearby flagged tiles, 0-8.
+ * @param width the horizontal count of tiles across the board
+ * @param height the vertical count of tiles across the board
+ * @return the number of entries in the fill queue
  */
-static short nearby_flags(Board *board, short x, short y) {
-  // Get list of nearby tiles
-  Tile *nearby[9] = { NULL };
-  list_nearby(board, x, y, nearby);
-  // Process list of nearby tiles
-  short nearby_flags = 0;
-  for ( Tile **tile_ptr = nearby; *tile_ptr; tile_ptr++ ) {
-    Tile *tile_near = *tile_ptr;
-    // If it's flagged, count it up
-    if ( tile_near -> flagged ) {
-      nearby_flags++;
-    }
-  }
-  return nearby_flags;
+static size_t fill_capacity(int width, int height) {
+  size_t capacity = 4 * ( (size_t) width + height );
+  return capacity < FILL_QUEUE_MIN ? FILL_QUEUE_MIN : capacity;
 }
 
+/**
+ * Works out how many regions of zeros a board could have at most. Zeros in
+ * different regions are never next to each other, so there's at most one
+ * region for every 2x2 block of tiles.
+ *
+ * @param width the horizontal count of tiles across the board
+ * @param height the vertical count of tiles across the board
+ * @return the most regions the board could have
+ */
+static size_t region_max(int width, int height) {
+  return (size_t) ( ( width + 1 ) / 2 ) * ( ( height + 1 ) / 2 );
+}
 
 /**
- * Counts the number of nearby blanks to a tile.
+ * Works out how much memory a board's regions of zeros take: a label for
+ * every tile, border ring included, where each region's zeros start, and the
+ * zeros themselves, with room past them to merge labels in.
  *
- * @param board the board to check on
- * @param x the x position of the tile to check
- * @param y the y position of the tile to check
- * @return the number of nearby blank tiles, 0-8.
+ * @param width the horizontal count of tiles across the board
+ * @param height the vertical count of tiles across the board
+ * @return the number of bytes, or 0 if the board is too big to keep its
+ *  regions
  */
-static short nearby_blanks(Board *board, short x, short y) {
-  // Get list of nearby tiles
-  Tile *nearby[9] = { NULL };
-  list_nearby(board, x, y, nearby);
-  // Process list of nearby tiles
-  short nearby_blanks = 0;
-  for ( Tile **tile_ptr = nearby; *tile_ptr; tile_ptr++ ) {
-    Tile *tile_near = *tile_ptr;
-    // If it's blank, and not flagged, count it up
-    if ( !tile_near -> exposed && !tile_near -> flagged ) {
-      nearby_blanks++;
-    }
+static size_t region_bytes(int width, int height) {
+  int64_t tiles = (int64_t) width * height;
+  if ( tiles > BOARD_REGION_TILES_MAX ) {
+    return 0;
   }
-  return nearby_blanks;
+  size_t len_total = ( (size_t) width + 2 ) * ( (size_t) height + 2 );
+  return arena_round(sizeof(uint32_t) * len_total)
+    + arena_round(sizeof(uint32_t) * ( region_max(width, height) + 1 ))
+    + arena_round(sizeof(uint32_t)
+        * ( (size_t) tiles + region_max(width, height) + 1 ));
+}
+
+/**
+ * Works out how much memory a board of a given size takes: two bytes per tile,
+ * one for the tile and one for its nearby counts, plus the border ring and the
+ * fill queue. A 65536x65536 board needs a little over 8 GiB. Boards that keep
+ * their regions of zeros take about 9 bytes more per tile.
+ *
+ * @param width the horizontal count of tiles across the board
+ * @param height the vertical count of tiles across the board
+ * @return the number of bytes, or 0 if the size is out of range or too big to
+ *  address
+ */
+size_t board_bytes(int width, int height) {
+  if ( width < 1 || width > BOARD_SIDE_MAX || height < 1
+      || height > BOARD_SIDE_MAX ) {
+    return 0;
+  }
+  // Tiles and nearby counts, with the border ring, checked against size_t
+  // so it can't wrap on 32-bit systems
+  size_t stride = (size_t) width + 2;
+  size_t rows = (size_t) height + 2;
+  if ( rows > SIZE_MAX / 2 / stride ) {
+    return 0;
+  }
+  size_t tiles = arena_round(sizeof(Tile) * stride * rows);
+  size_t bytes = 2 * tiles;
+  // Fill queue, change list, regions, and the struct itself, each starting
+  // on the arena's alignment
+  size_t extra = arena_round(sizeof(Board))
+    + arena_round(sizeof(size_t) * fill_capacity(width, height))
+    + arena_round(sizeof(size_t) * CHANGES_MAX)
+    + region_bytes(width, height);
+  if ( tiles == 0 || bytes > SIZE_MAX - extra ) {
+    return 0;
+  }
+  return bytes + extra;
 }
 
 /**
@@ -170,119 +201,672 @@ static short nearby_blanks(Board *board, short x, short y) {
  * @param width the horizontal count of tiles across the board
  * @param height the veritcal count of tiles across the board
  * @param mineCount the number of mines that will be placed on the baord
- * @return the newly created Board
+ * @return the newly created Board, or NULL if the size is out of range or
+ *  there isn't enough memory for it
  */
-Board *newBoard(short width, short height, short mineCount) {
-  
-  // Allocate the board struct itself
-  printf("Allocating board container...\n");
-  Board *board = malloc(sizeof(Board));
+Board *newBoard(int width, int height, int64_t mineCount) {
+  // Use current time as seed for random generator
+  return newBoardSeeded(width, height, mineCount, time(0));
+}
+
+/**
+ * Constructor for a Board with a chosen seed. Boards created with the same
+ * size, mine count, and seed always have their mines in the same places.
+ *
+ * @param width the horizontal count of tiles across the board
+ * @param height the veritcal count of tiles across the board
+ * @param mineCount the number of mines that will be placed on the baord
+ * @param seed the seed for placing mines
+ * @return the newly created Board, or NULL if the size is out of range or
+ *  there isn't enough memory for it
+ */
+Board *newBoardSeeded(int width, int height, int64_t mineCount,
+    uint64_t seed) {
+  Board *board = newBoardUnplaced(width, height, mineCount);
+  if ( !board ) {
+    return NULL;
+  }
+
+  // Clear the tiles and assign the mines
+  board_reset(board, seed);
+
+  // Return the created board
+  LOG_DEBUG("Board initialization complete, returning.");
+  return board;
+}
+
+/**
+ * Constructor for a Board with its memory set up but none of its tiles, for
+ * placing the mines some other way, like bitboard_reset_board does. Reset it
+ * before anything else.
+ *
+ * @param width the horizontal count of tiles across the board
+ * @param height the vertical count of tiles across the board
+ * @param mineCount the number of mines that will be placed on the board
+ * @return the newly created Board, or NULL if the size is out of range or
+ *  there isn't enough memory for it
+ */
+Board *newBoardUnplaced(int width, int height, int64_t mineCount) {
+
+  // Check the size before working anything out from it
+  size_t bytes = board_bytes(width, height);
+  if ( bytes == 0 ) {
+    LOG_ERROR("Can't make a %dx%d board: sides must be from 1 to %d.",
+        width, height, BOARD_SIDE_MAX);
+    return NULL;
+  }
+
+  // There can't be more mines than tiles
+  int64_t tiles = (int64_t) width * height;
+  if ( mineCount < 0 || mineCount > tiles ) {
+    LOG_ERROR("Can't place %lld mines on a %dx%d board, placing %lld instead.",
+        (long long) mineCount, width, height,
+        (long long) ( mineCount < 0 ? 0 : tiles ));
+    mineCount = mineCount < 0 ? 0 : tiles;
+  }
+
+  // Allocate one arena for everything the board holds, and the board struct
+  // itself at its start, so freeing the board is a single free
+  LOG_DEBUG("Allocating the board's arena, %zu bytes in all...", bytes);
+  Arena arena;
+  if ( arena_init(&arena, bytes) != EXIT_SUCCESS ) {
+    LOG_ERROR("Not enough memory for a %dx%d board, which needs %zu bytes.",
+        width, height, bytes);
+    return NULL;
+  }
+  Board *board = arena_alloc(&arena, 1, sizeof(Board));
+  memset(board, 0, sizeof(Board));
+  board -> arena = arena;
+
   // Copy over the data
-  printf("Copying over board creation data...\n");
-  printf("width=%d\n", width);
-  printf("height=%d\n", height);
-  printf("mineCount=%d\n", mineCount);
+  LOG_DEBUG("Copying over board creation data...");
+  LOG_DEBUG("width=%d", width);
+  LOG_DEBUG("height=%d", height);
+  LOG_DEBUG("mineCount=%lld", (long long) mineCount);
   board -> width = width;
   board -> height = height;
   board -> mineCount = mineCount;
 
-  // Initialize the main board array
+  // Carve out the board's tiles, with a ring of border tiles around the
+  // edge, and a nearby count for each. board_bytes made sure everything
+  // fits.
+  board -> stride = width + 2;
+  size_t len_total = (size_t) board -> stride * ( (size_t) height + 2 );
+  board -> cells = arena_alloc(&board -> arena, len_total, sizeof(Tile));
+  board -> around = arena_alloc(&board -> arena, len_total,
+      sizeof(unsigned char));
 
-  // Create variables to keep track of the size of data needed
-  int len_header = sizeof(Tile **) * height;
-  int len_arr = sizeof(Tile *) * height * width;
-  int len_total = len_header + len_arr;
+  // Build the table of offsets to each neighbor
+  ptrdiff_t stride = board -> stride;
+  ptrdiff_t nearby[8] = {
+    -stride - 1, -stride, -stride + 1,
+    -1,                   1,
+    stride - 1,  stride,  stride + 1,
+  };
+  for ( int i = 0; i < 8; i++ ) {
+    board -> nearby[i] = nearby[i];
+  }
 
-  // Allocate full board array
-  printf("Allocating the actual board, %lu bytes...\n", sizeof(Tile) * width * height);
-  board -> board = (Tile ***) malloc( len_total );
+  // Carve out the queue for exposing regions of blanks, and the list of
+  // changed tiles
+  board -> fill_capacity = fill_capacity(width, height);
+  board -> fill_queue = arena_alloc(&board -> arena, board -> fill_capacity,
+      sizeof(size_t));
+  board -> changes = arena_alloc(&board -> arena, CHANGES_MAX, sizeof(size_t));
 
-  // Get pointer to first element of board array
-  Tile **main_table = (Tile **)(board -> board + height);
+  // Carve out the regions of zeros, if the board is small enough to keep
+  // them. Border tiles are never zeros, so their labels are cleared once
+  // here and never written again.
+  board -> bbbv = -1;
+  if ( region_bytes(width, height) > 0 ) {
+    board -> region = arena_alloc(&board -> arena, len_total, sizeof(uint32_t));
+    board -> region_start = arena_alloc(&board -> arena,
+        region_max(width, height) + 1, sizeof(uint32_t));
+    board -> region_zeros = arena_alloc(&board -> arena,
+        (size_t) tiles + region_max(width, height) + 1, sizeof(uint32_t));
+    memset(board -> region, 0, sizeof(uint32_t) * len_total);
+  }
+  LOG_DEBUG("Start of board is %p", (void *) board -> cells);
+  LOG_DEBUG("Board initialization complete.");
+  return board;
+}
+
+/**
+ * Clears every tile on the board: blank, unflagged, and with no bombs nearby,
+ * inside a ring of border tiles.
+ *
+ * @param board the board to clear, with its cells and offsets allocated
+ */
+static void clear_tiles(Board *board) {
+  size_t len_total = (size_t) board -> stride * ( (size_t) board -> height + 2 );
+  memset(board -> cells, 0, sizeof(Tile) * len_total);
+
+  // Mark the border ring. Border tiles look exposed to every check, so they
+  // never need to be bounds checked.
+  for ( int x = 0; x < board -> stride; x++ ) {
+    board -> cells[x] = TILE_BORDER | TILE_EXPOSED;
+    board -> cells[len_total - 1 - x] = TILE_BORDER | TILE_EXPOSED;
+  }
+  for ( int y = 1; y <= board -> height; y++ ) {
+    board -> cells[(size_t) y * board -> stride] = TILE_BORDER | TILE_EXPOSED;
+    board -> cells[(size_t) y * board -> stride + board -> width + 1] =
+      TILE_BORDER | TILE_EXPOSED;
+  }
+}
 
-  // for loop to point rows pointer to appropriate location in 2D array
-  for(size_t y = 0; y < height; y++)
-    board -> board[y] = (main_table + width * y);
+/**
+ * Starts a new game on an existing board, keeping its size and mine count.
+ * Reuses all of the board's memory, so nothing is allocated. The mines end up
+ * where newBoardSeeded would put them with the same seed.
+ *
+ * @param board the board to reset
+ * @param seed the seed for placing mines
+ */
+void board_reset(Board *board, uint64_t seed) {
+  board -> cur_x = 0;
+  board -> cur_y = 0;
+  board -> exposed = 0;
+  board -> seed = seed;
+  rng_seed(&board -> rng, seed);
+  clear_tiles(board);
+  board_changes_clear(board);
 
+  // Assign the mines, unless they wait for the first pick
+  board -> mines_pending = board -> first_zero && board -> mineCount > 0;
+  if ( !board -> mines_pending ) {
+    LOG_DEBUG("Assigning mines with seed %llu...", (unsigned long long) seed);
+    place_mines(board, NULL, 0);
+  }
 
-  printf("Start of board is %p\n", board -> board);
+  // Count the blanks around each tile, and pick where a game can start
+  board_recount(board);
+}
 
-  // Loop through the board, creating each tile
-  printf("Initializing board tiles...\n");
-  for ( size_t y = 0; y < height; y++ ) {
-    // Loop over this row
-    for ( size_t x = 0; x < width; x++ ) {
-      // Initialize this Tile
-      printf("Initializing tile...\n");
-      Tile *tile = newTile(x, y, 0);
-      printf("Placing tile at (%2zu,%2zu)...\n", x, y);
-      board -> board[y][x] = tile;
+/**
+ * Places the mines that were waiting for the first pick, keeping them out of
+ * the picked tile and the tiles around it. On boards too crowded for that,
+ * only the picked tile is kept clear, if even that fits.
+ *
+ * @param board the board to place mines on
+ * @param x the x position of the first pick
+ * @param y the y position of the first pick
+ */
+static void place_first_mines(Board *board, int x, int y) {
+  size_t avoid[9];
+  int avoid_count = 0;
+  int64_t room = (int64_t) board -> width * board -> height - board -> mineCount;
+  if ( room >= 9 ) {
+    // Row by row, so they come out in increasing order
+    for ( int near_y = y - 1; near_y <= y + 1; near_y++ ) {
+      for ( int near_x = x - 1; near_x <= x + 1; near_x++ ) {
+        if ( near_x >= 0 && near_x < board -> width && near_y >= 0
+            && near_y < board -> height ) {
+          avoid[avoid_count++] = (size_t) near_y * board -> width + near_x;
+        }
+      }
     }
-    printf("Row %zu complete.\n", y);
+  } else if ( room >= 1 ) {
+    avoid[avoid_count++] = (size_t) y * board -> width + x;
   }
-  printf("Board initialization complete.\n");
+  LOG_DEBUG("Assigning mines around (%d,%d)...", x, y);
+  place_mines(board, avoid, avoid_count);
+  board -> mines_pending = false;
+  board_recount(board);
+}
 
-  // Assign the mines
-  printf("Assigning mines...\n");
-  // Use current time as seed for random generator
-  srand(time(0));
-  // Keep track of how many we've assigned
-  short minesAssigned = 0;
-  // While there's still more mines to assign
-  while ( minesAssigned < mineCount ) {
-
-    // Pick a random spot to mine
-    short rand_x = rand() % width;
-    short rand_y = rand() % height;
-    printf("Picking spot (%2d,%2d) for potential mine (%d of %d)...\n",
-        rand_x, rand_y, minesAssigned + 1, mineCount);
-    // Get the Tile at that spot
-    Tile *rand_tile = board -> board[rand_y][rand_x];
-    printf("Checking Tile at (%2d,%2d)...\n", rand_x, rand_y);
-    
-    // Check that spot to make sure it's not already a bomb
-    if ( rand_tile -> bomb == BOMB_HERE ) {
-      // This spot already has a mine. Re-generate.
-      printf("Found spot (%2d,%2d) that already has a mine. Skipping...\n",
-          rand_x, rand_y);
-      continue;
+/**
+ * Makes a random number in (0, 1), with 53 bits of precision.
+ *
+ * @param rng the generator to advance
+ * @return a number strictly between 0 and 1
+ */
+static inline double rng_unit(Rng *rng) {
+  return ( ( rng_next(rng) >> 11 ) + 0.5 ) * 0x1.0p-53;
+}
+
+/**
+ * Picks which tile next replaces a random pick from a run of tiles, to keep
+ * every tile seen so far equally likely to be the pick. Once n tiles have
+ * been seen, the chance that none of tiles n + 1 through m replace the pick
+ * is n / m, so the next replacement can be drawn directly instead of rolling
+ * for every tile. Only about log(n) random numbers are drawn for n tiles.
+ *
+ * @param board the board whose generator to draw from
+ * @param seen the number of tiles seen, the last of which is the pick
+ * @return the number of the tile that next replaces the pick, from 1
+ */
+static size_t sample_next(Board *board, size_t seen) {
+  double next = seen / rng_unit(&board -> rng);
+  return next < (double) ( SIZE_MAX / 4 ) ? (size_t) next + 1 : SIZE_MAX / 4;
+}
+
+/**
+ * Counts one neighbor into a tile's nearby counts: AROUND_FLAG_ONE if it's
+ * flagged, or 1 if it's blank. Border tiles look exposed, so they add
+ * nothing.
+ */
+#define AROUND_ONE(tile) \
+  ( ( ( tile ) & TILE_FLAGGED ) >> 2 | !( ( tile ) & ( TILE_EXPOSED | TILE_FLAGGED ) ) )
+
+/** Bits of a tile kept when sampling where a game starts. See board_recount. */
+#define SAMPLE_BITS ( TILE_COUNT | TILE_MINE | TILE_EXPOSED | TILE_FLAGGED )
+
+/**
+ * Bits of a tile that are all clear on a zero: in play, safe, and with no
+ * bombs nearby.
+ */
+#define ZERO_BITS ( TILE_COUNT | TILE_MINE | TILE_BORDER )
+
+/** The top bit of every byte in a word. */
+#define BYTE_HIGHS 0x8080808080808080ULL
+
+/**
+ * Finds the bytes of a word of tiles with none of some bits set. Adding 0x7F
+ * to the low 7 bits of a byte only carries into its top bit if one of them is
+ * set, and never into the next byte.
+ *
+ * @param tiles a word of tiles, from load_tiles
+ * @param bits the bits to look for, in every byte
+ * @return the top bit of each byte with none of the bits set
+ */
+static inline uint64_t clear_bytes(uint64_t tiles, uint64_t bits) {
+  tiles &= bits;
+  return ~( ( ( tiles & ~BYTE_HIGHS ) + ~BYTE_HIGHS ) | tiles ) & BYTE_HIGHS;
+}
+
+/**
+ * Finds the zeros among 8 tiles of each of three rows, one above the other.
+ *
+ * @param up the tiles above
+ * @param row the tiles
+ * @param down the tiles below
+ * @param count how many tiles to look at in each row, 1-8
+ * @return the top bit of each byte with a zero in its column
+ */
+static inline uint64_t column_zeros(const Tile *up, const Tile *row,
+    const Tile *down, int count) {
+  // Missing tiles read as border tiles, which are never zeros
+  uint64_t bits = ZERO_BITS * BYTE_LOWS;
+  return clear_bytes(load_tiles(up, count, TILE_BORDER), bits)
+    | clear_bytes(load_tiles(row, count, TILE_BORDER), bits)
+    | clear_bytes(load_tiles(down, count, TILE_BORDER), bits);
+}
+
+/**
+ * Finds the first byte of a word with its top bit set.
+ *
+ * @param bytes a word with only top bits of bytes set, at least one of them
+ * @return the byte's place, 0 for the low byte
+ */
+static inline int first_byte(uint64_t bytes) {
+#if defined(__GNUC__)
+  return __builtin_ctzll(bytes) / 8;
+#else
+  int place = 0;
+  while ( !( bytes & 0x80 ) ) {
+    bytes >>= 8;
+    place++;
+  }
+  return place;
+#endif
+}
+
+/**
+ * Finds the label a region label was merged into, halving the path to it
+ * along the way.
+ *
+ * @param parent for each label, the label it was merged into, or itself
+ * @param label the label to look up
+ * @return the label at the root of its merges, never more than label
+ */
+static inline uint32_t region_root(uint32_t *parent, uint32_t label) {
+  while ( parent[label] != label ) {
+    parent[label] = parent[parent[label]];
+    label = parent[label];
+  }
+  return label;
+}
+
+/**
+ * Merges two region labels that turned out to be the same region, keeping
+ * the lower root.
+ *
+ * @param parent for each label, the label it was merged into, or itself
+ * @param a one of the labels
+ * @param b the other label
+ */
+static inline void region_merge(uint32_t *parent, uint32_t a, uint32_t b) {
+  a = region_root(parent, a);
+  b = region_root(parent, b);
+  if ( a < b ) {
+    parent[b] = a;
+  } else {
+    parent[a] = b;
+  }
+}
+
+/**
+ * Labels the board's regions of zeros, lists each region's zeros, and works
+ * out the board's 3BV. Labels are handed out row by row, each zero taking
+ * the label of a zero above or to its left, and labels that meet are merged
+ * with union-find. Then the merged labels are numbered in order and the
+ * zeros listed by region. Only depends on where the mines are, so it's
+ * right until they move.
+ *
+ * @param board the board to label, with its mines placed and counted
+ */
+static void label_regions(Board *board) {
+  board -> regions = 0;
+  board -> bbbv = -1;
+  if ( !board -> region || board -> mines_pending ) {
+    return;
+  }
+  uint32_t *label = board -> region;
+  ptrdiff_t stride = board -> stride;
+  // What each label was merged into goes past the end of the zero list, and
+  // until the list is filled in, the region starts hold how many zeros each
+  // label has
+  uint32_t *parent = board -> region_zeros
+    + (size_t) board -> width * board -> height;
+  uint32_t *start = board -> region_start;
+  uint32_t count = 0;
+  int64_t isolated = 0;
+  int width = board -> width;
+
+  // Label the zeros, and count the safe numbered tiles with no zero nearby,
+  // 8 tiles at a time. Most tiles aren't zeros, so only zeros are looked at
+  // one by one.
+  for ( int y = 0; y < board -> height; y++ ) {
+    size_t row_start = board_index(board, 0, y);
+    const Tile *row = board -> cells + row_start;
+    const Tile *row_up = row - stride;
+    const Tile *row_down = row + stride;
+    uint32_t *here = label + row_start;
+    const uint32_t *up = here - stride;
+    // Columns with a zero in them for the 8 tiles before, these 8, and the
+    // 8 after. Columns past either end of the row are border tiles.
+    uint64_t zeros_before = 0;
+    uint64_t zeros_here = column_zeros(row_up, row, row_down,
+        width < 8 ? width : 8);
+    for ( int x = 0; x < width; x += 8 ) {
+      int tiles = width - x < 8 ? width - x : 8;
+      int tiles_after = width - x - 8 < 8 ? width - x - 8 : 8;
+      uint64_t zeros_after = tiles_after <= 0 ? 0 : column_zeros(
+          row_up + x + 8, row + x + 8, row_down + x + 8, tiles_after);
+      uint64_t near_zero = zeros_here | zeros_here << 8 | zeros_before >> 56
+        | zeros_here >> 8 | zeros_after << 56;
+      zeros_before = zeros_here;
+      zeros_here = zeros_after;
+      // Missing tiles read as border tiles, which are never zeros or safe
+      uint64_t word = load_tiles(row + x, tiles, TILE_BORDER);
+      uint64_t safe = clear_bytes(word,
+          ( TILE_MINE | TILE_BORDER ) * BYTE_LOWS);
+      isolated += bit_count(safe & ~near_zero);
+      memset(here + x, 0, sizeof(uint32_t) * tiles);
+
+      for ( uint64_t zeros = clear_bytes(word, ZERO_BITS * BYTE_LOWS); zeros;
+          zeros &= zeros - 1 ) {
+        int at = x + first_byte(zeros);
+
+        // A zero above already shares a label with every labeled zero next
+        // to this one. Otherwise, one up and right may join one to the left
+        // or up and left, which share a label with each other.
+        uint32_t side = here[at - 1] ? here[at - 1] : up[at - 1];
+        if ( up[at] ) {
+          here[at] = up[at];
+        } else if ( up[at + 1] ) {
+          here[at] = up[at + 1];
+          if ( side ) {
+            region_merge(parent, side, up[at + 1]);
+          }
+        } else if ( side ) {
+          here[at] = side;
+        } else {
+          count++;
+          parent[count] = count;
+          start[count] = 0;
+          here[at] = count;
+        }
+        start[here[at]]++;
+      }
+    }
+  }
+
+  // Number the regions in the order their first zeros turn up. Every label
+  // was merged into a lower one, so it's numbered by the time any label
+  // merged into it is. Each region's zeros are totaled in its own spot,
+  // which is never past the spot of any label not looked at yet.
+  uint32_t regions = 0;
+  for ( uint32_t l = 1; l <= count; l++ ) {
+    uint32_t zeros = start[l];
+    if ( parent[l] == l ) {
+      parent[l] = ++regions;
+      start[regions] = zeros;
+    } else {
+      parent[l] = parent[parent[l]];
+      start[parent[l]] += zeros;
     }
+  }
+  uint32_t total = 0;
+  start[0] = 0;
+  for ( uint32_t r = 1; r <= regions; r++ ) {
+    uint32_t zeros = start[r];
+    start[r] = total;
+    total += zeros;
+  }
 
-    // Assign a bomb to this spot
-    rand_tile -> bomb = BOMB_HERE;
-    printf("Bomb assigned at spot (%2d,%2d).\n", rand_x, rand_y);
-    // Record this placed mine
-    minesAssigned++;
-    printf("Mine %d of %d assigned.\n", minesAssigned, mineCount);
-
-    // Increment nearby tiles' bomb count
-    // Find nearby tiles
-    Tile *nearby[9] = { NULL };
-    list_nearby(board, rand_x, rand_y, nearby);
-    // Process nearby tiles - increment their bomb count
-    for ( Tile **tile_ptr = nearby; *tile_ptr; tile_ptr++ ){
-      Tile *tile = *tile_ptr;
-      printf("Attempting to incrememt bomb count at (%2d,%2d)\n",
-          tile -> x, tile -> y);
-      printf("DEBUG: tile=%p\n", tile);
-      // If it's a bomb, skip it
-      if ( tile -> bomb == BOMB_HERE ) {
-        printf("This tile already has a bomb. Skipping.\n");
-        continue;
+  // Relabel the zeros with their regions and list them, moving each
+  // region's start up to its end as it fills
+  for ( int y = 0; y < board -> height; y++ ) {
+    uint32_t row_start = board_index(board, 0, y);
+    const Tile *row = board -> cells + row_start;
+    uint32_t *here = label + row_start;
+    for ( int x = 0; x < width; x += 8 ) {
+      int tiles = width - x < 8 ? width - x : 8;
+      uint64_t word = load_tiles(row + x, tiles, TILE_BORDER);
+      for ( uint64_t zeros = clear_bytes(word, ZERO_BITS * BYTE_LOWS); zeros;
+          zeros &= zeros - 1 ) {
+        int at = x + first_byte(zeros);
+        here[at] = parent[here[at]];
+        board -> region_zeros[start[here[at]]++] = row_start + at;
       }
+    }
+  }
+  board -> regions = regions;
+  board -> bbbv = regions + isolated;
+}
 
-      // Otherwise, increment its bomb index
-      tile -> bomb++;
-      printf("Tile's bomb count incremented to %d.\n", tile -> bomb);
-      // Done!
+/**
+ * Works out the nearby flag and blank counts for every tile, and the number
+ * of exposed tiles, from the tiles themselves, and labels the regions of
+ * zeros. Use after writing tiles directly, like when loading a saved board.
+ *
+ * Along the way, picks a starting tile for board_expose_safe: one of the
+ * hidden safe tiles with the fewest bombs nearby, every one equally likely.
+ * Draws from the board's generator to do it.
+ *
+ * @param board the board to recount
+ */
+void board_recount(Board *board) {
+  ptrdiff_t stride = board -> stride;
+  int width = board -> width;
+  int64_t exposed = 0;
+  // Fewest bombs near a hidden safe tile so far, how many tiles have that
+  // few, and which of them next replaces the pick
+  int lowest = BOMB_HERE;
+  size_t seen = 0;
+  size_t next = 0;
+  board -> safe_pick = 0;
+  for ( int y = 0; y < board -> height; y++ ) {
+    size_t start = board_index(board, 0, y);
+    const Tile *up = board -> cells + start - stride;
+    const Tile *row = board -> cells + start;
+    const Tile *down = board -> cells + start + stride;
+    unsigned char *around = board -> around + start;
+    for ( int x = 0; x < width; x++ ) {
+      around[x] = AROUND_ONE(up[x - 1]) + AROUND_ONE(up[x]) +
+        AROUND_ONE(up[x + 1]) + AROUND_ONE(row[x - 1]) + AROUND_ONE(row[x + 1]) +
+        AROUND_ONE(down[x - 1]) + AROUND_ONE(down[x]) + AROUND_ONE(down[x + 1]);
+      exposed += ( row[x] & TILE_EXPOSED ) != 0;
+
+      // Count the hidden safe tiles, and sample the ones with the fewest
+      // bombs nearby. A lower count starts the sample over. Keeping the
+      // mine, exposed, and flagged bits in the count puts every other tile at
+      // 16 or more, where it's never sampled, so telling them apart doesn't
+      // cost a branch.
+      int count = row[x] & SAMPLE_BITS;
+      if ( count < lowest ) {
+        lowest = count;
+        seen = 0;
+        next = 1;
+      }
+      seen += count == lowest;
+      if ( seen == next && count == lowest ) {
+        board -> safe_pick = start + x;
+        next = sample_next(board, seen);
+      }
     }
   }
-  // Bombs assigned
-  
+  board -> exposed = exposed;
+  board -> safe_lowest = lowest;
+  board -> safe_count = lowest < BOMB_HERE ? seen : 0;
+  label_regions(board);
+}
 
-  // Return the created board
-  printf("Board initialization complete, returning.\n");
-  return board;
+/**
+ * Recounts one band of rows like board_recount, without picking a starting
+ * tile. Instead, tallies what board_recount_join needs to pick the same one
+ * board_recount would. Bands that don't share rows can be recounted at the
+ * same time.
+ *
+ * @param board the board to recount
+ * @param first the first row of the band
+ * @param last one past the last row of the band
+ * @param band where to place the band's tallies
+ */
+void board_recount_rows(Board *board, int first, int last, RecountBand *band) {
+  memset(band, 0, sizeof(RecountBand));
+  band -> first = first;
+  band -> last = last;
+  ptrdiff_t stride = board -> stride;
+  int width = board -> width;
+  int64_t exposed = 0;
+  // The lowest sample count in the band so far, and how many tiles have
+  // had it since it got that low. It only goes down, so each count's
+  // tally is written once, when the next lower one turns up.
+  int lowest = BOMB_HERE;
+  size_t run = 0;
+  for ( int y = first; y < last; y++ ) {
+    size_t start = board_index(board, 0, y);
+    const Tile *up = board -> cells + start - stride;
+    const Tile *row = board -> cells + start;
+    const Tile *down = board -> cells + start + stride;
+    unsigned char *around = board -> around + start;
+    for ( int x = 0; x < width; x++ ) {
+      around[x] = AROUND_ONE(up[x - 1]) + AROUND_ONE(up[x]) +
+        AROUND_ONE(up[x + 1]) + AROUND_ONE(row[x - 1]) + AROUND_ONE(row[x + 1]) +
+        AROUND_ONE(down[x - 1]) + AROUND_ONE(down[x]) + AROUND_ONE(down[x + 1]);
+      exposed += ( row[x] & TILE_EXPOSED ) != 0;
+
+      int count = row[x] & SAMPLE_BITS;
+      if ( count < lowest ) {
+        band -> lows[lowest] = run;
+        lowest = count;
+        run = 0;
+      }
+      run += count == lowest;
+    }
+  }
+  band -> lows[lowest] = run;
+  band -> exposed = exposed;
+}
+
+/**
+ * Finds a tile board_recount_rows tallied: the rank-th tile in a band with a
+ * sample count of level, while level is the lowest the band has seen.
+ *
+ * @param board the board the band is on
+ * @param band the band to look in
+ * @param level the sample count to look for
+ * @param rank which of those tiles to find, from 1
+ * @return the tile's index
+ */
+static size_t find_low(const Board *board, const RecountBand *band, int level,
+    size_t rank) {
+  int lowest = BOMB_HERE;
+  for ( int y = band -> first; y < band -> last; y++ ) {
+    size_t start = board_index(board, 0, y);
+    const Tile *row = board -> cells + start;
+    for ( int x = 0; x < board -> width; x++ ) {
+      int count = row[x] & SAMPLE_BITS;
+      lowest = count < lowest ? count : lowest;
+      if ( count == level && lowest == level && --rank == 0 ) {
+        return start + x;
+      }
+    }
+  }
+  return 0;
+}
+
+/**
+ * Puts together the bands from board_recount_rows, in order from the top of
+ * the board, picks the starting tile, and labels the regions of zeros.
+ * Makes the same draws from the board's generator as board_recount, in the
+ * same order, so the board comes out exactly as board_recount would leave it.
+ *
+ * @param board the board to finish recounting
+ * @param bands the tallies for each band, covering every row in order
+ * @param count the number of bands
+ */
+void board_recount_join(Board *board, const RecountBand *bands, int count) {
+  // Replay the sample across the bands. Within a band, tiles at the count
+  // that's lowest so far all come before any at a lower count, so walking
+  // the band's tallies from the current lowest down runs into them in the
+  // same order board_recount does.
+  int64_t exposed = 0;
+  int lowest = BOMB_HERE;
+  size_t seen = 0;
+  size_t next = 0;
+  int pick_band = -1;
+  int pick_level = 0;
+  size_t pick_rank = 0;
+  for ( int b = 0; b < count; b++ ) {
+    exposed += bands[b].exposed;
+    for ( int level = lowest; level >= 0; level-- ) {
+      size_t tiles = bands[b].lows[level];
+      if ( tiles == 0 ) {
+        continue;
+      }
+      if ( level < lowest ) {
+        lowest = level;
+        seen = 0;
+        next = 1;
+      }
+      while ( next <= seen + tiles ) {
+        pick_band = b;
+        pick_level = level;
+        pick_rank = next - seen;
+        next = sample_next(board, next);
+      }
+      seen += tiles;
+    }
+  }
+
+  board -> safe_pick = pick_band < 0 ? 0
+    : find_low(board, &bands[pick_band], pick_level, pick_rank);
+  board -> exposed = exposed;
+  board -> safe_lowest = lowest;
+  board -> safe_count = lowest < BOMB_HERE ? seen : 0;
+  label_regions(board);
+}
+
+/**
+ * Frees a Board and everything it holds, all in its one arena.
+ *
+ * @param board the board to free
+ */
+void board_free(Board *board) {
+  arena_release(&board -> arena);
 }
 
 /**
@@ -292,81 +876,227 @@ Board *newBoard(short width, short height, short mineCount) {
  */
 void board_expose_all(Board *board) {
   // Loop through the board
-  for ( size_t y = 0; y < board -> height; y++ ) {
-    for ( size_t x = 0; x < board -> width; x++ ) {
-      // Expose this tile
-      board -> board[y][x] -> exposed = true;
+  for ( int y = 0; y < board -> height; y++ ) {
+    for ( int x = 0; x < board -> width; x++ ) {
+      size_t index = board_index(board, x, y);
+      Tile tile = board -> cells[index];
+      // Expose this tile. Blanks go through mark_exposed to keep the counts
+      // around them right; flagged tiles don't change any counts.
+      if ( !( tile & ( TILE_EXPOSED | TILE_FLAGGED ) ) ) {
+        mark_exposed(board, index);
+      } else {
+        board -> cells[index] = tile | TILE_EXPOSED;
+      }
     }
   }
+  // Every tile may look different now
+  board -> changes_overflow = true;
 }
 
 /**
- * Exposes one blank tile on the board, to start off.
- * If a blank tile cannot be found after a certain number of retries,
- * exposes the first non-bomb tile it finds.
+ * Exposes one blank tile on the board, to start off, picked at random when
+ * the mines were placed. If there are no blanks, exposes a tile with as few
+ * bombs nearby as there are. Takes constant time at the start of a game.
  *
  * @param board the board to expose a tile on
  */
 void board_expose_safe(Board *board) {
 
   // Sanity check: Is the board just all bombs?
-  if ( board -> mineCount == board -> width * board -> height ) {
+  if ( board_safe_tiles(board) == 0 ) {
     // There's no safe move.
-    printf("ERROR: Attempted to expose safe tile, but board is all bombs.\n");
-    printf("Returning without doing anything...\n");
+    LOG_ERROR("Attempted to expose safe tile, but board is all bombs.");
+    LOG_ERROR("Returning without doing anything...");
     return; // TODO: Report error?
   }
-  
-  // Set some random coordinates to check
-  printf("Picking a random coordinate to check...\n");
-  short try_x = rand() % board -> width;
-  short try_y = rand() % board -> height;
-
-  // Limit to a set number of random checks
-  const size_t MAX_ITERATIONS = 1000;
-
-  // Strategy: Start only looking for blank spaces.
-  // If we don't find any after 1000 iterations, move on to look for 1's.
-  // If no 1's, then look for 2's, and so on.
-  printf( "Beginning target loop...\n");
-  for ( short target_bomb = 0; target_bomb <= 8; target_bomb++ ) {
-    printf( "Looking for a target tile with bomb level %d\n", target_bomb );
-
-    // Start the iteration count for this target bomb level
-    size_t iteration = 0;
-    do {
-      printf("Checking for valid spot at (%2d,%2d)\n", try_x, try_y);
-      // Check for a valid spot
-      if ( board -> board[try_y][try_x] -> bomb == 0 ) {
-        // If we find it, expose that spot
-        printf("Found valid spot. Exposing...\n");
-        board_expose_pick ( board, try_x, try_y );
-        return;
+
+  // If the mines are waiting for the first pick, any tile will be a blank
+  if ( board -> mines_pending ) {
+    int x = rng_below(&board -> rng, board -> width);
+    int y = rng_below(&board -> rng, board -> height);
+    board_expose_pick(board, x, y);
+    return;
+  }
+
+  // Start from the tile picked when the mines were placed
+  size_t index = board -> safe_pick;
+  Tile tile = board -> cells[index];
+  if ( !( tile & ( TILE_MINE | TILE_EXPOSED | TILE_FLAGGED ) ) ) {
+    LOG_DEBUG("Exposing a tile with %d bombs nearby.", tile_count(tile));
+    board_expose_pick(board, board_x(board, index), board_y(board, index));
+    return;
+  }
+
+  // Partway through a game the pick may be taken, so look for the hidden safe
+  // tile with the fewest bombs nearby
+  LOG_DEBUG("Starting pick is taken, looking for another...");
+  size_t best = 0;
+  int best_count = BOMB_HERE;
+  for ( int y = 0; y < board -> height && best_count > 0; y++ ) {
+    for ( int x = 0; x < board -> width; x++ ) {
+      size_t near = board_index(board, x, y);
+      tile = board -> cells[near];
+      if ( !( tile & ( TILE_MINE | TILE_EXPOSED | TILE_FLAGGED ) )
+          && tile_count(tile) < best_count ) {
+        best = near;
+        best_count = tile_count(tile);
       }
-      // Pick another one
-      printf("Spot was not a blank tile. Finding another to check...\n");
-      try_x = rand() % board -> width;
-      try_y = rand() % board -> height;
+    }
+  }
+  if ( best_count < BOMB_HERE ) {
+    board_expose_pick(board, board_x(board, best), board_y(board, best));
+  }
+}
+
 
-      // But, if we run out of iterations, move on...
-    } while ( iteration < MAX_ITERATIONS );
+/**
+ * Exposes every tile reachable from a blank tile through other blanks, along
+ * with the numbered tiles around the edge of that region.
+ *
+ * Works breadth-first through the board's fill queue instead of recursing,
+ * so the region can be any size. Tiles are marked exposed as soon as they're
+ * queued, so each one is queued at most once. If the queue ever fills up, the
+ * blanks that didn't fit are picked up again by sweeping the board for
+ * exposed blanks that still have blanks next to them.
+ *
+ * @param board the board to expose tiles on
+ * @param start the index of an exposed blank tile to start from
+ */
+static void expand_blanks(Board *board, size_t start) {
+  Tile *cells = board -> cells;
+  size_t *queue = board -> fill_queue;
+  size_t capacity = board -> fill_capacity;
+  size_t head = 0;
+  size_t length = 1;
+  queue[0] = start;
+  bool dropped = false;
+
+  while ( true ) {
+    // Expose everything around each queued blank
+    while ( length > 0 ) {
+      size_t index = queue[head];
+      head = ( head + 1 == capacity ) ? 0 : head + 1;
+      length--;
+
+      for ( int i = 0; i < 8; i++ ) {
+        size_t near = index + board -> nearby[i];
+        Tile tile = cells[near];
+        // Border tiles are exposed, so this also stops at the board's edge
+        if ( tile & ( TILE_EXPOSED | TILE_FLAGGED ) ) {
+          continue;
+        }
+        mark_exposed(board, near);
+        // Blanks get their own neighbors exposed in turn
+        if ( tile_count(tile) == 0 ) {
+          if ( length < capacity ) {
+            size_t tail = head + length;
+            queue[tail >= capacity ? tail - capacity : tail] = near;
+            length++;
+          } else {
+            dropped = true;
+          }
+        }
+      }
+    }
 
-    printf("DEBUG: Reached iteration limit for bomb level %d.\n", target_bomb);
+    // If nothing was dropped, the whole region is exposed
+    if ( !dropped ) {
+      break;
+    }
 
+    // Otherwise, find the blanks that were exposed but never expanded
+    dropped = false;
+    head = 0;
+    for ( int y = 0; y < board -> height; y++ ) {
+      for ( int x = 0; x < board -> width; x++ ) {
+        size_t index = board_index(board, x, y);
+        Tile tile = cells[index];
+        if ( ( tile & ( TILE_EXPOSED | TILE_MINE | TILE_COUNT ) ) != TILE_EXPOSED
+            || board_tile_done(board, index) ) {
+          continue;
+        }
+        if ( length < capacity ) {
+          queue[length++] = index;
+        } else {
+          dropped = true;
+        }
+      }
+    }
   }
+}
 
-  printf("Reality has broken, or there's a bug somewhere. board.c:board_expose_safe()\n");
-  // If we get here, then the whole board is almost definitely full of bombs,
-  // which shouldn't be possible, because we checked for this at the start of
-  // the method.
-  return; // TODO: Complain about reality break
+/**
+ * Exposes the region of zeros a zero was just exposed in, with the numbered
+ * tiles around its edge, in one sweep down the region's list of zeros. Only
+ * for regions nobody's touched: if any other zero in it is exposed or
+ * flagged, the region may be cut up, and only flood filling from the tile
+ * exposes just the part it should.
+ *
+ * @param board the board to expose tiles on
+ * @param start the index of the zero just exposed
+ * @return true if the region was exposed, or false to flood fill instead
+ */
+static bool expose_region(Board *board, size_t start) {
+  uint32_t region = board -> region ? board -> region[start] : 0;
+  if ( region == 0 ) {
+    return false;
+  }
+  Tile *cells = board -> cells;
+  const uint32_t *first = board -> region_zeros
+    + board -> region_start[region - 1];
+  const uint32_t *last = board -> region_zeros + board -> region_start[region];
+  for ( const uint32_t *zero = first; zero < last; zero++ ) {
+    if ( *zero != start
+        && ( cells[*zero] & ( TILE_EXPOSED | TILE_FLAGGED ) ) ) {
+      return false;
+    }
+  }
+
+  // Expose every zero and everything around it. Nothing next to a zero is a
+  // mine, and border tiles look exposed.
+  for ( const uint32_t *zero = first; zero < last; zero++ ) {
+    if ( !( cells[*zero] & TILE_EXPOSED ) ) {
+      mark_exposed(board, *zero);
+    }
+    for ( int i = 0; i < 8; i++ ) {
+      size_t near = *zero + board -> nearby[i];
+      if ( !( cells[near] & ( TILE_EXPOSED | TILE_FLAGGED ) ) ) {
+        mark_exposed(board, near);
+      }
+    }
+  }
+  return true;
 }
 
+/**
+ * Exposes a single hidden, unflagged tile. If it's a blank, also exposes the
+ * region of blanks around it.
+ *
+ * @param board the board to expose a tile on
+ * @param index the index of the tile to expose
+ * @return 0 if successful, else LOSE_MINE.
+ */
+static short expose_tile(Board *board, size_t index) {
+  Tile *tile = &board -> cells[index];
+  mark_exposed(board, index);
+
+  // If it's a bomb, return a lose
+  if ( tile_is_mine(*tile) ) {
+    return LOSE_MINE;
+  }
+  // If it's a blank, then expose every other non-exposed tile around this
+  // one, all at once if its region is known
+  if ( tile_count(*tile) == 0 && !expose_region(board, index) ) {
+    expand_blanks(board, index);
+  }
+  return EXIT_SUCCESS;
+}
 
 /**
  * Exposes one tile on the board.
  * If the position is out of bounds, returns ERR_OUT_OF_BOUNDS.
  * If it's flagged, returns with code INVALID_FLAGGED.
+ * If the mines are waiting for the first pick, places them first.
  * If it's blank, exposes all nearby tiles, too, and returns with EXIT_SUCCESS.
  * If it's a number, exposes just the one, and returns with EXIT_SUCCESS.
  * If it's a bomb, exposes the bomb and returns with code LOSE_MINE.
@@ -377,28 +1107,32 @@ void board_expose_safe(Board *board) {
  * @return 0 if successful, else LOSE_MINE, INVALID_FLAGGED, or
  * ERR_OUT_OF_BOUNDS.
  */
-short board_expose_pick(Board *board, short x, short y) {
-  printf("Beginning board_expose_pick with dimensions %2dx%2d at position (%2d,%2d)\n",
+short board_expose_pick(Board *board, int x, int y) {
+  LOG_TRACE("Beginning board_expose_pick with dimensions %2dx%2d at position (%2d,%2d)",
       board -> width, board -> height, x, y );
   // Check bounds
   if ( check_bounds(board, x, y) == ERR_OUT_OF_BOUNDS ) {
-    printf("Position is out of bounds.\n");
+    LOG_DEBUG("Position is out of bounds.");
     return ERR_OUT_OF_BOUNDS;
   }
   // Get the tile
-  printf("Retrieving tile from board...\n");
-  Tile *tile = board -> board[y][x];
+  LOG_TRACE("Retrieving tile from board...");
+  Tile *tile = board_tile(board, x, y);
   // If it's flagged, don't expose it, and return an invalid code
-  if ( tile -> flagged ) {
-    printf("Tile is flagged. Will not expose it.\n");
+  if ( tile_is_flagged(*tile) ) {
+    LOG_DEBUG("Tile is flagged. Will not expose it.");
     return INVALID_FLAGGED;
   }
+  // If the mines are waiting for the first pick, place them around it
+  if ( board -> mines_pending ) {
+    place_first_mines(board, x, y);
+  }
 
   // If it's already exposed
-  if ( tile -> exposed ) {
+  if ( tile_is_exposed(*tile) ) {
     // If it's a number, and there's that many bombs nearby,
     // expose everything else
-    if ( tile -> bomb > 0 && tile -> bomb < BOMB_HERE ) {
+    if ( tile_bomb(*tile) > 0 && tile_bomb(*tile) < BOMB_HERE ) {
       // Check for nearby bombs
       //// Get list of nearby tiles
       //Tile *nearby[9] = { NULL };
@@ -413,23 +1147,22 @@ short board_expose_pick(Board *board, short x, short y) {
       //  }
       //}
       // If number of nearby flags matches the number of expected bombs
-      short nearby_flag_count = nearby_flags(board, x, y);
-      if ( nearby_flag_count == tile -> bomb ) {
+      size_t index = board_index(board, x, y);
+      short nearby_flag_count = board_nearby_flags(board, index);
+      if ( board_tile_satisfied(board, index) ) {
         // Expose all nearby blank, non-flagged tiles
-        printf("Nearby flags matches indicated bombs of %d. Exposing nearby blanks.\n",
-            tile -> bomb);
-        // Get list of nearby tiles
-        Tile *nearby[9] = { NULL };
-        list_nearby(board, x, y, nearby);
-        // Loop over list of nearby tiles to expose
-        for ( int i = 0; nearby[i]; i++ ) {
-          Tile *tile_near = nearby[i];
+        LOG_DEBUG("Nearby flags matches indicated bombs of %d. Exposing nearby blanks.",
+            tile_count(*tile));
+        // Loop over nearby tiles to expose
+        for ( int i = 0; i < 8; i++ ) {
+          size_t near = index + board -> nearby[i];
+          Tile tile_near = board -> cells[near];
           // If it's blank and not flagged, expose it
-          if ( !tile_near -> exposed && !tile_near -> flagged ) {
-            short ret = board_expose_pick( board, tile_near -> x, tile_near -> y );
+          if ( !tile_is_exposed(tile_near) && !tile_is_flagged(tile_near) ) {
+            short ret = expose_tile(board, near);
             // If we just exposed a flag, complain
             if ( ret == LOSE_MINE ) {
-              printf("Exposed a nearby bomb. YOU LOSE!\n");
+              LOG_DEBUG("Exposed a nearby bomb. YOU LOSE!");
               return LOSE_MINE;
             }
           }
@@ -437,9 +1170,9 @@ short board_expose_pick(Board *board, short x, short y) {
       }
       // Number of nearby flags does not match.
       else {
-        printf("Tile indicates %d bombs nearby, but %d tiles are flagged.\n",
-            tile -> bomb, nearby_flag_count);
-        printf("To expose all nearby tiles of this one, ensure flags = bombs.\n");
+        LOG_INFO("Tile indicates %d bombs nearby, but %d tiles are flagged.",
+            tile_count(*tile), nearby_flag_count);
+        LOG_INFO("To expose all nearby tiles of this one, ensure flags = bombs.");
       }
     }
 
@@ -447,48 +1180,15 @@ short board_expose_pick(Board *board, short x, short y) {
   // If the tile isn't already exposed
   else{
 
-    // Gonna go ahead and expose the tile
-    printf("Exposing tile.\n");
-    tile -> exposed = true;
-    // Increment the board's exposed count
-    board -> exposed++;
-
-    // If it's a bomb, return a lose
-    if ( tile -> bomb == BOMB_HERE ) {
-      printf("Tile is a bomb. YOU LOSE!\n");
-      return LOSE_MINE; 
-    }
-    // If it's a blank, then expose every other non-exposed tile around this one.
-    else if ( tile -> bomb == 0 ) {
-      printf("Tile is a blank. Exposing nearby tiles...\n");
-      
-      // Get a list of nearby cells
-      Tile *nearby[9] = { NULL };
-      list_nearby(board, x, y, nearby);
-      printf("Got list of tiles.\n");
-
-      // Loop across every nearby cell
-      for ( Tile **tile_ptr = nearby; *tile_ptr; tile_ptr++ ) {
-        Tile *tile = *tile_ptr;
-        printf("Checking tile at (%2d,%2d)\n", tile -> x, tile -> y);
-        
-        // If it's already exposed or flagged, skip it
-        if ( tile -> exposed || tile -> flagged ) {
-          printf("Tile is already exposed or flagged, skipping.\n");
-          continue;
-        }
-
-        // Otherwise, we've got a valid, blank cell to expose.
-        printf("Recursively exposing tile at (%2d,%2d)\n", tile -> x, tile -> y);
-        board_expose_pick(board, tile -> x, tile -> y);
-      }
-
-      // All nearby cells have been exposed
-      printf("Done exposing nearby tiles from position (%2d,%2d)\n", x, y);
+    // Gonna go ahead and expose the tile, and any blanks around it
+    LOG_TRACE("Exposing tile.");
+    if ( expose_tile(board, board_index(board, x, y)) == LOSE_MINE ) {
+      LOG_DEBUG("Tile is a bomb. YOU LOSE!");
+      return LOSE_MINE;
     }
-    printf("Done exposing tile at (%2d,%2d).\n", x, y);
-    printf("Exposed: %d of %d\n", board -> exposed,
-        board -> width * board -> height - board -> mineCount);
+    LOG_TRACE("Done exposing tile at (%2d,%2d).", x, y);
+    LOG_DEBUG("Exposed: %lld of %lld", (long long) board -> exposed,
+        (long long) board_safe_tiles(board));
   }
 
   // All necessary cells have been exposed, good to return
@@ -508,170 +1208,82 @@ short board_expose_pick(Board *board, short x, short y) {
  * @param y the y position of the tile to flag
  * @return 0 if successful, else ERR_OUT_OF_BOUNDS or INVALID_EXPOSED.
  */
-short board_flag(Board *board, short x, short y) {
+short board_flag(Board *board, int x, int y) {
   // Check the bounds
   if ( check_bounds(board, x, y) == ERR_OUT_OF_BOUNDS ) {
-    printf("Position is out of bounds.\n");
+    LOG_DEBUG("Position is out of bounds.");
     return ERR_OUT_OF_BOUNDS;
   }
 
   // Check the tile
-  Tile *tile = board -> board[y][x];
-  if ( tile -> exposed ) {
-    printf("Tile is already exposed; cannot flag it.\n");
+  Tile *tile = board_tile(board, x, y);
+  if ( tile_is_exposed(*tile) ) {
+    LOG_INFO("Tile is already exposed; cannot flag it.");
     return INVALID_EXPOSED;
   }
-  // Switch whether it's flagged or blank
-  tile -> flagged = !tile->flagged;
+  // Switch whether it's flagged or blank, moving it between the flag and
+  // blank counts of its neighbors
+  *tile ^= TILE_FLAGGED;
+  board_note_change(board, board_index(board, x, y));
+  unsigned char change = tile_is_flagged(*tile)
+    ? AROUND_FLAG_ONE - 1 : (unsigned char) -( AROUND_FLAG_ONE - 1 );
+  unsigned char *around = board -> around + board_index(board, x, y);
+  for ( int i = 0; i < 8; i++ ) {
+    around[board -> nearby[i]] += change;
+  }
   // All done!
   return EXIT_SUCCESS;
   
 }
 
-
 /**
- * Prints out the necessary escape codes to style subsequent text with the
- * provided style code, according to bash coloring / formatting.
+ * Writes the spreadsheet-style name of a column: A-Z, then AA-AZ, BA-BZ, and
+ * so on through ZZ, then AAA.
  *
- * @param code the styling code to apply
+ * @param x the x position of the column
+ * @param name where to place the name, at least COLUMN_NAME_MAX long
+ * @return the number of letters in the name
  */
-static void style(short code) {
-  printf("\033[%dm", code);
-}
-
-
-static void print_border(size_t width) {
-  printf("+-");
-  for ( size_t x = 0; x < width; x++ ) {
-    printf("--");
+int board_column_name(int x, char name[COLUMN_NAME_MAX]) {
+  // Build the letters backwards, least significant first
+  char reversed[COLUMN_NAME_MAX];
+  int length = 0;
+  for ( x++; x > 0; x = ( x - 1 ) / 26 ) {
+    reversed[length++] = 'A' + ( x - 1 ) % 26;
+  }
+  for ( int i = 0; i < length; i++ ) {
+    name[i] = reversed[length - 1 - i];
   }
-  printf("+\n");
+  name[length] = '\0';
+  return length;
 }
 
-
 /**
- * Prints a single row of the board to the screen.
- * Includes a border around the edge, of the form:
+ * Finds the x position of a column from its spreadsheet-style name.
+ * Letters may be upper or lower case.
  *
- * +---+
- * |   |
- * |   |
- * +---+
- * ( for 3x2 )
- *
- * @param row_num the number of the row to print, from the top
- * @param board the board to print data from
+ * @param name the letters of the name
+ * @param length the number of letters in the name
+ * @return the x position of the column, or -1 if the name isn't all letters
  */
-static void print_row(short row_num, Board *board) {
-  // If -1, print column labels and top border
-  if ( row_num == -1 ) {
-    // Skip to the right spot. 2 for row labels, 1 for left border
-    printf("    ");
-    // Loop across the board width
-    for ( size_t x = 0; x < board -> width; x++ ) {
-      // Print column headers as letters
-      printf("%c ", 'A' + (char) x);
+int board_column_parse(const char *name, size_t length) {
+  int x = 0;
+  for ( size_t i = 0; i < length; i++ ) {
+    if ( !isalpha((unsigned char) name[i]) || x > BOARD_SIDE_MAX ) {
+      return -1;
     }
-    // Done with column labels, print newline
-    printf("\n  ");
-    print_border(board -> width);
-  }
-  // If height, print bottom border
-  else if ( row_num == board -> height ) {
-    printf("  ");
-    print_border(board -> width);
-  }
-  // Otherwise, print row contents
-  else {
-    printf("%2d| ", row_num + 1);
-    for ( size_t x = 0; x < board -> width; x++ ) {
-
-      // Get the tile to print
-      Tile *tile = board -> board[row_num][x];
-      // Get the character to print
-      char to_print = tile_toChar(tile);
-
-      // Determine tile formatting
-      // If this tile is selected
-      if ( row_num == board -> cur_y && x == board -> cur_x ) {
-        // Print this tile, inverted
-        style(FMT_INV);
-      }
-      // If this tile is flagged INCORRECTLY, and exposed
-      else if ( tile -> flagged && tile -> exposed &&
-          tile -> bomb != BOMB_HERE ) {
-        // Print with background as red
-        style(COLOR_BG_L_RED);
-      }
-      // If this tile is flagged or an exposed bomb
-      else if ( tile -> flagged 
-          || (tile -> exposed && tile -> bomb == BOMB_HERE)) {
-        // Print with background as red
-        style(COLOR_BG_RED);
-      }
-      // If this tile is an exposed number
-      else if ( tile -> exposed
-            && tile -> bomb > 0 && tile -> bomb < BOMB_HERE ) {
-
-        // COLORS
-
-        // Check what number it is
-        if ( tile -> bomb == 1 ) {
-          style(COLOR_BLUE);
-        } else if ( tile -> bomb == 2 ) {
-          style(COLOR_L_GREEN);
-        } else if ( tile -> bomb == 3 ) {
-          style(COLOR_L_RED);
-        } else if ( tile -> bomb == 4 ) {
-          style(COLOR_MAGENTA);
-        } else if ( tile -> bomb == 5 ) {
-          style(COLOR_RED);
-        } else if ( tile -> bomb == 6 ) {
-          style(COLOR_CYAN);
-        } else if ( tile -> bomb == 7 ) {
-          style(COLOR_D_GRAY);
-        } else if ( tile -> bomb == 8 ) {
-          style(COLOR_L_GRAY);
-        }
-
-        // FORMATS
-        
-        // If it's satisfied, but there's still nearby blanks
-        if ( tile -> bomb == nearby_flags(board, x, row_num)
-          && nearby_blanks(board, x, row_num) > 0 ) {
-          // Print with underline
-          //style(FMT_UND);
-          // This is a bit cheat-y
-        }
-        // Otherwise, if there are no nearby blanks
-        else if ( nearby_blanks(board, x, row_num ) == 0 ) {
-          // Print this tile, faded
-          style(FMT_DIM);
-        }
-      }
-      // Print this tile normally
-      printf("%c", to_print);
-      // Clear any formatting
-      style(FMT_NONE);
-      // Print the space after this tile
-      printf(" ");
-    }
-    printf("|\n");
+    x = x * 26 + ( tolower((unsigned char) name[i]) - 'a' + 1 );
   }
+  return x - 1;
 }
 
 /**
- * Prints the provided board to stdout. Includes a border around the edge.
+ * Finds how many letters the longest column name on a board has.
  *
- * @param board the game board to print
+ * @param width the number of columns on the board
+ * @return the number of letters in the last column's name
  */
-void board_print(Board *board) {
-  
-  // Loop through the rows, print one at a time
-  for ( int y = -1; y <= board -> height; y++ ) {
-    print_row(y, board);
-  }
-
-  printf("Board printed!\n");
-
+int board_column_chars(int width) {
+  char name[COLUMN_NAME_MAX];
+  return board_column_name(width - 1, name);
 }
@@ -1,4 +1,11 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <stddef.h>
+#include <stdint.h>
 #include "tile.h"
+#include "rng.h"
+#include "arena.h"
 
 // Errors are failures in user input
 #define ERR_OUT_OF_BOUNDS 1101
@@ -8,25 +15,275 @@
 // Lose conditions set by the game
 #define LOSE_MINE 1121
 
+/** Bits of an around count holding the number of nearby blank tiles. */
+#define AROUND_BLANKS 0x0F
+/** Bits of an around count holding the number of nearby flagged tiles. */
+#define AROUND_FLAGS 0xF0
+/** Amount added to an around count for each nearby flagged tile. */
+#define AROUND_FLAG_ONE 0x10
+
+/**
+ * Most tile changes a Board records between calls to board_changes_clear.
+ * Past this, it only records that too much changed to list.
+ */
+#define CHANGES_MAX 4096
+
+/**
+ * Widest and tallest a Board can be. Positions fit in an int with room to
+ * spare for the border ring, and counts of tiles are kept in 64 bits.
+ */
+#define BOARD_SIDE_MAX 65536
+
+/**
+ * Most tiles a Board can have and still keep its regions of zeros. Bigger
+ * boards flood fill to expose a region instead, and don't work out their 3BV.
+ */
+#define BOARD_REGION_TILES_MAX ( (int64_t) 1 << 24 )
+
 /**
  * Minesweeper board data, containing board size, board contents, and mine
- * count.
+ * count. The struct and every array it points to share one arena, which
+ * starts with the struct.
  */
 typedef struct Board {
   // Array size
-  short width;
-  short height;
-  // Board
-  struct Tile ***board;
+  int width;
+  int height;
+  // Board contents, one packed Tile per position. Surrounded by a one-tile
+  // ring of border tiles, so the tile at (x, y) is at
+  // (y + 1) * stride + (x + 1).
+  Tile *cells;
+  // Distance between vertically adjacent tiles in cells, width + 2
+  int stride;
+  // Offsets from a tile's index to each of its 8 neighbors
+  ptrdiff_t nearby[8];
+  // For each tile in cells, the number of nearby flagged tiles (high bits)
+  // and nearby blank tiles, neither exposed nor flagged (low bits). Kept up to
+  // date as tiles are flagged and exposed. Meaningless for border tiles.
+  unsigned char *around;
   // Number of mines on board
-  short mineCount;
+  int64_t mineCount;
   // Cursor position on the board
-  short cur_x;
-  short cur_y;
+  int cur_x;
+  int cur_y;
   // Count of exposed tiles
-  int exposed;
+  int64_t exposed;
+  // Work queue of blank tile indices waiting to have their neighbors exposed,
+  // used as a ring buffer while exposing a region of blanks
+  size_t *fill_queue;
+  size_t fill_capacity;
+  // Indices of tiles that were exposed, flagged, or unflagged since the last
+  // board_changes_clear. If more than CHANGES_MAX changed, changes_overflow is
+  // set and the list is incomplete.
+  size_t *changes;
+  size_t changes_len;
+  _Bool changes_overflow;
+  // Seed the mines were placed from, and the generator it seeded
+  uint64_t seed;
+  Rng rng;
+  // Whether the mines wait for the first tile exposed, and then stay out of
+  // the tiles around it, so the first pick is always a blank. Takes effect
+  // from the next board_reset.
+  _Bool first_zero;
+  // Whether the mines are still waiting to be placed
+  _Bool mines_pending;
+  // Hidden safe tiles with the fewest bombs nearby, found while placing the
+  // mines: that many bombs, how many tiles have it, and the index of one of
+  // them picked at random, for board_expose_safe to start from
+  int safe_lowest;
+  size_t safe_count;
+  size_t safe_pick;
+  // Regions of connected zeros, safe tiles with no bombs nearby, labeled
+  // whenever the mines are placed. For each tile in cells, the region it's
+  // in, from 1, or 0 if it isn't a zero. The zeros of region r are at
+  // region_zeros[region_start[r - 1]] up to region_start[r], so a region can
+  // be exposed in one sweep. NULL on boards bigger than
+  // BOARD_REGION_TILES_MAX.
+  uint32_t *region;
+  uint32_t *region_start;
+  uint32_t *region_zeros;
+  uint32_t regions;
+  // The board's 3BV, the fewest clicks that clear it: one per region of
+  // zeros, plus one per numbered safe tile next to no zero. -1 if the board
+  // doesn't keep its regions, or its mines are still waiting to be placed.
+  int64_t bbbv;
+  // Block the board and all of its arrays were carved out of
+  Arena arena;
 } Board;
 
+/**
+ * What board_recount_rows found in one band of rows, for board_recount_join
+ * to put together with the other bands.
+ */
+typedef struct RecountBand {
+  // Rows the band covers, first up to but not including last
+  int first;
+  int last;
+  int64_t exposed;
+  // For each bomb count, the hidden safe tiles with that count while it was
+  // the lowest the band had seen. The starting tile is picked from these.
+  size_t lows[BOMB_HERE + 1];
+} RecountBand;
+
+
+/**
+ * Finds the index of a position within the board's cells.
+ *
+ * @param board the board to index into
+ * @param x the x position of the tile
+ * @param y the y position of the tile
+ * @return the index of the tile at (x, y) in board -> cells
+ */
+static inline size_t board_index(const Board *board, int x, int y) {
+  return (size_t) ( y + 1 ) * board -> stride + ( x + 1 );
+}
+
+/** @return the x position of the tile at index in board -> cells */
+static inline int board_x(const Board *board, size_t index) {
+  return index % board -> stride - 1;
+}
+
+/** @return the y position of the tile at index in board -> cells */
+static inline int board_y(const Board *board, size_t index) {
+  return index / board -> stride - 1;
+}
+
+/**
+ * Gets the tile at a position on the board. The position must be in bounds.
+ *
+ * @param board the board to get a tile from
+ * @param x the x position of the tile
+ * @param y the y position of the tile
+ * @return a pointer to the tile at (x, y)
+ */
+static inline Tile *board_tile(Board *board, int x, int y) {
+  return &board -> cells[board_index(board, x, y)];
+}
+
+/**
+ * Counts the number of nearby flags to a tile.
+ *
+ * @param board the board to check on
+ * @param index the index of the tile to check in board -> cells
+ * @return the number of nearby flagged tiles, 0-8.
+ */
+static inline short board_nearby_flags(const Board *board, size_t index) {
+  return board -> around[index] >> 4;
+}
+
+/**
+ * Counts the number of nearby blanks to a tile: tiles neither exposed nor
+ * flagged.
+ *
+ * @param board the board to check on
+ * @param index the index of the tile to check in board -> cells
+ * @return the number of nearby blank tiles, 0-8.
+ */
+static inline short board_nearby_blanks(const Board *board, size_t index) {
+  return board -> around[index] & AROUND_BLANKS;
+}
+
+/**
+ * Checks whether a numbered tile has as many flags around it as its number.
+ *
+ * @param board the board to check on
+ * @param index the index of the tile to check in board -> cells
+ * @return true if the nearby flags match the tile's count of nearby bombs
+ */
+static inline _Bool board_tile_satisfied(const Board *board, size_t index) {
+  return board_nearby_flags(board, index) == tile_count(board -> cells[index]);
+}
+
+/**
+ * Checks whether a tile has nothing left to expose around it.
+ *
+ * @param board the board to check on
+ * @param index the index of the tile to check in board -> cells
+ * @return true if there are no blank tiles next to this one
+ */
+static inline _Bool board_tile_done(const Board *board, size_t index) {
+  return ( board -> around[index] & AROUND_BLANKS ) == 0;
+}
+
+/**
+ * Counts the tiles without mines on a board, which is how many have to be
+ * exposed to win.
+ *
+ * @param board the board to count on
+ * @return the number of safe tiles
+ */
+static inline int64_t board_safe_tiles(const Board *board) {
+  return (int64_t) board -> width * board -> height - board -> mineCount;
+}
+
+/** Longest column name, with its terminator, for any board width. */
+#define COLUMN_NAME_MAX 8
+
+/**
+ * Writes the spreadsheet-style name of a column: A-Z, then AA-AZ, BA-BZ, and
+ * so on through ZZ, then AAA.
+ *
+ * @param x the x position of the column
+ * @param name where to place the name, at least COLUMN_NAME_MAX long
+ * @return the number of letters in the name
+ */
+int board_column_name(int x, char name[COLUMN_NAME_MAX]);
+
+/**
+ * Finds the x position of a column from its spreadsheet-style name.
+ * Letters may be upper or lower case.
+ *
+ * @param name the letters of the name
+ * @param length the number of letters in the name
+ * @return the x position of the column, or -1 if the name isn't all letters
+ */
+int board_column_parse(const char *name, size_t length);
+
+/**
+ * Finds how many letters the longest column name on a board has.
+ *
+ * @param width the number of columns on the board
+ * @return the number of letters in the last column's name
+ */
+int board_column_chars(int width);
+
+/**
+ * Records that a tile changed, for whoever is watching the board.
+ *
+ * @param board the board the tile is on
+ * @param index the index of the tile that changed
+ */
+static inline void board_note_change(Board *board, size_t index) {
+  if ( board -> changes_len < CHANGES_MAX ) {
+    board -> changes[board -> changes_len++] = index;
+  } else {
+    board -> changes_overflow = 1;
+  }
+}
+
+/**
+ * Forgets the tiles recorded as changed, once whoever's watching the board
+ * has caught up with them.
+ *
+ * @param board the board to clear changes on
+ */
+static inline void board_changes_clear(Board *board) {
+  board -> changes_len = 0;
+  board -> changes_overflow = 0;
+}
+
+/**
+ * Works out how much memory a board of a given size takes: two bytes per tile,
+ * one for the tile and one for its nearby counts, plus the border ring and the
+ * fill queue. A 65536x65536 board needs a little over 8 GiB. Boards that keep
+ * their regions of zeros take about 9 bytes more per tile.
+ *
+ * @param width the horizontal count of tiles across the board
+ * @param height the vertical count of tiles across the board
+ * @return the number of bytes, or 0 if the size is out of range or too big to
+ *  address
+ */
+size_t board_bytes(int width, int height);
 
 /**
  * Constructor for a Board. Initializes Tiles, places mines, and returns the
@@ -35,16 +292,88 @@ typedef struct Board {
  * @param width the horizontal count of tiles across the board
  * @param height the veritcal count of tiles across the board
  * @param mineCount the number of mines that will be placed on the baord
- * @return the newly created Board
+ * @return the newly created Board, or NULL if the size is out of range or
+ *  there isn't enough memory for it
  */
-Board *newBoard(short width, short height, short mineCount);
+Board *newBoard(int width, int height, int64_t mineCount);
 
 /**
- * Prints the provided board to stdout. Includes a border around the edge.
+ * Constructor for a Board with a chosen seed. Boards created with the same
+ * size, mine count, and seed always have their mines in the same places.
  *
- * @param board the game board to print
+ * @param width the horizontal count of tiles across the board
+ * @param height the veritcal count of tiles across the board
+ * @param mineCount the number of mines that will be placed on the baord
+ * @param seed the seed for placing mines
+ * @return the newly created Board, or NULL if the size is out of range or
+ *  there isn't enough memory for it
  */
-void board_print(Board *board);
+Board *newBoardSeeded(int width, int height, int64_t mineCount,
+    uint64_t seed);
+
+/**
+ * Constructor for a Board with its memory set up but none of its tiles, for
+ * placing the mines some other way, like bitboard_reset_board does. Reset it
+ * before anything else.
+ *
+ * @param width the horizontal count of tiles across the board
+ * @param height the vertical count of tiles across the board
+ * @param mineCount the number of mines that will be placed on the board
+ * @return the newly created Board, or NULL if the size is out of range or
+ *  there isn't enough memory for it
+ */
+Board *newBoardUnplaced(int width, int height, int64_t mineCount);
+
+/**
+ * Starts a new game on an existing board, keeping its size and mine count.
+ * Reuses all of the board's memory, so nothing is allocated. The mines end up
+ * where newBoardSeeded would put them with the same seed.
+ *
+ * @param board the board to reset
+ * @param seed the seed for placing mines
+ */
+void board_reset(Board *board, uint64_t seed);
+
+/**
+ * Works out the nearby flag and blank counts for every tile, and the number
+ * of exposed tiles, from the tiles themselves, and labels the regions of
+ * zeros. Use after writing tiles directly, like when loading a saved board.
+ *
+ * @param board the board to recount
+ */
+void board_recount(Board *board);
+
+/**
+ * Recounts one band of rows like board_recount, without picking a starting
+ * tile. Instead, tallies what board_recount_join needs to pick the same one
+ * board_recount would. Bands that don't share rows can be recounted at the
+ * same time.
+ *
+ * @param board the board to recount
+ * @param first the first row of the band
+ * @param last one past the last row of the band
+ * @param band where to place the band's tallies
+ */
+void board_recount_rows(Board *board, int first, int last, RecountBand *band);
+
+/**
+ * Puts together the bands from board_recount_rows, in order from the top of
+ * the board, picks the starting tile, and labels the regions of zeros.
+ * Makes the same draws from the board's generator as board_recount, in the
+ * same order, so the board comes out exactly as board_recount would leave it.
+ *
+ * @param board the board to finish recounting
+ * @param bands the tallies for each band, covering every row in order
+ * @param count the number of bands
+ */
+void board_recount_join(Board *board, const RecountBand *bands, int count);
+
+/**
+ * Frees a Board and everything it holds, all in its one arena.
+ *
+ * @param board the board to free
+ */
+void board_free(Board *board);
 
 /**
  * Exposes the board by setting all Tiles' status to STATUS_EXPOSED.
@@ -54,9 +383,9 @@ void board_print(Board *board);
 void board_expose_all(Board *board);
 
 /**
- * Exposes one blank tile on the board, to start off.
- * If a blank tile cannot be found after a certain number of retries,
- * exposes the first non-bomb tile it finds.
+ * Exposes one blank tile on the board, to start off, picked at random when
+ * the mines were placed. If there are no blanks, exposes a tile with as few
+ * bombs nearby as there are. Takes constant time at the start of a game.
  *
  * @param board the board to expose a tile on
  */
@@ -66,6 +395,7 @@ void board_expose_safe(Board *board);
  * Exposes one tile on the board.
  * If the position is out of bounds, returns ERR_OUT_OF_BOUNDS.
  * If it's flagged, returns with code INVALID_FLAGGED.
+ * If the mines are waiting for the first pick, places them first.
  * If it's blank, exposes all nearby tiles, too, and returns with EXIT_SUCCESS.
  * If it's a number, exposes just the one, and returns with EXIT_SUCCESS.
  * If it's a bomb, exposes the bomb and returns with code LOSE_MINE.
@@ -76,7 +406,7 @@ void board_expose_safe(Board *board);
  * @return 0 if successful, else LOSE_MINE, INVALID_FLAGGED, or
  * ERR_OUT_OF_BOUNDS.
  */
-short board_expose_pick(Board *board, short x, short y);
+short board_expose_pick(Board *board, int x, int y);
 
 /**
  * Flags one tile on the board.
@@ -90,4 +420,6 @@ short board_expose_pick(Board *board, short x, short y);
  * @param y the y position of the tile to flag
  * @return 0 if successful, else ERR_OUT_OF_BOUNDS or INVALID_EXPOSED.
  */
-short board_flag(Board *board, short x, short y);
+short board_flag(Board *board, int x, int y);
+
+#endif
@@ -0,0 +1,348 @@
+#define _XOPEN_SOURCE 700
+
+#include "input.h"
+#include "log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
+#include <termios.h>
+#include <unistd.h>
+#include <poll.h>
+
+/** Size of the buffer raw keys are read into. */
+#define KEY_BUFFER_SIZE 64
+/**
+ * Milliseconds to wait for the rest of an escape sequence before taking what
+ * came as a lone Escape key press.
+ */
+#define ESCAPE_WAIT_MS 50
+/** Byte sent by the Escape key, and at the start of escape sequences. */
+#define ESCAPE '\033'
+/** Byte sent by Ctrl-D. */
+#define CTRL_D '\004'
+
+/** Signals that would leave the terminal in raw mode if not caught. */
+static const int RAW_SIGNALS[] = { SIGINT, SIGTERM, SIGHUP, SIGQUIT };
+
+/** Terminal settings from before raw mode, to put back afterwards. */
+static struct termios original;
+/** Whether the terminal is in raw mode. */
+static volatile sig_atomic_t raw_enabled = 0;
+/** Bytes read from the terminal that haven't been decoded yet. */
+static char key_buffer[KEY_BUFFER_SIZE];
+static size_t key_start = 0;
+static size_t key_length = 0;
+
+/**
+ * Parses one move, like "EA1" or "fc7", from a line of text. An action letter
+ * comes first, then the column, spreadsheet style (a/A, b/B, c, ..., z, aa,
+ * ab, ..., az, ba, ...), then the row number. A newline at the end is allowed.
+ *
+ * @param board the board containing the width and height, for error checking
+ * @param line the text to parse
+ * @param move a move struct for us to place the move into
+ * @return 0 if successful, else ERR_OUT_OF_BOUNDS if the position is off the
+ *  board, or 1 if the line isn't a move.
+ */
+short input_parse_move(const Board *board, const char *line, Move *move) {
+
+  // SETUP
+
+  // Check for how many column characters we need
+  size_t column_chars = board_column_chars(board -> width);
+  // Check for how many row characters we need
+  size_t row_chars = 0;
+  int tmp_height = board -> height + 1;
+  do {
+    // Divide by 10 to chop off a digit
+    tmp_height /= 10;
+    // Add a character for the digit
+    row_chars++;
+  } while ( tmp_height != 0 );
+  LOG_TRACE("column_chars=%zu, row_chars=%zu", column_chars, row_chars);
+
+  // Set up buffers to read in positions
+  char column[column_chars + 1];
+  char row[row_chars + 1];
+  char extra[32] = { 0 };
+  char action_char = '\0';
+  memset(column, 0, column_chars + 1);
+  memset(row, 0, row_chars + 1);
+  // Create the format string
+  char format[32];
+  snprintf(format, sizeof(format), "%%c%%%zu[a-zA-Z]%%%zu[0-9]%%31[^\n]",
+      column_chars, row_chars);
+  LOG_TRACE("Print format: %s", format);
+
+  // PERFORM OPERATION
+
+  move -> x = -1;
+  move -> y = -1;
+  move -> action = -1;
+
+  // Use scanf to read in characters for position
+  short scanned = sscanf( line, format, &action_char, column, row, extra );
+  LOG_DEBUG("Row: [%s] Column: [%s]", row, column);
+  // Check for didn't get all values
+  if ( scanned < 3 ) {
+    LOG_INFO("Problem pulling row and column out (only got %d).", scanned);
+    return EXIT_FAILURE;
+  }
+  // Check for illegal action
+  action_char = tolower(action_char);
+  if ( action_char == 'e' ) {
+    move -> action = EXPOSE;
+  } else if ( action_char == 'f' ) {
+    move -> action = FLAG;
+  } else {
+    LOG_INFO("Error: Unknown action '%c'. Allowed actions: [E]xpose, [F]lag.",
+        action_char);
+    return EXIT_FAILURE;
+  }
+  // Check for extra data at end
+  LOG_DEBUG("Extra data: [%s]", extra);
+  if ( strlen(extra) > 0 ) {
+    LOG_INFO("Problem, extra data at end of input (got %s)", extra);
+    return EXIT_FAILURE;
+  }
+
+  // Parse out the x column number, spreadsheet style
+  move -> x = board_column_parse(column, strlen(column));
+
+  // Parse out the y row from digits directly
+  move -> y = atoi(row) - 1;
+
+  // Confirm what we have
+  LOG_DEBUG("X: %d Y: %d", move -> x, move -> y);
+  if ( move -> x < 0 || move -> y < 0 ||
+      move -> x >= board -> width || move -> y >= board -> height ) {
+    return ERR_OUT_OF_BOUNDS;
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Gets a valid position on the board from the user, one line at a time.
+ * See input_parse_move for the format.
+ *
+ * @param board the board containing the width and height, for error checking
+ * @param move a move struct for us to place the user's move into
+ * @return true if the user made a move, false if input ran out first
+ */
+bool get_move(Board *board, Move *move) {
+  char line[32] = { 0 };
+  bool first_time = true;
+
+  do {
+
+    if ( !first_time ) {
+      printf("Please enter a position in the format [EF][a-zA-Z]+[0-9]+.\n");
+      char last_column[COLUMN_NAME_MAX];
+      board_column_name(board -> width - 1, last_column);
+      printf("  Moves: [E]xpose, [F]lag. Column in A-%s, row in 1-%d.\n",
+          last_column, board -> height );
+    }
+    first_time = false;
+
+    // Read in one line
+    LOG_DEBUG("Reading in one line. Make it nice!");
+    if ( fgets(line, sizeof(line), stdin) != line ) {
+      LOG_INFO("No more moves to read.");
+      return false;
+    }
+    // Check that it's less than the size limit
+    if ( line[strlen(line) - 1] != '\n' ) {
+      LOG_DEBUG("strlen(line): %zu, line[strlen(line) - 1]: [%c]",
+          strlen(line), line[strlen(line)] );
+      LOG_INFO("Problem: You entered too much data.");
+      continue; // TODO: Probably have to consume that data until line is empty
+    }
+    LOG_DEBUG("You entered: %.*s", (int) strlen(line) - 1, line);
+
+  } while ( input_parse_move(board, line, move) != EXIT_SUCCESS );
+
+  // Valid position. Yay!
+  return true;
+}
+
+/**
+ * Puts the terminal back the way it was before input_raw_enable.
+ * Does nothing if raw mode isn't on. Safe to call from a signal handler.
+ */
+void input_raw_disable(void) {
+  if ( raw_enabled ) {
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &original);
+    raw_enabled = 0;
+  }
+}
+
+/**
+ * Puts the terminal back, then lets a fatal signal do what it would have.
+ *
+ * @param signal the signal received
+ */
+static void on_fatal_signal(int signal) {
+  input_raw_disable();
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = SIG_DFL;
+  sigemptyset(&action.sa_mask);
+  sigaction(signal, &action, NULL);
+  raise(signal);
+}
+
+/**
+ * Puts the terminal on stdin into raw mode: keys arrive as soon as they're
+ * pressed, without being echoed or waiting for Enter. Output processing is
+ * left on, so newlines still start a new line. The terminal is put back the
+ * way it was when the program exits, or is killed by a signal.
+ *
+ * @return 0 if successful, else -1 if stdin isn't a terminal.
+ */
+int input_raw_enable(void) {
+  if ( raw_enabled ) {
+    return 0;
+  }
+  if ( !isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &original) != 0 ) {
+    return -1;
+  }
+
+  // Restore the terminal however the program ends
+  static bool registered = false;
+  if ( !registered ) {
+    atexit(input_raw_disable);
+    for ( size_t i = 0; i < sizeof(RAW_SIGNALS) / sizeof(int); i++ ) {
+      struct sigaction action;
+      memset(&action, 0, sizeof(action));
+      action.sa_handler = on_fatal_signal;
+      sigemptyset(&action.sa_mask);
+      sigaction(RAW_SIGNALS[i], &action, NULL);
+    }
+    registered = true;
+  }
+
+  struct termios raw = original;
+  raw.c_iflag &= ~( ICRNL | IXON | BRKINT | INPCK | ISTRIP );
+  raw.c_lflag &= ~( ECHO | ICANON | IEXTEN );
+  raw.c_cflag |= CS8;
+  // Wait for at least one byte, with no timeout
+  raw.c_cc[VMIN] = 1;
+  raw.c_cc[VTIME] = 0;
+  if ( tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) != 0 ) {
+    LOG_ERROR("Couldn't put the terminal in raw mode: %s", strerror(errno));
+    return -1;
+  }
+  raw_enabled = 1;
+  return 0;
+}
+
+/**
+ * Decodes the next key from a buffer of bytes read from the terminal.
+ * See input.h for the key bindings.
+ *
+ * @param bytes the bytes to decode from
+ * @param length the number of bytes available
+ * @param key where to place the decoded key
+ * @return the number of bytes used, or 0 if the bytes end partway through
+ *  an escape sequence
+ */
+size_t input_decode_key(const char *bytes, size_t length, Key *key) {
+  *key = KEY_NONE;
+  if ( length == 0 ) {
+    return 0;
+  }
+
+  // Escape sequences: arrows are ESC [ A-D, or ESC O A-D in application mode
+  if ( bytes[0] == ESCAPE ) {
+    if ( length == 1 ) {
+      // A lone Escape key press, or the start of a sequence yet to arrive
+      return 0;
+    }
+    if ( bytes[1] != '[' && bytes[1] != 'O' ) {
+      return 1;
+    }
+    // Skip any parameters up to the final byte of the sequence
+    size_t end = 2;
+    while ( end < length && ( isdigit((unsigned char) bytes[end])
+          || bytes[end] == ';' ) ) {
+      end++;
+    }
+    if ( end == length ) {
+      return 0;
+    }
+    switch ( bytes[end] ) {
+      case 'A': *key = KEY_UP; break;
+      case 'B': *key = KEY_DOWN; break;
+      case 'C': *key = KEY_RIGHT; break;
+      case 'D': *key = KEY_LEFT; break;
+    }
+    return end + 1;
+  }
+
+  switch ( bytes[0] ) {
+    case 'k': *key = KEY_UP; break;
+    case 'j': *key = KEY_DOWN; break;
+    case 'l': *key = KEY_RIGHT; break;
+    case 'h': *key = KEY_LEFT; break;
+    case ' ': case '\r': case '\n': case 'e': *key = KEY_EXPOSE; break;
+    case 'f': *key = KEY_FLAG; break;
+    case 'c': *key = KEY_CHORD; break;
+    case 'p': *key = KEY_ODDS; break;
+    case 'q': case CTRL_D: *key = KEY_QUIT; break;
+  }
+  return 1;
+}
+
+/**
+ * Waits for the next key the game responds to, and decodes it.
+ *
+ * @return the key pressed, or KEY_QUIT if stdin was closed
+ */
+Key input_read_key(void) {
+  while ( true ) {
+    // Decode from what's already been read, if there's a full key there
+    Key key;
+    size_t used = input_decode_key(key_buffer + key_start, key_length, &key);
+    if ( used > 0 ) {
+      key_start += used;
+      key_length -= used;
+      if ( key != KEY_NONE ) {
+        return key;
+      }
+      continue;
+    }
+
+    // Otherwise, read more, keeping any partial escape sequence
+    memmove(key_buffer, key_buffer + key_start, key_length);
+    key_start = 0;
+    if ( key_length > 0 ) {
+      // A sequence can arrive split across reads, so give the rest a moment
+      struct pollfd pending;
+      pending.fd = STDIN_FILENO;
+      pending.events = POLLIN;
+      int ready = poll(&pending, 1, ESCAPE_WAIT_MS);
+      if ( ready < 0 && errno == EINTR ) {
+        continue;
+      }
+      // Drop what's there if nothing more came, so it was a lone Escape, or
+      // if it fills the buffer without ever finishing
+      if ( ready <= 0 || key_length == KEY_BUFFER_SIZE ) {
+        key_length = 0;
+        continue;
+      }
+    }
+    ssize_t got = read(STDIN_FILENO, key_buffer + key_length,
+        KEY_BUFFER_SIZE - key_length);
+    if ( got < 0 && errno == EINTR ) {
+      continue;
+    }
+    if ( got <= 0 ) {
+      return KEY_QUIT;
+    }
+    key_length += got;
+  }
+}
@@ -0,0 +1,101 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdbool.h>
+#include "board.h"
+
+typedef enum action_enum {
+  FLAG,
+  EXPOSE
+} Action;
+
+typedef struct move_struct {
+  int x;
+  int y;
+  Action action;
+} Move;
+
+/**
+ * Keys the game responds to in raw mode. Several keys can map to the same
+ * Key: arrows and hjkl both move the cursor, for example.
+ */
+typedef enum key_enum {
+  KEY_NONE,
+  KEY_UP,
+  KEY_DOWN,
+  KEY_LEFT,
+  KEY_RIGHT,
+  KEY_EXPOSE,
+  KEY_FLAG,
+  KEY_CHORD,
+  KEY_ODDS,
+  KEY_QUIT
+} Key;
+
+/**
+ * Parses one move, like "EA1" or "fc7", from a line of text. An action letter
+ * comes first, then the column, spreadsheet style, then the row number. A
+ * newline at the end is allowed.
+ *
+ * @param board the board containing the width and height, for error checking
+ * @param line the text to parse
+ * @param move a move struct for us to place the move into
+ * @return 0 if successful, else ERR_OUT_OF_BOUNDS if the position is off the
+ *  board, or 1 if the line isn't a move.
+ */
+short input_parse_move(const Board *board, const char *line, Move *move);
+
+/**
+ * Gets a valid position on the board from the user, one line at a time.
+ * Columns are spreadsheet style (a/A, b/B, c, ..., z, aa, ab, ..., az, ba, ...)
+ * Rows are direct numbers
+ *
+ * @param board the board containing the width and height, for error checking
+ * @param move a move struct for us to place the user's move into
+ * @return true if the user made a move, false if input ran out first
+ */
+bool get_move(Board *board, Move *move);
+
+/**
+ * Puts the terminal on stdin into raw mode: keys arrive as soon as they're
+ * pressed, without being echoed or waiting for Enter. The terminal is put
+ * back the way it was when the program exits, or is killed by a signal.
+ *
+ * @return 0 if successful, else -1 if stdin isn't a terminal.
+ */
+int input_raw_enable(void);
+
+/**
+ * Puts the terminal back the way it was before input_raw_enable.
+ * Does nothing if raw mode isn't on.
+ */
+void input_raw_disable(void);
+
+/**
+ * Waits for the next key the game responds to, and decodes it. Keys are read
+ * in bulk and buffered, so a burst of key repeats is decoded without waiting
+ * on the terminal for each one.
+ *
+ * @return the key pressed, or KEY_QUIT if stdin was closed
+ */
+Key input_read_key(void);
+
+/**
+ * Decodes the next key from a buffer of bytes read from the terminal.
+ *  - Arrow keys and hjkl move the cursor
+ *  - Space, Enter, and e expose
+ *  - f flags
+ *  - c chords
+ *  - p shows or hides the chance of a mine on each tile
+ *  - q and Ctrl-D quit
+ * Bytes for anything else decode to KEY_NONE.
+ *
+ * @param bytes the bytes to decode from
+ * @param length the number of bytes available
+ * @param key where to place the decoded key
+ * @return the number of bytes used, or 0 if the bytes end partway through
+ *  an escape sequence
+ */
+size_t input_decode_key(const char *bytes, size_t length, Key *key);
+
+#endif
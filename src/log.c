@@ -0,0 +1,54 @@
+#include "log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+/** Names of each log level, indexed by LogLevel. */
+static const char *LEVEL_NAMES[] = { "trace", "debug", "info", "error", "none" };
+
+LogLevel log_level = LOG_LEVEL_INFO;
+
+/**
+ * Sets the least severe level of message that gets printed.
+ * In release builds, TRACE and DEBUG messages are compiled out, so setting the
+ * level below INFO has no effect.
+ *
+ * @param level the new log level
+ */
+void log_set_level(LogLevel level) {
+  log_level = level;
+}
+
+/**
+ * Parses a log level from its name: trace, debug, info, error, or none.
+ *
+ * @param name the name of the level
+ * @param level where to place the parsed level
+ * @return 0 if successful, else 1 if the name is unknown.
+ */
+int log_parse_level(const char *name, LogLevel *level) {
+  for ( int i = LOG_LEVEL_TRACE; i <= LOG_LEVEL_NONE; i++ ) {
+    if ( strcmp(name, LEVEL_NAMES[i]) == 0 ) {
+      *level = i;
+      return EXIT_SUCCESS;
+    }
+  }
+  return EXIT_FAILURE;
+}
+
+/**
+ * Prints one message to stderr, prefixed by its level, followed by a newline.
+ *
+ * @param level the level of this message
+ * @param format printf-style format string for the message
+ */
+void log_print(LogLevel level, const char *format, ...) {
+  fprintf(stderr, "[%s] ", LEVEL_NAMES[level]);
+  va_list args;
+  va_start(args, format);
+  vfprintf(stderr, format, args);
+  va_end(args);
+  fputc('\n', stderr);
+}
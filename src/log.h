@@ -0,0 +1,65 @@
+#ifndef LOG_H
+#define LOG_H
+
+/**
+ * Levels of log messages, from most to least verbose.
+ *  - TRACE: Step-by-step detail from inside loops.
+ *  - DEBUG: Diagnostics about what the game is doing.
+ *  - INFO: Feedback the player should see.
+ *  - ERROR: Something went wrong.
+ * Setting the level to LOG_LEVEL_NONE silences everything.
+ */
+typedef enum log_level_enum {
+  LOG_LEVEL_TRACE,
+  LOG_LEVEL_DEBUG,
+  LOG_LEVEL_INFO,
+  LOG_LEVEL_ERROR,
+  LOG_LEVEL_NONE
+} LogLevel;
+
+/** Least severe level of message that gets printed. Defaults to INFO. */
+extern LogLevel log_level;
+
+/**
+ * Sets the least severe level of message that gets printed.
+ * In release builds, TRACE and DEBUG messages are compiled out, so setting the
+ * level below INFO has no effect.
+ *
+ * @param level the new log level
+ */
+void log_set_level(LogLevel level);
+
+/**
+ * Parses a log level from its name: trace, debug, info, error, or none.
+ *
+ * @param name the name of the level
+ * @param level where to place the parsed level
+ * @return 0 if successful, else 1 if the name is unknown.
+ */
+int log_parse_level(const char *name, LogLevel *level);
+
+/**
+ * Prints one message to stderr, prefixed by its level, followed by a newline.
+ * Use the LOG_* macros instead, so the level is checked before any arguments
+ * are formatted.
+ *
+ * @param level the level of this message
+ * @param format printf-style format string for the message
+ */
+void log_print(LogLevel level, const char *format, ...);
+
+/** Logs a message at the given level, if that level is enabled. */
+#define LOG_AT(level, ...) \
+  ( ( level ) >= log_level ? log_print(( level ), __VA_ARGS__) : (void) 0 )
+
+#ifdef NDEBUG
+#define LOG_TRACE(...) ( (void) 0 )
+#define LOG_DEBUG(...) ( (void) 0 )
+#else
+#define LOG_TRACE(...) LOG_AT(LOG_LEVEL_TRACE, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#endif
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+
+#endif
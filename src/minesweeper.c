@@ -1,201 +1,807 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "board.h"
+#include "render.h"
+#include "input.h"
+#include "sim.h"
+#include "batch.h"
+#include "analyze.h"
+#include "noguess.h"
+#include "solver.h"
+#include "prob.h"
+#include "replay.h"
+#include "snapshot.h"
+#include "plane.h"
+#include "bitboard.h"
+#include "log.h"
 #include <string.h>
 #include <ctype.h>
 #include <stdbool.h>
+#include <unistd.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
 //#include <ncurses.h>
 
-typedef enum action_enum {
-  FLAG,
-  EXPOSE
-} Action;
+/**
+ * A board size and mine count that can be picked by name.
+ */
+typedef struct Preset {
+  const char *name;
+  int width;
+  int height;
+  long long mines;
+} Preset;
 
-typedef struct move_struct {
-  short x;
-  short y;
-  Action action;
-} Move;
+/** The classic difficulties. */
+static const Preset PRESETS[] = {
+  { "beginner", 9, 9, 10 },
+  { "intermediate", 16, 16, 40 },
+  { "expert", 30, 16, 99 },
+};
 
-//void get_action(Board *board, char *action) {
-//  //cbreak(); // Line buffering disabled
-//  char tmp = getch();
-//  //nocbreak(); // Enable line buffering
-//  printf("Char: [%c] (%d)\n", tmp, tmp);
-//}
+/** Number of presets. */
+#define PRESET_COUNT ( sizeof(PRESETS) / sizeof(Preset) )
 
 /**
- * Gets a valid position on the board from the user.
- * Columns are spreadsheet style (a/A, b/B, c, ..., z, aa, ab, ..., az, ba, ...)
- * Rows are direct numbers
+ * Prints how to run the game, then exits with a failure.
  *
- * @param board the board containing the width and height, for error checking
- * @param move a move struct for us to place the user's move into
+ * @param name the name the program was run with
+ */
+static void usage(const char *name) {
+  fprintf(stderr, "usage: %s [--size WIDTHxHEIGHT] [--mines N] [--seed N] [--line] [--odds]\n"
+      "    [--first-zero] [--preset beginner|intermediate|expert]\n"
+      "    [--log trace|debug|info|error|none] [--memory MIB]\n"
+      "    [--simulate GAMES [--threads N] [--policy NAME]]\n"
+      "    [--analyze BOARDS [--threads N]] [--find-no-guess BOARDS [--threads N]]\n"
+      "    [--no-guess [--cache FILE]]\n"
+      "    [--record FILE] [--replay FILE [--render-every N]]\n"
+      "    [--load FILE] [--save FILE] [--inspect FILE]\n"
+      "    [--infinite [--density PERCENT] [--chunks N] [--swap FILE]]\n", name);
+  fprintf(stderr, "  The log level can also be set with MINESWEEPER_LOG.\n");
+  fprintf(stderr, "  --first-zero places the mines after the first tile exposed,"
+      " keeping them out\n  of it and the tiles around it.\n");
+  fprintf(stderr, "  On a terminal, moves are made with the keyboard; --line reads"
+      " moves\n  one line at a time instead.\n");
+  fprintf(stderr, "  --simulate plays games headlessly, on one thread per core unless"
+      " --threads\n  is given, and reports how they went. Policies:\n");
+  sim_list_policies(stderr);
+  fprintf(stderr, "  --analyze measures the 3BV, regions of zeros, and isolated"
+      " numbers of\n  boards, and how many need a guess, with histograms."
+      " --preset picks a size and\n  mine count; given more than once,"
+      " --analyze reports each in turn.\n");
+  fprintf(stderr, "  --no-guess plays a board that can be cleared from the"
+      " opening without\n  guessing, searched for on every core. --cache"
+      " keeps verified seeds for each\n  preset in a file, refilled while the"
+      " game is played, so the next game\n  starts right away."
+      " --find-no-guess finds that many such boards in a row,\n  reporting"
+      " attempts per board and latency.\n");
+  fprintf(stderr, "  --record writes each move to a file, and --replay plays a file of"
+      " moves\n  (- for stdin) without a player, printing the board at the end,"
+      " or every\n  N moves with --render-every.\n");
+  fprintf(stderr, "  --load resumes a saved board, --save saves the board when the"
+      " game ends\n  or is quit, and --inspect checks a saved board and prints"
+      " what's in it.\n");
+  fprintf(stderr, "  Boards can be up to %dx%d, at about 2 bytes per tile, or 11"
+      " up to 16M\n  tiles to keep their regions of zeros. --memory caps how much"
+      " a board may use,\n  and defaults to the machine's memory. Boards of 4M"
+      " tiles or more are generated\n  on every core, or --threads cores.\n", BOARD_SIDE_MAX, BOARD_SIDE_MAX);
+  fprintf(stderr, "  --infinite plays on an endless board, made as it's explored,"
+      " keeping at most\n  --chunks chunks of 64x64 tiles in memory and the"
+      " rest in a swap file.\n");
+  exit(EXIT_FAILURE);
+}
+
+/** Boards with at least this many tiles are generated in bands of rows. */
+#define BANDED_TILES ( (int64_t) 1 << 22 )
+
+/**
+ * Works out the memory budget.
+ *
+ * @param budget the most bytes to use, or 0 for the machine's memory
+ * @return the budget in bytes, or 0 if there's no telling
+ */
+static unsigned long long memory_budget(unsigned long long budget) {
+  if ( budget == 0 ) {
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long page_size = sysconf(_SC_PAGE_SIZE);
+    if ( pages > 0 && page_size > 0 ) {
+      budget = (unsigned long long) pages * page_size;
+    }
+  }
+  return budget;
+}
+
+/**
+ * Checks that boards of a given size fit in the memory budget, before any
+ * time is spent making them.
+ *
+ * @param width the horizontal count of tiles across each board
+ * @param height the vertical count of tiles across each board
+ * @param boards how many boards will be in memory at once
+ * @param extra bytes each board needs beside itself, for the solver, odds or
+ *  screen working on it
+ * @param budget the most bytes they may use, or 0 for the machine's memory
+ * @return true if they fit
+ */
+static bool boards_fit(int width, int height, int boards,
+    unsigned long long extra, unsigned long long budget) {
+  budget = memory_budget(budget);
+  if ( budget == 0 ) {
+    return true;
+  }
+  size_t board = board_bytes(width, height);
+  unsigned long long bytes = board + extra;
+  if ( board == 0 || bytes > budget / boards ) {
+    LOG_ERROR("Playing on a %dx%d board needs %llu MiB, more than the %llu"
+        " MiB budget.", width, height,
+        bytes * boards >> 20, budget >> 20);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Makes the board to play on. Big boards are generated on bitplanes, split
+ * into bands of rows across threads, when there's memory for the bitplanes
+ * too. They come out exactly as they would from newBoardSeeded.
+ *
+ * @param width the horizontal count of tiles across the board
+ * @param height the vertical count of tiles across the board
+ * @param mines the number of mines to place
+ * @param seed the seed for placing mines
+ * @param threads threads to generate on, or 0 for one per core
+ * @param budget the most bytes to use, or 0 for the machine's memory
+ * @return the board, or NULL if it couldn't be made
  */
-void get_move(Board *board, Move *move) {
+static Board *make_board(int width, int height, int64_t mines, uint64_t seed,
+    int threads, unsigned long long budget) {
+  budget = memory_budget(budget);
+  size_t bits_bytes = bitboard_bytes(width, height);
+  if ( (int64_t) width * height < BANDED_TILES || bits_bytes == 0
+      || ( budget > 0 && board_bytes(width, height) > budget - bits_bytes ) ) {
+    return newBoardSeeded(width, height, mines, seed);
+  }
 
-  // SETUP
+  Board *board = newBoardUnplaced(width, height, mines);
+  Bitboard *bits = board ? newBitboard(width, height) : NULL;
+  BandPool pool;
+  if ( !bits || bands_init(&pool, threads) != EXIT_SUCCESS ) {
+    // Fall back to placing them on the board itself
+    if ( bits ) {
+      bitboard_free(bits);
+    }
+    if ( board ) {
+      board_reset(board, seed);
+    }
+    return board;
+  }
+  LOG_DEBUG("Generating the board in %d bands...", pool.threads);
+  bitboard_reset_board(bits, board, seed, &pool);
+  bands_free(&pool);
+  bitboard_free(bits);
+  return board;
+}
 
-  // Check for how many column characters we need
-  size_t column_chars;
-  if ( board -> width <= 26 ) {
-    column_chars = 1;
-  } else if ( board -> width <= 26 + 26 * 26 ) {
-    column_chars = 2;
+/**
+ * Picks the seed for a game that can be cleared without guessing: from the
+ * cache, if it has one for this preset, else by searching every core from
+ * the given seed. The cache then refills while the game is played.
+ *
+ * @param config the board to play, with the seed to search from
+ * @param cache the cache of verified seeds, or NULL to always search
+ * @param seed where to place the seed to play
+ * @return true if a seed was found
+ */
+static bool pick_no_guess(NoGuessConfig *config, NoGuessCache *cache,
+    unsigned long long *seed) {
+  uint64_t cached;
+  if ( cache && noguess_cache_take(cache, config, &cached) ) {
+    LOG_INFO("No-guess seed %llu taken from the cache.",
+        (unsigned long long) cached);
+    *seed = cached;
   } else {
-    // Assume that nobody is going to make a board more than 18278 columns wide
-    column_chars = 3;
-  }
-  // Check for how many row characters we need
-  size_t row_chars = 0;
-  int tmp_height = board -> height + 1;
-  do {
-    // Divide by 10 to chop off a digit
-    tmp_height /= 10;
-    // Add a character for the digit
-    row_chars++;
-  } while ( tmp_height != 0 );
-  printf("column_chars=%zu, row_chars=%zu\n", column_chars, row_chars);
-
-  // Set up buffers to read in positions
-  char column[column_chars + 1];
-  char row[row_chars + 1];
-  char line[32] = { 0 };
-  char extra[32] = { 0 };
-  char action_char = '\0';
-  // Create the format string
-  char format[32];
-  snprintf(format, sizeof(format), "%%c%%%zu[a-zA-Z]%%%zu[0-9]%%[^\n]",
-      column_chars, row_chars);
-  printf("Print format: %s\n", format);
-
-  // PERFORM OPERATION
-
-  bool first_time = true;
-  move -> x = -1;
-  move -> y = -1;
-  move -> action = -1;
-
-  do {
-
-    if ( !first_time ) {
-      printf("Please enter a position in the format [EF][a-zA-Z]+[0-9]+.\n");
-      int tmp_width = board -> width;
-      char last_column[column_chars + 1];
-      memset ( last_column, 0, column_chars + 1 );
-      for ( short i = column_chars - 1; i >= 0; i-- ) {
-        last_column[i] = 'A' + ( tmp_width % 26 ) - 1;
-        tmp_width /= 26;
-      }
-      printf("  Moves: [E]xpose, [F]lag. Column in A-%s, row in 0-%d.\n",
-          last_column, board -> height - 1 );
-    }
-    first_time = false;
-
-
-    memset(column, 0, column_chars + 1);
-    memset(row, 0, row_chars + 1);
-    memset(extra, 0, row_chars + 1);
-
-    // Read in one line
-    printf("Reading in one line. Make it nice!\n");
-    if ( fgets(line, sizeof(line), stdin) != line ) {
-      printf("Problem reading in line data, exiting...\n");
-      exit(EXIT_FAILURE);
-    }
-    // Check that it's less than the size limit
-    if ( line[strlen(line) - 1] != '\n' ) {
-      printf("strlen(line): %zu, line[strlen(line) - 1]: [%c]\n",
-          strlen(line), line[strlen(line)] );
-      printf("Problem: You entered too much data.\n");
-      continue; // TODO: Probably have to consume that data until line is empty
-    }
-    printf("You entered: %s\n", line);
-
-    // Use scanf to read in characters for position
-    short scanned = sscanf( line, format, &action_char, column, row, extra );
-    printf("Row: [%s] Column: [%s]\n", row, column);
-    // Check for didn't get all values
-    if ( scanned < 3 ) {
-      printf("Problem pulling row and column out (only got %d).\n", scanned);
-      continue;
-    }
-    // Check for illegal action
-    action_char = tolower(action_char);
-    if ( action_char == 'e' ) {
-      move -> action = EXPOSE;
-    } else if ( action_char == 'f' ) {
-      move -> action = FLAG;
-    } else {
-      printf("Error: Unknown action '%c'. Allowed actions: [E]xpose, [F]lag.\n",
-          action_char);
-      continue;
+    NoGuessResult result;
+    if ( noguess_find(config, &result) != EXIT_SUCCESS ) {
+      LOG_ERROR("No no-guess %dx%d board with %lld mines in %llu seeds.",
+          config -> width, config -> height, (long long) config -> mines,
+          config -> max_attempts > 0 ? config -> max_attempts
+          : NOGUESS_ATTEMPTS_MAX);
+      return false;
     }
-    // Check for extra data at end
-    printf("Extra data: [%s]\n", extra);
-    if ( strlen(extra) > 0 ) {
-      printf("Problem, extra data at end of input (got %s)\n", extra);
-      continue;
+    LOG_INFO("No-guess seed %llu found after %llu attempts in %.1f ms.",
+        (unsigned long long) result.seed, result.attempts,
+        result.seconds * 1000);
+    *seed = result.seed;
+  }
+
+  // Find the next games' seeds past this one while this game is played
+  if ( cache ) {
+    config -> seed = *seed + 1;
+    noguess_cache_refill(cache, config);
+  }
+  return true;
+}
+
+/**
+ * The chance of a mine on each tile, shaded behind the board when shown.
+ */
+typedef struct Odds {
+  bool shown;
+  Solver *solver;
+  Prob *prob;
+} Odds;
+
+/**
+ * Works out the chances again after the board changed, if they're shown.
+ * Must be called before the screen is updated, while the board's list of
+ * changes is still there to follow.
+ *
+ * @param odds the odds to refresh
+ */
+static void odds_refresh(Odds *odds) {
+  if ( !odds -> shown ) {
+    return;
+  }
+  solver_update(odds -> solver);
+  solver_solve(odds -> solver);
+  Prob *prob = odds -> prob;
+  if ( prob_update(prob) != EXIT_SUCCESS ) {
+    render_heatmap(NULL);
+    return;
+  }
+  render_heatmap(prob -> grid);
+
+  // Redraw only the tiles whose shade changed, unless too many changed to
+  // list
+  if ( prob -> changes_overflow ) {
+    prob -> board -> changes_overflow = true;
+    return;
+  }
+  for ( size_t i = 0; i < prob -> changes_len; i++ ) {
+    size_t index = prob -> changes[i];
+    if ( !render_heat_alike(prob -> changes_from[i], prob -> grid[index]) ) {
+      board_note_change(prob -> board, index);
     }
+  }
+}
 
-    // Parse out the x column number
-    move -> x = 0;
-    for ( size_t column_char_idx = 0; column_char_idx < column_chars;
-        column_char_idx++ ) {
-      // Scale up any previous digits
-      move -> x *= 26;
-      // Add in a new digit
-      move -> x += tolower( column[column_char_idx] ) - 'a';
-      printf("char: %c, tolower: %d, 'a': %d\n", column[column_char_idx],
-          tolower( column[column_char_idx] ), 'a');
+/**
+ * Shows or hides the chance of a mine on each tile. While hidden, the solver
+ * isn't kept up to date, so it reads the whole board when shown again.
+ *
+ * @param odds the odds to show or hide
+ * @param board the board being played
+ */
+static void odds_toggle(Odds *odds, Board *board) {
+  odds -> shown = !odds -> shown;
+  if ( !odds -> shown ) {
+    render_heatmap(NULL);
+    return;
+  }
+  if ( !odds -> solver ) {
+    odds -> solver = newSolver(board);
+    odds -> prob = odds -> solver ? newProb(board, odds -> solver, 0) : NULL;
+    if ( !odds -> prob ) {
+      if ( odds -> solver ) {
+        solver_free(odds -> solver);
+      }
+      odds -> solver = NULL;
+      odds -> shown = false;
+      return;
     }
+  } else {
+    solver_reset(odds -> solver);
+  }
+  odds_refresh(odds);
+}
 
-    // Parse out the y row from digits directly
-    move -> y = atoi(row) - 1;
+/**
+ * Writes a move to a file of recorded moves, in the form --replay reads.
+ *
+ * @param record the file to write to, or NULL if moves aren't being recorded
+ * @param move the move to write
+ */
+static void record_move(FILE *record, const Move *move) {
+  if ( !record ) {
+    return;
+  }
+  char column[COLUMN_NAME_MAX];
+  board_column_name(move -> x, column);
+  fprintf(record, "%c %s%d\n", move -> action == EXPOSE ? 'E' : 'F', column,
+      move -> y + 1);
+}
 
-    // Confirm what we have
-    printf("X: %d Y: %d\n", move -> x, move -> y);
+/**
+ * Plays a game on an endless plane, with the keyboard. The game goes on until
+ * a mine is exposed or the player quits, and the score is how many tiles were
+ * exposed.
+ *
+ * @param plane the plane to play on
+ */
+static void play_plane(Plane *plane) {
+  Frame frame;
+  frame_init(&frame);
+  PlaneView view = { 0, 0, 0, 0 };
+  plane_expose_safe(plane);
+  bool playing = true;
+  while ( playing ) {
+    struct winsize size = { 0 };
+    ioctl(STDOUT_FILENO, TIOCGWINSZ, &size);
+    plane_view_fit(&view, plane, size.ws_row, size.ws_col);
+    render_plane(&frame, plane, &view);
+    frame_flush(&frame, STDOUT_FILENO);
+    printf("(%lld, %lld)  %llu exposed  %zu chunks in memory, %zu in all\n",
+        (long long) plane -> cur_x, (long long) plane -> cur_y,
+        (unsigned long long) plane -> exposed, plane -> loaded,
+        plane -> chunks);
+    printf("Arrows/hjkl move, Space/e expose, f flag, c chord, q quit.\n");
+    fflush(stdout);
 
-  } while ( move -> x < 0 || move -> y < 0 || 
-      move -> x >= board -> width || move -> y >= board -> height );
+    switch ( input_read_key() ) {
+      case KEY_UP: plane -> cur_y--; break;
+      case KEY_DOWN: plane -> cur_y++; break;
+      case KEY_LEFT: plane -> cur_x--; break;
+      case KEY_RIGHT: plane -> cur_x++; break;
+      case KEY_EXPOSE:
+      case KEY_CHORD:
+        if ( plane_expose(plane, plane -> cur_x, plane -> cur_y) == LOSE_MINE ) {
+          render_plane(&frame, plane, &view);
+          frame_flush(&frame, STDOUT_FILENO);
+          printf("You lost! %llu tiles exposed.\n",
+              (unsigned long long) plane -> exposed);
+          playing = false;
+        }
+        break;
+      case KEY_FLAG:
+        plane_flag(plane, plane -> cur_x, plane -> cur_y);
+        break;
+      case KEY_QUIT:
+        playing = false;
+        break;
+      case KEY_ODDS:
+      case KEY_NONE:
+        break;
+    }
+  }
+  frame_free(&frame);
+}
 
-  // Valid position. Yay!
+/**
+ * Gets a move from the keyboard, with the terminal in raw mode. Arrow keys or
+ * hjkl move the board's cursor, redrawing the board as it goes, until the
+ * user exposes, flags, or chords the tile under the cursor.
+ *
+ * @param board the board to move the cursor around on
+ * @param screen the screen the board is drawn on
+ * @param odds the chances of mines, shown or hidden with p
+ * @param move a move struct for us to place the user's move into
+ * @return true if the user made a move, false if they quit
+ */
+static bool get_move_raw(Board *board, Screen *screen, Odds *odds,
+    Move *move) {
+  while ( true ) {
+    screen_update(screen, board);
+    printf("Arrows/hjkl move, Space/e expose, f flag, c chord, p odds,"
+        " q quit.\n");
+    fflush(stdout);
 
+    switch ( input_read_key() ) {
+      case KEY_UP:
+        board -> cur_y -= ( board -> cur_y > 0 );
+        break;
+      case KEY_DOWN:
+        board -> cur_y += ( board -> cur_y < board -> height - 1 );
+        break;
+      case KEY_LEFT:
+        board -> cur_x -= ( board -> cur_x > 0 );
+        break;
+      case KEY_RIGHT:
+        board -> cur_x += ( board -> cur_x < board -> width - 1 );
+        break;
+      // Exposing a satisfied number chords it, so both are exposes
+      case KEY_EXPOSE:
+      case KEY_CHORD:
+        move -> action = EXPOSE;
+        move -> x = board -> cur_x;
+        move -> y = board -> cur_y;
+        return true;
+      case KEY_FLAG:
+        move -> action = FLAG;
+        move -> x = board -> cur_x;
+        move -> y = board -> cur_y;
+        return true;
+      case KEY_ODDS:
+        odds_toggle(odds, board);
+        break;
+      case KEY_QUIT:
+        return false;
+      case KEY_NONE:
+        break;
+    }
+  }
 }
 
 int main(int argc, char *argv[]) {
 
+  // Pick the log level, from the environment first, then the command line
+  LogLevel level = log_level;
+  const char *env_level = getenv("MINESWEEPER_LOG");
+  if ( env_level && log_parse_level(env_level, &level) != EXIT_SUCCESS ) {
+    usage(argv[0]);
+  }
+  int width = 9;
+  int height = 10;
+  long long mines = 15;
+  bool seeded = false;
+  bool line_mode = false;
+  bool show_odds = false;
+  bool first_zero = false;
+  bool infinite = false;
+  double density = 16;
+  unsigned long max_chunks = 4096;
+  const char *swap_path = NULL;
+  unsigned long long simulate = 0;
+  unsigned long long analyze = 0;
+  unsigned long long find_no_guess = 0;
+  bool no_guess = false;
+  const char *cache_path = NULL;
+  const Preset *presets[PRESET_COUNT];
+  size_t preset_count = 0;
+  int threads = 0;
+  const Policy *policy = sim_find_policy("local");
+  unsigned long long seed = 0;
+  const char *record_path = NULL;
+  const char *replay_path = NULL;
+  unsigned long render_every = 0;
+  const char *load_path = NULL;
+  const char *save_path = NULL;
+  const char *inspect_path = NULL;
+  unsigned long long memory = 0;
+  for ( int i = 1; i < argc; i++ ) {
+    if ( strcmp(argv[i], "--seed") == 0 && i + 1 < argc ) {
+      char *end;
+      seed = strtoull(argv[++i], &end, 0);
+      if ( *end != '\0' ) {
+        usage(argv[0]);
+      }
+      seeded = true;
+    } else if ( strcmp(argv[i], "--size") == 0 && i + 1 < argc ) {
+      if ( sscanf(argv[++i], "%dx%d", &width, &height) != 2
+          || width < 1 || width > BOARD_SIDE_MAX
+          || height < 1 || height > BOARD_SIDE_MAX ) {
+        usage(argv[0]);
+      }
+    } else if ( strcmp(argv[i], "--mines") == 0 && i + 1 < argc ) {
+      if ( sscanf(argv[++i], "%lld", &mines) != 1 || mines < 0
+          || mines > (long long) BOARD_SIDE_MAX * BOARD_SIDE_MAX ) {
+        usage(argv[0]);
+      }
+    } else if ( strcmp(argv[i], "--simulate") == 0 && i + 1 < argc ) {
+      if ( sscanf(argv[++i], "%llu", &simulate) != 1 || simulate == 0 ) {
+        usage(argv[0]);
+      }
+    } else if ( strcmp(argv[i], "--analyze") == 0 && i + 1 < argc ) {
+      if ( sscanf(argv[++i], "%llu", &analyze) != 1 || analyze == 0 ) {
+        usage(argv[0]);
+      }
+    } else if ( strcmp(argv[i], "--find-no-guess") == 0 && i + 1 < argc ) {
+      if ( sscanf(argv[++i], "%llu", &find_no_guess) != 1
+          || find_no_guess == 0 ) {
+        usage(argv[0]);
+      }
+    } else if ( strcmp(argv[i], "--no-guess") == 0 ) {
+      no_guess = true;
+    } else if ( strcmp(argv[i], "--cache") == 0 && i + 1 < argc ) {
+      cache_path = argv[++i];
+    } else if ( strcmp(argv[i], "--preset") == 0 && i + 1 < argc ) {
+      const Preset *preset = NULL;
+      i++;
+      for ( size_t p = 0; p < PRESET_COUNT; p++ ) {
+        if ( strcmp(argv[i], PRESETS[p].name) == 0 ) {
+          preset = &PRESETS[p];
+        }
+      }
+      if ( !preset || preset_count == PRESET_COUNT ) {
+        usage(argv[0]);
+      }
+      presets[preset_count++] = preset;
+      width = preset -> width;
+      height = preset -> height;
+      mines = preset -> mines;
+    } else if ( strcmp(argv[i], "--threads") == 0 && i + 1 < argc ) {
+      if ( sscanf(argv[++i], "%d", &threads) != 1 || threads < 1 ) {
+        usage(argv[0]);
+      }
+    } else if ( strcmp(argv[i], "--policy") == 0 && i + 1 < argc ) {
+      if ( !( policy = sim_find_policy(argv[++i]) ) ) {
+        usage(argv[0]);
+      }
+    } else if ( strcmp(argv[i], "--record") == 0 && i + 1 < argc ) {
+      record_path = argv[++i];
+    } else if ( strcmp(argv[i], "--replay") == 0 && i + 1 < argc ) {
+      replay_path = argv[++i];
+    } else if ( strcmp(argv[i], "--render-every") == 0 && i + 1 < argc ) {
+      if ( sscanf(argv[++i], "%lu", &render_every) != 1 ) {
+        usage(argv[0]);
+      }
+    } else if ( strcmp(argv[i], "--load") == 0 && i + 1 < argc ) {
+      load_path = argv[++i];
+    } else if ( strcmp(argv[i], "--save") == 0 && i + 1 < argc ) {
+      save_path = argv[++i];
+    } else if ( strcmp(argv[i], "--inspect") == 0 && i + 1 < argc ) {
+      inspect_path = argv[++i];
+    } else if ( strcmp(argv[i], "--infinite") == 0 ) {
+      infinite = true;
+    } else if ( strcmp(argv[i], "--density") == 0 && i + 1 < argc ) {
+      if ( sscanf(argv[++i], "%lf", &density) != 1 || density < 0
+          || density >= 100 ) {
+        usage(argv[0]);
+      }
+    } else if ( strcmp(argv[i], "--chunks") == 0 && i + 1 < argc ) {
+      if ( sscanf(argv[++i], "%lu", &max_chunks) != 1 ) {
+        usage(argv[0]);
+      }
+    } else if ( strcmp(argv[i], "--swap") == 0 && i + 1 < argc ) {
+      swap_path = argv[++i];
+    } else if ( strcmp(argv[i], "--memory") == 0 && i + 1 < argc ) {
+      if ( sscanf(argv[++i], "%llu", &memory) != 1 || memory == 0 ) {
+        usage(argv[0]);
+      }
+      memory <<= 20;
+    } else if ( strcmp(argv[i], "--first-zero") == 0 ) {
+      first_zero = true;
+    } else if ( strcmp(argv[i], "--odds") == 0 ) {
+      show_odds = true;
+    } else if ( strcmp(argv[i], "--line") == 0 ) {
+      line_mode = true;
+    } else if ( strcmp(argv[i], "--log") == 0 && i + 1 < argc ) {
+      if ( log_parse_level(argv[++i], &level) != EXIT_SUCCESS ) {
+        usage(argv[0]);
+      }
+    } else {
+      usage(argv[0]);
+    }
+  }
+  log_set_level(level);
+
+  // Play on an endless board, if asked. Only the keyboard can get around it.
+  if ( infinite ) {
+    if ( !isatty(STDOUT_FILENO) || input_raw_enable() != 0 ) {
+      LOG_ERROR("--infinite needs a terminal to play on.");
+      return EXIT_FAILURE;
+    }
+    Plane *plane = newPlane(seeded ? seed : (unsigned long long) time(0),
+        density / 100, max_chunks, swap_path);
+    if ( !plane ) {
+      input_raw_disable();
+      return EXIT_FAILURE;
+    }
+    LOG_INFO("Plane seed: %llu", (unsigned long long) plane -> seed);
+    play_plane(plane);
+    input_raw_disable();
+    plane_free(plane);
+    return EXIT_SUCCESS;
+  }
+
+  // Play games headlessly instead, if asked
+  if ( simulate > 0 ) {
+    // Each worker plays on a board of its own, with no more workers than
+    // games
+    int workers = batch_threads(threads);
+    if ( (unsigned long long) workers > simulate ) {
+      workers = simulate;
+    }
+    // Each board also holds whatever the policy keeps for it
+    size_t extra = policy -> bytes ? policy -> bytes(width, height) : 0;
+    if ( !boards_fit(width, height, workers, extra, memory) ) {
+      return EXIT_FAILURE;
+    }
+    SimConfig config = { width, height, mines, seeded ? seed : time(0),
+      first_zero, simulate, threads, policy };
+    SimResult result;
+    int status = sim_run(&config, &result);
+    sim_print(&config, &result, stdout);
+    return status;
+  }
+
+  // Or measure boards, or find no-guess ones, without playing them, for each
+  // preset asked for
+  if ( analyze > 0 || find_no_guess > 0 ) {
+    // Without a preset, use the size and mines given
+    Preset custom = { "custom", width, height, mines };
+    if ( preset_count == 0 ) {
+      presets[preset_count++] = &custom;
+    }
+    // Each worker or search thread works on a board of its own, with a
+    // solver. Analysis has no more workers than boards, but every search
+    // thread takes one.
+    int workers = batch_threads(threads);
+    if ( find_no_guess == 0 && (unsigned long long) workers > analyze ) {
+      workers = analyze;
+    }
+    int status = EXIT_SUCCESS;
+    uint64_t first_seed = seeded ? seed : time(0);
+    for ( size_t p = 0; p < preset_count && status == EXIT_SUCCESS; p++ ) {
+      if ( !boards_fit(presets[p] -> width, presets[p] -> height, workers,
+          solver_bytes(presets[p] -> width, presets[p] -> height), memory) ) {
+        return EXIT_FAILURE;
+      }
+      if ( analyze > 0 ) {
+        AnalyzeConfig config = { presets[p] -> width, presets[p] -> height,
+          presets[p] -> mines, first_seed, first_zero, analyze, threads };
+        AnalyzeResult result;
+        status = analyze_run(&config, &result);
+        analyze_print(&config, &result, stdout);
+      }
+      if ( find_no_guess > 0 && status == EXIT_SUCCESS ) {
+        NoGuessConfig config = { presets[p] -> width, presets[p] -> height,
+          presets[p] -> mines, first_seed, first_zero, threads };
+        NoGuessStats stats;
+        status = noguess_run(&config, find_no_guess, &stats);
+        noguess_print(&config, &stats, stdout);
+      }
+    }
+    return status;
+  }
+
+  // Or look inside a saved board, without loading it
+  if ( inspect_path ) {
+    Snapshot snapshot;
+    if ( snapshot_map(inspect_path, &snapshot, true) != EXIT_SUCCESS ) {
+      return EXIT_FAILURE;
+    }
+    printf("%s: %dx%d with %llu mines, %llu tiles exposed, cursor at (%d, %d),"
+        " seed %llu, checksum OK\n", inspect_path, snapshot.width,
+        snapshot.height, (unsigned long long) snapshot.mineCount,
+        (unsigned long long) snapshot.exposed, snapshot.cur_x, snapshot.cur_y,
+        (unsigned long long) snapshot.seed);
+    snapshot_unmap(&snapshot);
+    return EXIT_SUCCESS;
+  }
+
+  // Or play a stream of moves
+  if ( replay_path ) {
+    int fd = strcmp(replay_path, "-") == 0 ? STDIN_FILENO
+      : open(replay_path, O_RDONLY);
+    if ( fd < 0 ) {
+      LOG_ERROR("Couldn't open %s to replay.", replay_path);
+      return EXIT_FAILURE;
+    }
+    ReplayConfig config = { width, height, mines, seeded ? seed : time(0),
+      first_zero, render_every };
+    ReplayResult result;
+    int status = replay_run(fd, &config, &result);
+    replay_print(&result, stdout);
+    if ( fd != STDIN_FILENO ) {
+      close(fd);
+    }
+    return status;
+  }
+
   //initscr();
   //clear();
   //noecho();
 
-  printf("Creating board!\n");
-  struct Board *board = newBoard( 9, 10, 15 );
-  printf("Board created, printing it out...\n");
-  board_print(board);
-  printf("Done printing out the board.\n");
+  LOG_DEBUG("Creating board!");
+  struct Board *board;
+  NoGuessCache cache = { NULL };
+  if ( no_guess && !seeded && cache_path && !load_path
+      && noguess_cache_open(&cache, cache_path) != EXIT_SUCCESS ) {
+    return EXIT_FAILURE;
+  }
+  if ( load_path ) {
+    if ( !( board = board_load(load_path) ) ) {
+      return EXIT_FAILURE;
+    }
+  } else {
+    // The board is drawn on a screen, and the odds kept for it if they're
+    // shown from the start
+    unsigned long long extra = screen_bytes(width, height);
+    if ( show_odds ) {
+      extra += solver_bytes(width, height) + prob_bytes(width, height);
+    }
+    if ( !boards_fit(width, height, 1, extra, memory) ) {
+      return EXIT_FAILURE;
+    }
+    if ( !seeded ) {
+      // Use the current time as the seed
+      seed = time(0);
+    }
+    if ( no_guess ) {
+      // Every search thread takes a board and a solver of its own
+      if ( !boards_fit(width, height, batch_threads(threads),
+          solver_bytes(width, height), memory) ) {
+        return EXIT_FAILURE;
+      }
+      NoGuessConfig config = { width, height, mines, seed, first_zero,
+        threads };
+      if ( !pick_no_guess(&config, !seeded && cache_path ? &cache : NULL,
+          &seed) ) {
+        return EXIT_FAILURE;
+      }
+    }
+    if ( first_zero ) {
+      // The mines wait for the first pick, so there's nothing to place yet
+      board = newBoardUnplaced(width, height, mines);
+      if ( board ) {
+        board -> first_zero = true;
+        board_reset(board, seed);
+      }
+    } else {
+      board = make_board(width, height, mines, seed, threads, memory);
+    }
+    if ( !board ) {
+      return EXIT_FAILURE;
+    }
+  }
+  LOG_INFO("Board seed: %llu", (unsigned long long) board -> seed);
+  Screen screen;
+  screen_init(&screen);
+  LOG_DEBUG("Board created, printing it out...");
+  screen_update(&screen, board);
+  LOG_DEBUG("Done printing out the board.");
 
-  printf("Exposing a starter block...\n");
-  board_expose_safe(board);
+  // A loaded game is already underway
+  if ( !load_path ) {
+    LOG_DEBUG("Exposing a starter block...");
+    board_expose_safe(board);
+  }
+  // Record the game, starting the same way, if asked. The moves that led to a
+  // loaded board aren't known, so it can't be recorded.
+  FILE *record = NULL;
+  if ( record_path && load_path ) {
+    LOG_ERROR("Can't record a loaded game, playing without recording.");
+  } else if ( record_path ) {
+    if ( !( record = fopen(record_path, "w") ) ) {
+      LOG_ERROR("Couldn't open %s to record moves.", record_path);
+      return EXIT_FAILURE;
+    }
+    fprintf(record, "G %d %d %lld %llu%s\nS\n", board -> width,
+        board -> height, (long long) board -> mineCount,
+        (unsigned long long) board -> seed, board -> first_zero ? " Z" : "");
+  }
   Move *move = malloc(sizeof(Move));
+  // Use the keyboard directly when playing on a terminal
+  bool raw_mode = !line_mode && isatty(STDOUT_FILENO)
+    && input_raw_enable() == 0;
+  // Shade tiles by their chance of a mine, if asked
+  Odds odds = { false, NULL, NULL };
+  if ( show_odds ) {
+    odds_toggle(&odds, board);
+  }
   
   //printf("TESTING getch\n");
   //char action = '\0';
   //get_action(board, &action);
 
   while ( true ) {
-    // Print out board
-    printf("Printing out the board again...\n");
-    board_print(board);
+    odds_refresh(&odds);
+    if ( raw_mode ) {
+      // Move the cursor around until the user picks a tile
+      if ( !get_move_raw(board, &screen, &odds, move) ) {
+        break;
+      }
+    } else {
+      // Print out board
+      LOG_DEBUG("Printing out the board again...");
+      screen_update(&screen, board);
 
-    // Request position to reveal
-    printf("Pick a position to expose.\n");
-    get_move(board, move);
+      // Request position to reveal
+      printf("Pick a position to expose.\n");
+      if ( !get_move(board, move) ) {
+        break;
+      }
+    }
 
     // Parse response
-    printf("Move: %s (%2d, %2d)\n",
+    LOG_DEBUG("Move: %s (%2d, %2d)",
         (move -> action == EXPOSE) ? "Expose" : "Flag",
         move -> x, move -> y);
+    // Move the cursor to the picked tile
+    board -> cur_x = move -> x;
+    board -> cur_y = move -> y;
+    record_move(record, move);
 
     // Check the action
     if ( move -> action == EXPOSE ) {
@@ -206,22 +812,27 @@ int main(int argc, char *argv[]) {
       if ( result == LOSE_MINE ) {
         // Player lost. Expose the board
         board_expose_all(board);
+        // Print out the board
+        screen_update(&screen, board);
         // Print out a defeat message
         printf("You lost!\n");
-        // Print out the board
-        board_print(board);
         // Exit the loop
         break;
       }
       // If the player just exposed the last non-mine
-      else if ( board -> exposed == (board -> width * board -> height
-            - board -> mineCount ) ) {
+      else if ( board -> exposed == board_safe_tiles(board) ) {
         // Player won! Expose board
         board_expose_all(board);
-        // Print out a victory message
-        printf("You win!\n");
         // Print out the board
-        board_print(board);
+        screen_update(&screen, board);
+        // Print out a victory message, and how many clicks the board takes
+        // at best if it's known
+        if ( board -> bbbv >= 0 ) {
+          printf("You win! The board's 3BV is %lld.\n",
+              (long long) board -> bbbv);
+        } else {
+          printf("You win!\n");
+        }
         // Exit the loop
         break;
       }
@@ -231,7 +842,24 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  input_raw_disable();
+  if ( save_path ) {
+    board_save(board, save_path);
+  }
+  if ( record ) {
+    fclose(record);
+  }
   free(move);
+  if ( odds.solver ) {
+    render_heatmap(NULL);
+    prob_free(odds.prob);
+    solver_free(odds.solver);
+  }
+  screen_free(&screen);
+  board_free(board);
+  if ( cache.path ) {
+    noguess_cache_close(&cache);
+  }
 
   return EXIT_SUCCESS;
 }
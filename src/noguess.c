@@ -0,0 +1,513 @@
+#include "noguess.h"
+#include "batch.h"
+#include "solver.h"
+#include "log.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/** Seeds the refill thread tries between checks for whether to stop. */
+#define REFILL_ATTEMPTS 16
+/** Seeds the cache starts with room for. */
+#define CACHE_MIN 64
+
+/**
+ * A search for a no-guess seed, shared by every thread working on it.
+ */
+typedef struct Search {
+  const NoGuessConfig *config;
+  BoardPool *pool;
+  pthread_mutex_t lock;
+  // Next seed to hand out, and one past the last one allowed
+  uint64_t next;
+  uint64_t end;
+  // Lowest seed found so far that works, or end if none has
+  uint64_t found;
+  unsigned long long checked;
+} Search;
+
+/**
+ * Tells whether a seed gives a board the solver can clear from its opening.
+ *
+ * @param board the board to try the seed on, reset for it
+ * @param solver the solver for the board
+ * @param seed the seed to try
+ * @return true if no guess is needed
+ */
+static bool check_seed(Board *board, Solver *solver, uint64_t seed) {
+  board_reset(board, seed);
+  board_expose_safe(board);
+  return solver_clear(solver);
+}
+
+/**
+ * Tries seeds for a search, one at a time, until every seed below the best
+ * one found has been taken.
+ *
+ * @param arg the Search to work on
+ * @return NULL
+ */
+static void *run_searcher(void *arg) {
+  Search *search = arg;
+  const NoGuessConfig *config = search -> config;
+  Board *board = pool_take(search -> pool, config -> width, config -> height,
+      config -> mines, config -> seed, config -> first_zero);
+  if ( !board ) {
+    return NULL;
+  }
+  Solver *solver = newSolver(board);
+  if ( !solver ) {
+    pool_give(search -> pool, board);
+    return NULL;
+  }
+
+  for ( ;; ) {
+    // Take the next seed, unless a lower one already works
+    pthread_mutex_lock(&search -> lock);
+    if ( search -> next >= search -> found ) {
+      pthread_mutex_unlock(&search -> lock);
+      break;
+    }
+    uint64_t seed = search -> next++;
+    search -> checked++;
+    pthread_mutex_unlock(&search -> lock);
+
+    if ( check_seed(board, solver, seed) ) {
+      pthread_mutex_lock(&search -> lock);
+      if ( seed < search -> found ) {
+        search -> found = seed;
+      }
+      pthread_mutex_unlock(&search -> lock);
+    }
+  }
+
+  solver_free(solver);
+  pool_give(search -> pool, board);
+  return NULL;
+}
+
+/**
+ * Finds the first seed, from the config's on, that gives a board the solver
+ * can clear from its opening without a guess. Worker threads each try the
+ * next seed not yet taken, and stop once every seed before the best one
+ * found has been tried, so the seed doesn't depend on the thread count.
+ *
+ * @param config the boards to search
+ * @param result where to place the seed found
+ * @return 0 if successful, else 1 if no seed worked within the most attempts
+ *  or the search couldn't be run
+ */
+int noguess_find(const NoGuessConfig *config, NoGuessResult *result) {
+  memset(result, 0, sizeof(NoGuessResult));
+  int threads = batch_threads(config -> threads);
+  unsigned long long attempts = config -> max_attempts > 0
+    ? config -> max_attempts : NOGUESS_ATTEMPTS_MAX;
+
+  Search search;
+  search.config = config;
+  search.pool = config -> pool;
+  search.next = config -> seed;
+  search.end = config -> seed + attempts < config -> seed ? UINT64_MAX
+    : config -> seed + attempts;
+  search.found = search.end;
+  search.checked = 0;
+  if ( pthread_mutex_init(&search.lock, NULL) != 0 ) {
+    LOG_ERROR("Couldn't set up the lock for a no-guess search.");
+    return EXIT_FAILURE;
+  }
+
+  // Without a pool to share, make one that holds every thread's board
+  BoardPool own_pool;
+  if ( !search.pool ) {
+    if ( pool_init(&own_pool, threads) != EXIT_SUCCESS ) {
+      pthread_mutex_destroy(&search.lock);
+      return EXIT_FAILURE;
+    }
+    search.pool = &own_pool;
+  }
+
+  // This thread searches too, so it starts one fewer
+  uint64_t start = batch_now_ns();
+  pthread_t *helpers = threads > 1 ? malloc(sizeof(pthread_t) * ( threads - 1 ))
+    : NULL;
+  int started = 0;
+  for ( int t = 1; t < threads && helpers; t++ ) {
+    if ( pthread_create(&helpers[started], NULL, run_searcher, &search) != 0 ) {
+      LOG_ERROR("Couldn't start search thread %d.", t);
+      break;
+    }
+    started++;
+  }
+  run_searcher(&search);
+  for ( int t = 0; t < started; t++ ) {
+    pthread_join(helpers[t], NULL);
+  }
+  result -> seconds = ( batch_now_ns() - start ) / 1e9;
+  result -> threads = started + 1;
+  result -> checked = search.checked;
+
+  free(helpers);
+  if ( search.pool == &own_pool ) {
+    pool_free(&own_pool);
+  }
+  pthread_mutex_destroy(&search.lock);
+  if ( search.found == search.end ) {
+    return EXIT_FAILURE;
+  }
+  result -> seed = search.found;
+  result -> attempts = search.found - config -> seed + 1;
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Finds a run of no-guess boards, each search starting past the last seed
+ * found, and times each one.
+ *
+ * @param config the boards to search, starting from its seed
+ * @param boards how many boards to find
+ * @param stats where to place the totals
+ * @return 0 if successful, else 1 if a search failed
+ */
+int noguess_run(const NoGuessConfig *config, unsigned long long boards,
+    NoGuessStats *stats) {
+  memset(stats, 0, sizeof(NoGuessStats));
+  uint64_t *latencies = malloc(sizeof(uint64_t) * ( boards + 1 ));
+  if ( !latencies ) {
+    LOG_ERROR("Not enough memory to time %llu boards.", boards);
+    return EXIT_FAILURE;
+  }
+
+  // Every search shares one pool, so boards are only made once
+  NoGuessConfig search = *config;
+  BoardPool own_pool;
+  if ( !search.pool ) {
+    if ( pool_init(&own_pool, batch_threads(search.threads)) != EXIT_SUCCESS ) {
+      free(latencies);
+      return EXIT_FAILURE;
+    }
+    search.pool = &own_pool;
+  }
+
+  int status = EXIT_SUCCESS;
+  uint64_t start = batch_now_ns();
+  for ( unsigned long long i = 0; i < boards; i++ ) {
+    NoGuessResult result;
+    uint64_t found_start = batch_now_ns();
+    if ( noguess_find(&search, &result) != EXIT_SUCCESS ) {
+      LOG_ERROR("No no-guess %dx%d board with %lld mines in %llu seeds from"
+          " %llu.", search.width, search.height, (long long) search.mines,
+          search.max_attempts > 0 ? search.max_attempts : NOGUESS_ATTEMPTS_MAX,
+          (unsigned long long) search.seed);
+      status = EXIT_FAILURE;
+      break;
+    }
+    latencies[i] = batch_now_ns() - found_start;
+    stats -> boards++;
+    stats -> attempts += result.attempts;
+    stats -> checked += result.checked;
+    stats -> threads = result.threads;
+    if ( result.attempts > stats -> max_attempts ) {
+      stats -> max_attempts = result.attempts;
+    }
+    search.seed = result.seed + 1;
+  }
+  stats -> seconds = ( batch_now_ns() - start ) / 1e9;
+
+  if ( stats -> boards > 0 ) {
+    batch_sort_latencies(latencies, stats -> boards);
+    stats -> p50_ms = batch_percentile(latencies, stats -> boards, 50) / 1e6;
+    stats -> p90_ms = batch_percentile(latencies, stats -> boards, 90) / 1e6;
+    stats -> p99_ms = batch_percentile(latencies, stats -> boards, 99) / 1e6;
+    stats -> max_ms = latencies[stats -> boards - 1] / 1e6;
+  }
+  free(latencies);
+  if ( search.pool == &own_pool ) {
+    pool_free(&own_pool);
+  }
+  return status;
+}
+
+/**
+ * Prints a report of a run of no-guess boards.
+ *
+ * @param config the boards that were searched
+ * @param stats the totals from finding them
+ * @param out where to print the report
+ */
+void noguess_print(const NoGuessConfig *config, const NoGuessStats *stats,
+    FILE *out) {
+  double boards = stats -> boards > 0 ? stats -> boards : 1;
+  fprintf(out, "Found %llu no-guess boards: %dx%d with %lld mines, seeds from"
+      " %llu, %d threads\n", stats -> boards, config -> width,
+      config -> height, (long long) config -> mines,
+      (unsigned long long) config -> seed, stats -> threads);
+  fprintf(out, "  Time:     %.3f s, %.1f boards/s\n", stats -> seconds,
+      stats -> seconds > 0 ? stats -> boards / stats -> seconds : 0);
+  fprintf(out, "  Attempts: %.1f seeds per board, at most %llu, %.1f tried"
+      " per board counting\n            ones other threads were already on\n",
+      stats -> attempts / boards, stats -> max_attempts,
+      stats -> checked / boards);
+  fprintf(out, "  Latency:  p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+      stats -> p50_ms, stats -> p90_ms, stats -> p99_ms, stats -> max_ms);
+}
+
+/**
+ * Tells whether a cached seed is for a preset.
+ *
+ * @param seed the cached seed
+ * @param config the preset
+ * @return true if the seed's board has the preset's size, mines, and opening
+ */
+static bool same_preset(const NoGuessSeed *seed, const NoGuessConfig *config) {
+  return seed -> width == config -> width && seed -> height == config -> height
+    && seed -> mines == config -> mines
+    && seed -> first_zero == config -> first_zero;
+}
+
+/**
+ * Adds a seed to the end of the cache, growing it if it's full.
+ *
+ * @param cache the cache to add to
+ * @param seed the seed to add
+ * @return 0 if successful, else 1 if there isn't enough memory
+ */
+static int cache_push(NoGuessCache *cache, const NoGuessSeed *seed) {
+  if ( cache -> count == cache -> capacity ) {
+    size_t capacity = cache -> capacity ? cache -> capacity * 2 : CACHE_MIN;
+    NoGuessSeed *seeds = realloc(cache -> seeds, sizeof(NoGuessSeed) * capacity);
+    if ( !seeds ) {
+      LOG_ERROR("Not enough memory to cache %zu seeds.", capacity);
+      return EXIT_FAILURE;
+    }
+    cache -> seeds = seeds;
+    cache -> capacity = capacity;
+  }
+  cache -> seeds[cache -> count++] = *seed;
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Reads the cache's seeds from a file. A file that doesn't exist yet is an
+ * empty cache.
+ *
+ * @param cache the cache to set up
+ * @param path the file the seeds are kept in
+ * @return 0 if successful, else 1 if the file couldn't be read
+ */
+int noguess_cache_open(NoGuessCache *cache, const char *path) {
+  memset(cache, 0, sizeof(NoGuessCache));
+  cache -> path = path;
+  if ( pthread_mutex_init(&cache -> lock, NULL) != 0 ) {
+    LOG_ERROR("Couldn't set up the lock for the seed cache.");
+    return EXIT_FAILURE;
+  }
+  FILE *file = fopen(path, "r");
+  if ( !file ) {
+    if ( errno == ENOENT ) {
+      return EXIT_SUCCESS;
+    }
+    LOG_ERROR("Couldn't open %s to read cached seeds.", path);
+    return EXIT_FAILURE;
+  }
+
+  // One seed per line: width, height, mines, whether the first tile is a
+  // blank, and the seed
+  NoGuessSeed seed;
+  long long mines;
+  int first_zero;
+  unsigned long long value;
+  while ( fscanf(file, "%d %d %lld %d %llu", &seed.width, &seed.height,
+      &mines, &first_zero, &value) == 5 ) {
+    seed.mines = mines;
+    seed.first_zero = first_zero;
+    seed.seed = value;
+    if ( cache_push(cache, &seed) != EXIT_SUCCESS ) {
+      break;
+    }
+  }
+  if ( !feof(file) ) {
+    LOG_ERROR("Stopped reading %s at a line that isn't a cached seed.", path);
+  }
+  fclose(file);
+  LOG_DEBUG("Read %zu cached seeds from %s.", cache -> count, path);
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Takes a seed for a preset out of the cache.
+ *
+ * @param cache the cache to take from
+ * @param config the preset, from its size, mines, and first_zero
+ * @param seed where to place the seed
+ * @return true if there was one, false if the preset has none left
+ */
+bool noguess_cache_take(NoGuessCache *cache, const NoGuessConfig *config,
+    uint64_t *seed) {
+  bool taken = false;
+  pthread_mutex_lock(&cache -> lock);
+  for ( size_t i = 0; i < cache -> count; i++ ) {
+    if ( same_preset(&cache -> seeds[i], config) ) {
+      *seed = cache -> seeds[i].seed;
+      memmove(cache -> seeds + i, cache -> seeds + i + 1,
+          sizeof(NoGuessSeed) * ( cache -> count - i - 1 ));
+      cache -> count--;
+      taken = true;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&cache -> lock);
+  return taken;
+}
+
+/**
+ * Counts the seeds cached for a preset. The caller holds the lock.
+ *
+ * @param cache the cache to count
+ * @param config the preset
+ * @param last where to place the highest seed cached for it, if any
+ * @return the number of seeds
+ */
+static size_t cached_seeds(const NoGuessCache *cache,
+    const NoGuessConfig *config, uint64_t *last) {
+  size_t count = 0;
+  for ( size_t i = 0; i < cache -> count; i++ ) {
+    if ( same_preset(&cache -> seeds[i], config) ) {
+      if ( count == 0 || cache -> seeds[i].seed > *last ) {
+        *last = cache -> seeds[i].seed;
+      }
+      count++;
+    }
+  }
+  return count;
+}
+
+/**
+ * Finds seeds for the cache's preset, a few attempts at a time on one
+ * thread, until it has enough or is told to stop.
+ *
+ * @param arg the NoGuessCache to fill
+ * @return NULL
+ */
+static void *run_refill(void *arg) {
+  NoGuessCache *cache = arg;
+  NoGuessConfig search = cache -> refill;
+  search.threads = 1;
+  search.max_attempts = REFILL_ATTEMPTS;
+  BoardPool pool;
+  if ( pool_init(&pool, 1) != EXIT_SUCCESS ) {
+    return NULL;
+  }
+  search.pool = &pool;
+
+  for ( ;; ) {
+    uint64_t last;
+    pthread_mutex_lock(&cache -> lock);
+    bool done = cache -> stopping
+      || cached_seeds(cache, &search, &last) >= NOGUESS_CACHE_SEEDS;
+    pthread_mutex_unlock(&cache -> lock);
+    if ( done ) {
+      break;
+    }
+
+    NoGuessResult result;
+    if ( noguess_find(&search, &result) != EXIT_SUCCESS ) {
+      search.seed += REFILL_ATTEMPTS;
+      continue;
+    }
+    NoGuessSeed seed = { search.width, search.height, search.mines,
+      search.first_zero, result.seed };
+    pthread_mutex_lock(&cache -> lock);
+    int status = cache_push(cache, &seed);
+    pthread_mutex_unlock(&cache -> lock);
+    if ( status != EXIT_SUCCESS ) {
+      break;
+    }
+    search.seed = result.seed + 1;
+  }
+  pool_free(&pool);
+  return NULL;
+}
+
+/**
+ * Starts a thread finding seeds for a preset until the cache has
+ * NOGUESS_CACHE_SEEDS of them. It tries one seed at a time, so it stays out
+ * of the way of a game being played.
+ *
+ * @param cache the cache to fill
+ * @param config the preset to find seeds for
+ * @return 0 if successful, else 1 if the thread couldn't be started
+ */
+int noguess_cache_refill(NoGuessCache *cache, const NoGuessConfig *config) {
+  if ( cache -> refilling ) {
+    return EXIT_SUCCESS;
+  }
+
+  // Pick up past the seeds already cached, so none are found twice
+  cache -> refill = *config;
+  uint64_t last;
+  pthread_mutex_lock(&cache -> lock);
+  if ( cached_seeds(cache, config, &last) > 0 && last >= config -> seed ) {
+    cache -> refill.seed = last + 1;
+  }
+  pthread_mutex_unlock(&cache -> lock);
+
+  if ( pthread_create(&cache -> refill_thread, NULL, run_refill, cache) != 0 ) {
+    LOG_ERROR("Couldn't start a thread to refill the seed cache.");
+    return EXIT_FAILURE;
+  }
+  cache -> refilling = true;
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Stops the refill thread, writes the seeds back to the file, and frees the
+ * cache.
+ *
+ * @param cache the cache to close
+ * @return 0 if successful, else 1 if the file couldn't be written
+ */
+int noguess_cache_close(NoGuessCache *cache) {
+  if ( cache -> refilling ) {
+    pthread_mutex_lock(&cache -> lock);
+    cache -> stopping = true;
+    pthread_mutex_unlock(&cache -> lock);
+    pthread_join(cache -> refill_thread, NULL);
+    cache -> refilling = false;
+  }
+
+  // Write a new file beside the old one, then swap it in, so a crash partway
+  // through never leaves half a cache
+  int status = EXIT_FAILURE;
+  size_t length = strlen(cache -> path);
+  char *temp_path = malloc(length + 5);
+  FILE *file = NULL;
+  if ( temp_path ) {
+    memcpy(temp_path, cache -> path, length);
+    memcpy(temp_path + length, ".tmp", 5);
+    file = fopen(temp_path, "w");
+  }
+  if ( file ) {
+    for ( size_t i = 0; i < cache -> count; i++ ) {
+      const NoGuessSeed *seed = &cache -> seeds[i];
+      fprintf(file, "%d %d %lld %d %llu\n", seed -> width, seed -> height,
+          (long long) seed -> mines, seed -> first_zero,
+          (unsigned long long) seed -> seed);
+    }
+    if ( fclose(file) == 0 && rename(temp_path, cache -> path) == 0 ) {
+      LOG_DEBUG("Wrote %zu cached seeds to %s.", cache -> count,
+          cache -> path);
+      status = EXIT_SUCCESS;
+    }
+  }
+  if ( status != EXIT_SUCCESS ) {
+    LOG_ERROR("Couldn't write cached seeds to %s.", cache -> path);
+  }
+
+  free(temp_path);
+  free(cache -> seeds);
+  cache -> seeds = NULL;
+  cache -> count = 0;
+  pthread_mutex_destroy(&cache -> lock);
+  return status;
+}
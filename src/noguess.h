@@ -0,0 +1,182 @@
+#ifndef NOGUESS_H
+#define NOGUESS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "board.h"
+#include "pool.h"
+
+/** Seeds a search tries before giving up, unless it's told otherwise. */
+#define NOGUESS_ATTEMPTS_MAX 100000
+/** Seeds the cache keeps ready for each preset. */
+#define NOGUESS_CACHE_SEEDS 16
+
+/**
+ * Settings for finding boards that can be cleared without guessing: boards
+ * where, after board_expose_safe opens them the way a game does, the solver
+ * can prove every safe tile. Seeds are tried in order from seed, so the same
+ * settings always find the same board.
+ */
+typedef struct NoGuessConfig {
+  int width;
+  int height;
+  int64_t mines;
+  uint64_t seed;
+  // Whether the mines wait for the first tile exposed, so it's a blank
+  bool first_zero;
+  // Worker threads to try seeds on, or 0 for one per core
+  int threads;
+  // Most seeds to try for one board, or 0 for NOGUESS_ATTEMPTS_MAX
+  unsigned long long max_attempts;
+  // Pool to take boards from and give them back to, or NULL for one just
+  // for this search
+  BoardPool *pool;
+} NoGuessConfig;
+
+/**
+ * The board a search found, and what it took.
+ */
+typedef struct NoGuessResult {
+  // The first seed from the config's that gives a no-guess board
+  uint64_t seed;
+  // Seeds up to and including that one, which is how many a search on one
+  // thread would have tried
+  unsigned long long attempts;
+  // Seeds actually tried, counting the ones past the winner that other
+  // threads were already trying
+  unsigned long long checked;
+  int threads;
+  double seconds;
+} NoGuessResult;
+
+/**
+ * Totals from finding a run of no-guess boards, one after another.
+ */
+typedef struct NoGuessStats {
+  unsigned long long boards;
+  // Seeds tried per board found, in all and at most
+  unsigned long long attempts;
+  unsigned long long max_attempts;
+  unsigned long long checked;
+  int threads;
+  double seconds;
+  // Time to find each board, in milliseconds, at the 50th, 90th, and 99th
+  // percentiles and the slowest
+  double p50_ms;
+  double p90_ms;
+  double p99_ms;
+  double max_ms;
+} NoGuessStats;
+
+/**
+ * One seed in the cache, and the preset it's verified for.
+ */
+typedef struct NoGuessSeed {
+  int width;
+  int height;
+  int64_t mines;
+  bool first_zero;
+  uint64_t seed;
+} NoGuessSeed;
+
+/**
+ * Seeds already verified to give no-guess boards, for any number of presets,
+ * kept in a file between games. A game takes a seed to start right away, and
+ * a thread finds more for its preset while the game is played, so the next
+ * game can start right away too.
+ */
+typedef struct NoGuessCache {
+  // File the seeds are kept in
+  const char *path;
+  NoGuessSeed *seeds;
+  size_t count;
+  size_t capacity;
+  // Guards the seeds while the refill thread runs
+  pthread_mutex_t lock;
+  // Thread finding more seeds, and the preset it's finding them for
+  pthread_t refill_thread;
+  bool refilling;
+  bool stopping;
+  NoGuessConfig refill;
+} NoGuessCache;
+
+
+/**
+ * Finds the first seed, from the config's on, that gives a board the solver
+ * can clear from its opening without a guess. Worker threads each try the
+ * next seed not yet taken, and stop once every seed before the best one
+ * found has been tried, so the seed doesn't depend on the thread count.
+ *
+ * @param config the boards to search
+ * @param result where to place the seed found
+ * @return 0 if successful, else 1 if no seed worked within the most attempts
+ *  or the search couldn't be run
+ */
+int noguess_find(const NoGuessConfig *config, NoGuessResult *result);
+
+/**
+ * Finds a run of no-guess boards, each search starting past the last seed
+ * found, and times each one.
+ *
+ * @param config the boards to search, starting from its seed
+ * @param boards how many boards to find
+ * @param stats where to place the totals
+ * @return 0 if successful, else 1 if a search failed
+ */
+int noguess_run(const NoGuessConfig *config, unsigned long long boards,
+    NoGuessStats *stats);
+
+/**
+ * Prints a report of a run of no-guess boards.
+ *
+ * @param config the boards that were searched
+ * @param stats the totals from finding them
+ * @param out where to print the report
+ */
+void noguess_print(const NoGuessConfig *config, const NoGuessStats *stats,
+    FILE *out);
+
+/**
+ * Reads the cache's seeds from a file. A file that doesn't exist yet is an
+ * empty cache.
+ *
+ * @param cache the cache to set up
+ * @param path the file the seeds are kept in
+ * @return 0 if successful, else 1 if the file couldn't be read
+ */
+int noguess_cache_open(NoGuessCache *cache, const char *path);
+
+/**
+ * Takes a seed for a preset out of the cache.
+ *
+ * @param cache the cache to take from
+ * @param config the preset, from its size, mines, and first_zero
+ * @param seed where to place the seed
+ * @return true if there was one, false if the preset has none left
+ */
+bool noguess_cache_take(NoGuessCache *cache, const NoGuessConfig *config,
+    uint64_t *seed);
+
+/**
+ * Starts a thread finding seeds for a preset until the cache has
+ * NOGUESS_CACHE_SEEDS of them. It tries one seed at a time, so it stays out
+ * of the way of a game being played.
+ *
+ * @param cache the cache to fill
+ * @param config the preset to find seeds for
+ * @return 0 if successful, else 1 if the thread couldn't be started
+ */
+int noguess_cache_refill(NoGuessCache *cache, const NoGuessConfig *config);
+
+/**
+ * Stops the refill thread, writes the seeds back to the file, and frees the
+ * cache.
+ *
+ * @param cache the cache to close
+ * @return 0 if successful, else 1 if the file couldn't be written
+ */
+int noguess_cache_close(NoGuessCache *cache);
+
+#endif
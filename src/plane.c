@@ -0,0 +1,695 @@
+#define _XOPEN_SOURCE 700
+
+#include "plane.h"
+#include "rng.h"
+#include "log.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/** Starting number of hash buckets. Doubles when chunks outnumber them 2 to 1. */
+#define PLANE_BUCKETS_MIN 256
+/** Starting number of entries in the fill queue. */
+#define PLANE_FILL_MIN 4096
+/** Rings of tiles searched around the cursor for a safe start. */
+#define PLANE_SAFE_RADIUS 256
+
+/**
+ * Mixes the bits of a number thoroughly: the splitmix64 finalizer.
+ *
+ * @param z the number to mix
+ * @return the mixed number
+ */
+static uint64_t mix64(uint64_t z) {
+  z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+  z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+  return z ^ ( z >> 31 );
+}
+
+/** @return a hash of a chunk position */
+static uint64_t chunk_hash(int64_t cx, int64_t cy) {
+  return mix64((uint64_t) cx * 0x9E3779B97F4A7C15ULL ^ (uint64_t) cy);
+}
+
+/**
+ * Finds the chunk a tile position falls in, along one axis. Rounds down, so
+ * chunk -1 holds positions -PLANE_CHUNK to -1.
+ *
+ * @param position the tile position
+ * @return the chunk position
+ */
+static inline int64_t chunk_of(int64_t position) {
+  return position >= 0 ? position >> PLANE_CHUNK_BITS
+    : -( ( -( position + 1 ) ) >> PLANE_CHUNK_BITS ) - 1;
+}
+
+/**
+ * Places a chunk's mines, the same way every time for the same seed and
+ * chunk, with Floyd's sampling like place_mines.
+ *
+ * @param plane the plane the chunk is on
+ * @param cx the x position of the chunk
+ * @param cy the y position of the chunk
+ * @param mines where to mark each tile with a mine, row by row
+ */
+static void chunk_mines(const Plane *plane, int64_t cx, int64_t cy,
+    unsigned char mines[PLANE_CHUNK_TILES]) {
+  memset(mines, 0, PLANE_CHUNK_TILES);
+  Rng rng;
+  rng_seed(&rng, plane -> seed ^ chunk_hash(cx, cy));
+  for ( size_t j = PLANE_CHUNK_TILES - plane -> chunk_mines;
+      j < PLANE_CHUNK_TILES; j++ ) {
+    size_t pick = rng_below(&rng, j + 1);
+    mines[mines[pick] ? j : pick] = 1;
+  }
+}
+
+/**
+ * Makes a chunk's tiles from the seed: its mines, and for every tile, the
+ * mines around it, counting the edges of the chunks next to it.
+ *
+ * @param plane the plane the chunk is on
+ * @param chunk the chunk to fill in, with its tiles allocated
+ */
+static void chunk_generate(Plane *plane, Chunk *chunk) {
+  // Mines in the chunk, inside a ring of the mines just past its edges
+  enum { SIDE = PLANE_CHUNK + 2 };
+  unsigned char grid[SIDE * SIDE];
+  unsigned char mines[PLANE_CHUNK_TILES];
+  memset(grid, 0, sizeof(grid));
+  for ( int dy = -1; dy <= 1; dy++ ) {
+    for ( int dx = -1; dx <= 1; dx++ ) {
+      chunk_mines(plane, chunk -> cx + dx, chunk -> cy + dy, mines);
+      // Only the rows and columns that land in the grid are copied
+      int y_from = dy < 0 ? PLANE_CHUNK - 1 : 0;
+      int y_to = dy > 0 ? 1 : PLANE_CHUNK;
+      int x_from = dx < 0 ? PLANE_CHUNK - 1 : 0;
+      int x_to = dx > 0 ? 1 : PLANE_CHUNK;
+      for ( int y = y_from; y < y_to; y++ ) {
+        for ( int x = x_from; x < x_to; x++ ) {
+          int gy = dy * PLANE_CHUNK + y + 1;
+          int gx = dx * PLANE_CHUNK + x + 1;
+          grid[gy * SIDE + gx] = mines[y * PLANE_CHUNK + x];
+        }
+      }
+    }
+  }
+
+  // Count the mines around each tile
+  for ( int y = 0; y < PLANE_CHUNK; y++ ) {
+    const unsigned char *up = grid + y * SIDE + 1;
+    const unsigned char *row = up + SIDE;
+    const unsigned char *down = row + SIDE;
+    Tile *tiles = chunk -> tiles + y * PLANE_CHUNK;
+    for ( int x = 0; x < PLANE_CHUNK; x++ ) {
+      int count = up[x - 1] + up[x] + up[x + 1] + row[x - 1] + row[x + 1] +
+        down[x - 1] + down[x] + down[x + 1];
+      tiles[x] = count | ( row[x] ? TILE_MINE : 0 );
+    }
+  }
+  plane -> generated++;
+}
+
+/**
+ * Doubles the number of hash buckets, and moves every chunk to its new one.
+ * Without memory for them, the chunks stay where they are, in longer chains.
+ *
+ * @param plane the plane to grow the map of
+ */
+static void grow_buckets(Plane *plane) {
+  size_t count = plane -> bucket_count * 2;
+  Chunk **buckets = calloc(count, sizeof(Chunk *));
+  if ( !buckets ) {
+    LOG_DEBUG("No memory to grow the chunk map to %zu buckets.", count);
+    return;
+  }
+  for ( size_t i = 0; i < plane -> bucket_count; i++ ) {
+    Chunk *chunk = plane -> buckets[i];
+    while ( chunk ) {
+      Chunk *next = chunk -> next;
+      size_t bucket = chunk_hash(chunk -> cx, chunk -> cy) & ( count - 1 );
+      chunk -> next = buckets[bucket];
+      buckets[bucket] = chunk;
+      chunk = next;
+    }
+  }
+  free(plane -> buckets);
+  plane -> buckets = buckets;
+  plane -> bucket_count = count;
+}
+
+/**
+ * Saves a chunk's tiles to the swap file, opening it if this is the first
+ * time. Each chunk keeps the same spot in the file once it has one.
+ *
+ * @param plane the plane the chunk is on
+ * @param chunk the chunk to save
+ * @return true if it was saved
+ */
+static bool swap_out(Plane *plane, Chunk *chunk) {
+  if ( !plane -> swap ) {
+    plane -> swap = plane -> swap_path ? fopen(plane -> swap_path, "w+b")
+      : tmpfile();
+    if ( !plane -> swap ) {
+      LOG_ERROR("Couldn't open a swap file, keeping every chunk in memory.");
+      plane -> max_loaded = 0;
+      return false;
+    }
+  }
+  if ( chunk -> offset < 0 ) {
+    chunk -> offset = plane -> swap_end;
+    plane -> swap_end += PLANE_CHUNK_TILES;
+  }
+  if ( fseek(plane -> swap, chunk -> offset, SEEK_SET) != 0 ||
+      fwrite(chunk -> tiles, 1, PLANE_CHUNK_TILES, plane -> swap) !=
+      PLANE_CHUNK_TILES ) {
+    LOG_ERROR("Couldn't write to the swap file, keeping every chunk in memory.");
+    plane -> max_loaded = 0;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Reads a chunk's tiles back from the swap file.
+ *
+ * @param plane the plane the chunk is on
+ * @param chunk the chunk to read, with its tiles allocated
+ */
+static void swap_in(Plane *plane, Chunk *chunk) {
+  if ( fseek(plane -> swap, chunk -> offset, SEEK_SET) != 0 ||
+      fread(chunk -> tiles, 1, PLANE_CHUNK_TILES, plane -> swap) !=
+      PLANE_CHUNK_TILES ) {
+    LOG_ERROR("Couldn't read chunk (%lld, %lld) from the swap file.",
+        (long long) chunk -> cx, (long long) chunk -> cy);
+    exit(EXIT_FAILURE);
+  }
+  plane -> swapped_in++;
+}
+
+/**
+ * Takes a chunk out of the hash map and frees it.
+ *
+ * @param plane the plane the chunk is on
+ * @param chunk the chunk to remove
+ */
+static void remove_chunk(Plane *plane, Chunk *chunk) {
+  size_t bucket = chunk_hash(chunk -> cx, chunk -> cy) &
+    ( plane -> bucket_count - 1 );
+  Chunk **link = &plane -> buckets[bucket];
+  while ( *link != chunk ) {
+    link = &( *link ) -> next;
+  }
+  *link = chunk -> next;
+  free(chunk -> tiles);
+  free(chunk);
+  plane -> chunks--;
+}
+
+/**
+ * Sorts chunks by when they were last looked at, for qsort.
+ */
+static int compare_used(const void *a, const void *b) {
+  uint64_t first = ( *(Chunk * const *) a ) -> used;
+  uint64_t second = ( *(Chunk * const *) b ) -> used;
+  return ( first > second ) - ( first < second );
+}
+
+/**
+ * Takes one chunk's tiles out of memory.
+ *
+ * @param plane the plane the chunk is on
+ * @param chunk the chunk to evict, with its tiles in memory
+ * @return true if it was evicted, false if it couldn't be saved
+ */
+static bool evict_chunk(Plane *plane, Chunk *chunk) {
+  if ( chunk == plane -> last ) {
+    plane -> last = NULL;
+  }
+  // Untouched chunks can be made again, so they're just dropped
+  if ( !chunk -> touched ) {
+    remove_chunk(plane, chunk);
+  } else if ( swap_out(plane, chunk) ) {
+    free(chunk -> tiles);
+    chunk -> tiles = NULL;
+  } else {
+    return false;
+  }
+  plane -> loaded--;
+  plane -> evicted++;
+  return true;
+}
+
+/**
+ * Evicts the chunks looked at least recently, down to a target, so eviction
+ * happens in batches. Chunks looked at during the current tick stay.
+ *
+ * @param plane the plane to evict chunks from
+ * @param target the most chunks to leave in memory
+ */
+static void evict(Plane *plane, size_t target) {
+  // Gather every chunk that can go, oldest first
+  Chunk **candidates = malloc(sizeof(Chunk *) * plane -> loaded);
+  if ( !candidates ) {
+    // Without room to sort them, evict in the order they're found
+    for ( size_t i = 0; i < plane -> bucket_count; i++ ) {
+      Chunk *chunk = plane -> buckets[i];
+      while ( chunk && plane -> loaded > target ) {
+        Chunk *next = chunk -> next;
+        if ( chunk -> tiles && chunk -> used != plane -> tick
+            && !evict_chunk(plane, chunk) ) {
+          return;
+        }
+        chunk = next;
+      }
+    }
+    return;
+  }
+  size_t count = 0;
+  for ( size_t i = 0; i < plane -> bucket_count; i++ ) {
+    for ( Chunk *chunk = plane -> buckets[i]; chunk; chunk = chunk -> next ) {
+      if ( chunk -> tiles && chunk -> used != plane -> tick ) {
+        candidates[count++] = chunk;
+      }
+    }
+  }
+  qsort(candidates, count, sizeof(Chunk *), compare_used);
+
+  for ( size_t i = 0; i < count && plane -> loaded > target; i++ ) {
+    if ( !evict_chunk(plane, candidates[i]) ) {
+      break;
+    }
+  }
+  LOG_DEBUG("Evicted down to %zu chunks in memory, %zu in all.",
+      plane -> loaded, plane -> chunks);
+  free(candidates);
+}
+
+/**
+ * Allocates memory for a chunk. If there isn't any, evicts half the chunks in
+ * memory to make some, and exits if that doesn't help, since the plane can't
+ * go on without the chunk.
+ *
+ * @param plane the plane the chunk is on
+ * @param count how many items to allocate
+ * @param size the size of each item, zeroed
+ * @return the memory
+ */
+static void *chunk_alloc(Plane *plane, size_t count, size_t size) {
+  void *memory = calloc(count, size);
+  if ( !memory && plane -> loaded > 0 ) {
+    evict(plane, plane -> loaded / 2);
+    memory = calloc(count, size);
+  }
+  if ( !memory ) {
+    LOG_ERROR("Out of memory with %zu chunks in memory, %zu in all.",
+        plane -> loaded, plane -> chunks);
+    exit(EXIT_FAILURE);
+  }
+  return memory;
+}
+
+/**
+ * Finds a chunk, adding it to the map and making or reading back its tiles
+ * if needed.
+ *
+ * @param plane the plane to look on
+ * @param cx the x position of the chunk
+ * @param cy the y position of the chunk
+ * @return the chunk, with its tiles in memory
+ */
+static Chunk *find_chunk(Plane *plane, int64_t cx, int64_t cy) {
+  Chunk *chunk = plane -> last;
+  if ( chunk && chunk -> cx == cx && chunk -> cy == cy ) {
+    chunk -> used = plane -> tick;
+    return chunk;
+  }
+
+  // Look it up, or add it
+  size_t bucket = chunk_hash(cx, cy) & ( plane -> bucket_count - 1 );
+  for ( chunk = plane -> buckets[bucket]; chunk; chunk = chunk -> next ) {
+    if ( chunk -> cx == cx && chunk -> cy == cy ) {
+      break;
+    }
+  }
+  if ( !chunk ) {
+    chunk = chunk_alloc(plane, 1, sizeof(Chunk));
+    chunk -> cx = cx;
+    chunk -> cy = cy;
+    chunk -> offset = -1;
+    chunk -> next = plane -> buckets[bucket];
+    plane -> buckets[bucket] = chunk;
+    plane -> chunks++;
+    if ( plane -> chunks > 2 * plane -> bucket_count ) {
+      grow_buckets(plane);
+    }
+  }
+  chunk -> used = plane -> tick;
+  plane -> last = chunk;
+
+  // Bring its tiles into memory, making room if there's a limit
+  if ( !chunk -> tiles ) {
+    chunk -> tiles = chunk_alloc(plane, PLANE_CHUNK_TILES, 1);
+    if ( chunk -> offset >= 0 ) {
+      swap_in(plane, chunk);
+    } else {
+      chunk_generate(plane, chunk);
+    }
+    plane -> loaded++;
+    if ( plane -> max_loaded > 0 && plane -> loaded > plane -> max_loaded ) {
+      evict(plane, plane -> max_loaded - plane -> max_loaded / 4);
+      plane -> last = chunk;
+    }
+  }
+  return chunk;
+}
+
+/**
+ * Gets a tile on the plane, and the chunk it's in.
+ *
+ * @param plane the plane to get a tile from
+ * @param x the x position of the tile
+ * @param y the y position of the tile
+ * @param chunk where to place the chunk the tile is in
+ * @return a pointer to the tile
+ */
+static inline Tile *tile_at(Plane *plane, int64_t x, int64_t y,
+    Chunk **chunk) {
+  int64_t cx = chunk_of(x);
+  int64_t cy = chunk_of(y);
+  *chunk = find_chunk(plane, cx, cy);
+  size_t local = ( y - cy * PLANE_CHUNK ) * PLANE_CHUNK + ( x - cx * PLANE_CHUNK );
+  return ( *chunk ) -> tiles + local;
+}
+
+/**
+ * Constructor for a Plane.
+ *
+ * @param seed the seed for placing mines
+ * @param density the fraction of tiles that are mines, from 0 to 1
+ * @param max_loaded the most chunks to keep in memory, or 0 for no limit
+ * @param swap_path the file to save evicted chunks to, or NULL to pick one in
+ *  the temporary directory
+ * @return the newly created Plane, or NULL if there isn't enough memory
+ */
+Plane *newPlane(uint64_t seed, double density, size_t max_loaded,
+    const char *swap_path) {
+  Plane *plane = calloc(1, sizeof(Plane));
+  Chunk **buckets = calloc(PLANE_BUCKETS_MIN, sizeof(Chunk *));
+  Point *fill_queue = malloc(sizeof(Point) * PLANE_FILL_MIN);
+  char *path = swap_path ? strdup(swap_path) : NULL;
+  if ( !plane || !buckets || !fill_queue || ( swap_path && !path ) ) {
+    LOG_ERROR("Not enough memory for a plane.");
+    free(plane);
+    free(buckets);
+    free(fill_queue);
+    free(path);
+    return NULL;
+  }
+  plane -> seed = seed;
+  // Every chunk needs somewhere safe to start
+  int mines = density * PLANE_CHUNK_TILES + 0.5;
+  plane -> chunk_mines = mines < 0 ? 0 : mines >= PLANE_CHUNK_TILES
+    ? PLANE_CHUNK_TILES - 1 : mines;
+  plane -> bucket_count = PLANE_BUCKETS_MIN;
+  plane -> buckets = buckets;
+  // Evicting makes room in batches, and can't evict what one move is using
+  plane -> max_loaded = max_loaded > 0 && max_loaded < 16 ? 16 : max_loaded;
+  plane -> swap_path = path;
+  plane -> fill_capacity = PLANE_FILL_MIN;
+  plane -> fill_queue = fill_queue;
+  LOG_DEBUG("Plane with %d mines per chunk, seed %llu.", plane -> chunk_mines,
+      (unsigned long long) seed);
+  return plane;
+}
+
+/**
+ * Frees a Plane and everything it holds, and removes its swap file.
+ *
+ * @param plane the plane to free
+ */
+void plane_free(Plane *plane) {
+  for ( size_t i = 0; i < plane -> bucket_count; i++ ) {
+    Chunk *chunk = plane -> buckets[i];
+    while ( chunk ) {
+      Chunk *next = chunk -> next;
+      free(chunk -> tiles);
+      free(chunk);
+      chunk = next;
+    }
+  }
+  if ( plane -> swap ) {
+    fclose(plane -> swap);
+    if ( plane -> swap_path ) {
+      remove(plane -> swap_path);
+    }
+  }
+  free(plane -> buckets);
+  free(plane -> swap_path);
+  free(plane -> fill_queue);
+  free(plane);
+}
+
+/**
+ * Gets a tile on the plane, making its chunk if needed. The pointer stays
+ * good until the next call to any plane function.
+ *
+ * @param plane the plane to get a tile from
+ * @param x the x position of the tile
+ * @param y the y position of the tile
+ * @return a pointer to the tile
+ */
+Tile *plane_tile(Plane *plane, int64_t x, int64_t y) {
+  plane -> tick++;
+  Chunk *chunk;
+  return tile_at(plane, x, y, &chunk);
+}
+
+/**
+ * Counts the nearby flags and blanks of a tile, within the current tick.
+ *
+ * @param plane the plane the tile is on
+ * @param x the x position of the tile
+ * @param y the y position of the tile
+ * @param flags where to place the number of nearby flags
+ * @param blanks where to place the number of nearby blanks
+ */
+static void count_around(Plane *plane, int64_t x, int64_t y, int *flags,
+    int *blanks) {
+  Chunk *chunk;
+  *flags = 0;
+  *blanks = 0;
+  for ( int dy = -1; dy <= 1; dy++ ) {
+    for ( int dx = -1; dx <= 1; dx++ ) {
+      if ( dx == 0 && dy == 0 ) {
+        continue;
+      }
+      Tile near = *tile_at(plane, x + dx, y + dy, &chunk);
+      *flags += tile_is_flagged(near);
+      *blanks += !tile_is_flagged(near) && !tile_is_exposed(near);
+    }
+  }
+}
+
+/**
+ * Counts the nearby flags and blanks of a tile: tiles neither exposed nor
+ * flagged.
+ *
+ * @param plane the plane the tile is on
+ * @param x the x position of the tile
+ * @param y the y position of the tile
+ * @param flags where to place the number of nearby flags
+ * @param blanks where to place the number of nearby blanks
+ */
+void plane_around(Plane *plane, int64_t x, int64_t y, int *flags,
+    int *blanks) {
+  plane -> tick++;
+  count_around(plane, x, y, flags, blanks);
+}
+
+/**
+ * Adds a blank tile to the fill queue, growing it if it's full.
+ *
+ * @param plane the plane being filled
+ * @param length the number of tiles in the queue, updated
+ * @param x the x position of the tile
+ * @param y the y position of the tile
+ * @return true if it was added, false if the queue couldn't grow
+ */
+static bool fill_push(Plane *plane, size_t *length, int64_t x, int64_t y) {
+  if ( *length == plane -> fill_capacity ) {
+    size_t capacity = plane -> fill_capacity * 2;
+    Point *queue = realloc(plane -> fill_queue, sizeof(Point) * capacity);
+    if ( !queue ) {
+      LOG_DEBUG("No memory to grow the fill queue to %zu tiles.", capacity);
+      return false;
+    }
+    plane -> fill_queue = queue;
+    plane -> fill_capacity = capacity;
+  }
+  plane -> fill_queue[*length].x = x;
+  plane -> fill_queue[*length].y = y;
+  ( *length )++;
+  return true;
+}
+
+/**
+ * Exposes a tile that's neither exposed nor flagged. If it's a blank with no
+ * mines around it, exposes the whole region of blanks it's part of, up to
+ * PLANE_FILL_MAX tiles.
+ *
+ * @param plane the plane the tile is on
+ * @param x the x position of the tile
+ * @param y the y position of the tile
+ * @return 0 if successful, else LOSE_MINE
+ */
+static short expose_tile(Plane *plane, int64_t x, int64_t y) {
+  Chunk *chunk;
+  Tile *tile = tile_at(plane, x, y, &chunk);
+  *tile |= TILE_EXPOSED;
+  chunk -> touched = true;
+  plane -> exposed++;
+  if ( tile_is_mine(*tile) ) {
+    return LOSE_MINE;
+  }
+  if ( tile_count(*tile) > 0 ) {
+    return EXIT_SUCCESS;
+  }
+
+  // Expose outward from the blank, one neighbor at a time
+  size_t length = 0;
+  size_t exposed = 1;
+  bool queued = fill_push(plane, &length, x, y);
+  while ( length > 0 && exposed < PLANE_FILL_MAX && queued ) {
+    Point point = plane -> fill_queue[--length];
+    for ( int dy = -1; dy <= 1; dy++ ) {
+      for ( int dx = -1; dx <= 1; dx++ ) {
+        Tile *near = tile_at(plane, point.x + dx, point.y + dy, &chunk);
+        if ( tile_is_exposed(*near) || tile_is_flagged(*near) ) {
+          continue;
+        }
+        *near |= TILE_EXPOSED;
+        chunk -> touched = true;
+        plane -> exposed++;
+        exposed++;
+        if ( tile_count(*near) == 0 && queued ) {
+          queued = fill_push(plane, &length, point.x + dx, point.y + dy);
+        }
+      }
+    }
+  }
+  if ( length > 0 || !queued ) {
+    LOG_INFO("Stopped after exposing %zu tiles; expose again to go on.",
+        exposed);
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Exposes one tile on the plane, like board_expose_pick. Blanks expose all
+ * the tiles around them, and exposing a number with as many flags around it
+ * exposes its other neighbors.
+ *
+ * @param plane the plane to expose a tile on
+ * @param x the x position of the tile
+ * @param y the y position of the tile
+ * @return 0 if successful, else LOSE_MINE or INVALID_FLAGGED
+ */
+short plane_expose(Plane *plane, int64_t x, int64_t y) {
+  plane -> tick++;
+  Chunk *chunk;
+  Tile tile = *tile_at(plane, x, y, &chunk);
+  if ( tile_is_flagged(tile) ) {
+    return INVALID_FLAGGED;
+  }
+  if ( !tile_is_exposed(tile) ) {
+    return expose_tile(plane, x, y);
+  }
+  if ( tile_count(tile) == 0 ) {
+    // A region cut short by PLANE_FILL_MAX goes on from any of its blanks
+    for ( int dy = -1; dy <= 1; dy++ ) {
+      for ( int dx = -1; dx <= 1; dx++ ) {
+        Tile near = *tile_at(plane, x + dx, y + dy, &chunk);
+        if ( !tile_is_exposed(near) && !tile_is_flagged(near) ) {
+          expose_tile(plane, x + dx, y + dy);
+        }
+      }
+    }
+    return EXIT_SUCCESS;
+  }
+
+  // Chord a number with as many flags around it
+  int flags;
+  int blanks;
+  count_around(plane, x, y, &flags, &blanks);
+  if ( flags != tile_count(tile) ) {
+    LOG_INFO("Tile indicates %d bombs nearby, but %d tiles are flagged.",
+        tile_count(tile), flags);
+    return EXIT_SUCCESS;
+  }
+  for ( int dy = -1; dy <= 1; dy++ ) {
+    for ( int dx = -1; dx <= 1; dx++ ) {
+      Tile near = *tile_at(plane, x + dx, y + dy, &chunk);
+      if ( !tile_is_exposed(near) && !tile_is_flagged(near) &&
+          expose_tile(plane, x + dx, y + dy) == LOSE_MINE ) {
+        return LOSE_MINE;
+      }
+    }
+  }
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Flags or unflags one tile on the plane.
+ *
+ * @param plane the plane to flag a tile on
+ * @param x the x position of the tile
+ * @param y the y position of the tile
+ * @return 0 if successful, else INVALID_EXPOSED
+ */
+short plane_flag(Plane *plane, int64_t x, int64_t y) {
+  plane -> tick++;
+  Chunk *chunk;
+  Tile *tile = tile_at(plane, x, y, &chunk);
+  if ( tile_is_exposed(*tile) ) {
+    return INVALID_EXPOSED;
+  }
+  *tile ^= TILE_FLAGGED;
+  chunk -> touched = true;
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Exposes a blank tile near the cursor, and moves the cursor to it, to start
+ * a game. Searches outward in square rings; if no blank turns up, takes the
+ * safe tile with the fewest mines around it.
+ *
+ * @param plane the plane to start on
+ */
+void plane_expose_safe(Plane *plane) {
+  plane -> tick++;
+  int64_t best_x = plane -> cur_x;
+  int64_t best_y = plane -> cur_y;
+  int best_count = BOMB_HERE;
+  for ( int64_t radius = 0; radius <= PLANE_SAFE_RADIUS && best_count > 0;
+      radius++ ) {
+    for ( int64_t dy = -radius; dy <= radius && best_count > 0; dy++ ) {
+      // Only the edge of the square is new
+      int64_t step = ( dy == -radius || dy == radius ) ? 1 : 2 * radius;
+      for ( int64_t dx = -radius; dx <= radius; dx += step ) {
+        int64_t x = plane -> cur_x + dx;
+        int64_t y = plane -> cur_y + dy;
+        Chunk *chunk;
+        short bomb = tile_bomb(*tile_at(plane, x, y, &chunk));
+        if ( bomb < best_count ) {
+          best_count = bomb;
+          best_x = x;
+          best_y = y;
+        }
+      }
+    }
+  }
+  plane -> cur_x = best_x;
+  plane -> cur_y = best_y;
+  expose_tile(plane, best_x, best_y);
+}
@@ -0,0 +1,169 @@
+#ifndef PLANE_H
+#define PLANE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "board.h"
+
+/** Chunks are PLANE_CHUNK tiles on a side, a power of two. */
+#define PLANE_CHUNK_BITS 6
+#define PLANE_CHUNK ( 1 << PLANE_CHUNK_BITS )
+/** Tiles in one chunk. */
+#define PLANE_CHUNK_TILES ( PLANE_CHUNK * PLANE_CHUNK )
+/** Most tiles one expose uncovers. Past this, the rest are left hidden. */
+#define PLANE_FILL_MAX ( (size_t) 1 << 22 )
+
+/**
+ * A square of PLANE_CHUNK x PLANE_CHUNK tiles on a plane. Its mines come from
+ * the plane's seed and the chunk's position, so it can be thrown away and made
+ * again as long as the player hasn't touched it.
+ */
+typedef struct Chunk {
+  // Position, in chunks: tile (x, y) is in chunk (x >> PLANE_CHUNK_BITS,
+  // y >> PLANE_CHUNK_BITS)
+  int64_t cx;
+  int64_t cy;
+  // Next chunk in the same hash bucket
+  struct Chunk *next;
+  // Tiles row by row, or NULL while the chunk is saved out to the swap file
+  Tile *tiles;
+  // Where the tiles were last saved in the swap file, or -1 if they never were
+  long offset;
+  // Plane's tick when the chunk was last looked at, for picking what to evict
+  uint64_t used;
+  // Whether anything in it was exposed or flagged, so it can't just be
+  // made again from the seed
+  bool touched;
+} Chunk;
+
+/** A tile position on a plane. */
+typedef struct Point {
+  int64_t x;
+  int64_t y;
+} Point;
+
+/**
+ * An endless minesweeper board. The plane is split into chunks, each made the
+ * first time one of its tiles is looked at, so memory grows with the area
+ * explored rather than the size of the board. Chunks are found through a hash
+ * map, and tiles near a chunk's edge count the mines in the chunks next to
+ * it, so neighbors work the same everywhere.
+ *
+ * Once more than max_loaded chunks are in memory, the ones looked at least
+ * recently are evicted: untouched chunks are dropped, and touched ones are
+ * saved to a swap file and read back when they're needed again.
+ */
+typedef struct Plane {
+  uint64_t seed;
+  // Mines placed in each chunk
+  int chunk_mines;
+  // Hash map of chunks, by position. The bucket count is a power of two.
+  Chunk **buckets;
+  size_t bucket_count;
+  // Chunks in the map, and how many of those have their tiles in memory
+  size_t chunks;
+  size_t loaded;
+  // Most chunks kept in memory, or 0 for no limit
+  size_t max_loaded;
+  // Advanced by every public call. Chunks looked at during the current tick
+  // are never evicted, so tile pointers stay good while one call runs.
+  uint64_t tick;
+  // Chunk found by the last lookup, which the next one usually wants again
+  Chunk *last;
+  // File evicted chunks are saved to, opened the first time it's needed, and
+  // where its end is
+  char *swap_path;
+  FILE *swap;
+  long swap_end;
+  // Cursor position
+  int64_t cur_x;
+  int64_t cur_y;
+  // Count of exposed tiles
+  uint64_t exposed;
+  // Work queue of blank tiles waiting to have their neighbors exposed
+  Point *fill_queue;
+  size_t fill_capacity;
+  // Chunks made from the seed, evicted, and read back from the swap file
+  size_t generated;
+  size_t evicted;
+  size_t swapped_in;
+} Plane;
+
+
+/**
+ * Constructor for a Plane.
+ *
+ * @param seed the seed for placing mines
+ * @param density the fraction of tiles that are mines, from 0 to 1
+ * @param max_loaded the most chunks to keep in memory, or 0 for no limit
+ * @param swap_path the file to save evicted chunks to, or NULL to pick one in
+ *  the temporary directory
+ * @return the newly created Plane, or NULL if there isn't enough memory
+ */
+Plane *newPlane(uint64_t seed, double density, size_t max_loaded,
+    const char *swap_path);
+
+/**
+ * Frees a Plane and everything it holds, and removes its swap file.
+ *
+ * @param plane the plane to free
+ */
+void plane_free(Plane *plane);
+
+/**
+ * Gets a tile on the plane, making its chunk if needed. The pointer stays
+ * good until the next call to any plane function.
+ *
+ * @param plane the plane to get a tile from
+ * @param x the x position of the tile
+ * @param y the y position of the tile
+ * @return a pointer to the tile
+ */
+Tile *plane_tile(Plane *plane, int64_t x, int64_t y);
+
+/**
+ * Counts the nearby flags and blanks of a tile: tiles neither exposed nor
+ * flagged.
+ *
+ * @param plane the plane the tile is on
+ * @param x the x position of the tile
+ * @param y the y position of the tile
+ * @param flags where to place the number of nearby flags
+ * @param blanks where to place the number of nearby blanks
+ */
+void plane_around(Plane *plane, int64_t x, int64_t y, int *flags,
+    int *blanks);
+
+/**
+ * Exposes one tile on the plane, like board_expose_pick. Blanks expose all
+ * the tiles around them, and exposing a number with as many flags around it
+ * exposes its other neighbors.
+ *
+ * @param plane the plane to expose a tile on
+ * @param x the x position of the tile
+ * @param y the y position of the tile
+ * @return 0 if successful, else LOSE_MINE or INVALID_FLAGGED
+ */
+short plane_expose(Plane *plane, int64_t x, int64_t y);
+
+/**
+ * Flags or unflags one tile on the plane.
+ *
+ * @param plane the plane to flag a tile on
+ * @param x the x position of the tile
+ * @param y the y position of the tile
+ * @return 0 if successful, else INVALID_EXPOSED
+ */
+short plane_flag(Plane *plane, int64_t x, int64_t y);
+
+/**
+ * Exposes a blank tile near the cursor, and moves the cursor to it, to start
+ * a game.
+ *
+ * @param plane the plane to start on
+ */
+void plane_expose_safe(Plane *plane);
+
+#endif
@@ -0,0 +1,133 @@
+#include "pool.h"
+#include "log.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Sets up an empty pool.
+ *
+ * @param pool the pool to set up
+ * @param capacity the most idle boards to keep, at least 1
+ * @return 0 if successful, else 1 if there isn't enough memory
+ */
+int pool_init(BoardPool *pool, size_t capacity) {
+  // The capacity stays 0 until the pool is fully set up, so pool_free
+  // knows whether there's a lock to destroy
+  memset(pool, 0, sizeof(BoardPool));
+  capacity = capacity > 0 ? capacity : 1;
+  pool -> boards = malloc(sizeof(Board *) * capacity);
+  if ( !pool -> boards ) {
+    LOG_ERROR("Not enough memory for a pool of %zu boards.", capacity);
+    return EXIT_FAILURE;
+  }
+  if ( pthread_mutex_init(&pool -> lock, NULL) != 0 ) {
+    LOG_ERROR("Couldn't set up the lock for a board pool.");
+    free(pool -> boards);
+    pool -> boards = NULL;
+    return EXIT_FAILURE;
+  }
+  pool -> capacity = capacity;
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Gets a board ready for a new game, reusing an idle one of the same size if
+ * there is one, else making a new one.
+ *
+ * @param pool the pool to take from
+ * @param width the horizontal count of tiles across the board
+ * @param height the vertical count of tiles across the board
+ * @param mines the number of mines to place
+ * @param seed the seed to place the mines from
+ * @param first_zero whether the mines wait for the first tile exposed
+ * @return the board, or NULL if a new one couldn't be made
+ */
+Board *pool_take(BoardPool *pool, int width, int height, int64_t mines,
+    uint64_t seed, bool first_zero) {
+
+  // Look for an idle board of the same size, newest first since it's the
+  // most likely to still be in cache
+  Board *board = NULL;
+  pthread_mutex_lock(&pool -> lock);
+  for ( size_t i = pool -> count; i-- > 0; ) {
+    Board *idle = pool -> boards[i];
+    if ( idle -> width == width && idle -> height == height ) {
+      board = idle;
+      memmove(pool -> boards + i, pool -> boards + i + 1,
+          sizeof(Board *) * ( pool -> count - i - 1 ));
+      pool -> count--;
+      pool -> reused++;
+      break;
+    }
+  }
+  if ( !board ) {
+    pool -> created++;
+  }
+  pthread_mutex_unlock(&pool -> lock);
+
+  // Reset the board outside the lock, so threads don't wait on each other
+  if ( board ) {
+    int64_t tiles = (int64_t) width * height;
+    board -> mineCount = mines < 0 ? 0 : mines > tiles ? tiles : mines;
+    board -> first_zero = first_zero;
+    board_reset(board, seed);
+    return board;
+  }
+
+  // Nothing to reuse, so make a new one. Its mines are already placed, so
+  // it only needs a reset to hold them for the first tile.
+  board = newBoardSeeded(width, height, mines, seed);
+  if ( board && first_zero ) {
+    board -> first_zero = true;
+    board_reset(board, seed);
+  }
+  return board;
+}
+
+/**
+ * Hands a board back to the pool once its game is over. If the pool is full,
+ * the board that's been idle longest is freed to make room.
+ *
+ * @param pool the pool to give to
+ * @param board the board to give back, or NULL to do nothing
+ */
+void pool_give(BoardPool *pool, Board *board) {
+  if ( !board ) {
+    return;
+  }
+  Board *evicted = NULL;
+  pthread_mutex_lock(&pool -> lock);
+  if ( pool -> count == pool -> capacity ) {
+    evicted = pool -> boards[0];
+    memmove(pool -> boards, pool -> boards + 1,
+        sizeof(Board *) * ( pool -> count - 1 ));
+    pool -> count--;
+  }
+  pool -> boards[pool -> count++] = board;
+  pthread_mutex_unlock(&pool -> lock);
+
+  // Free outside the lock, a big board can take a while to hand back
+  if ( evicted ) {
+    board_free(evicted);
+  }
+}
+
+/**
+ * Frees every idle board in a pool, and the pool's own memory. Boards still
+ * taken must be freed by whoever has them.
+ *
+ * @param pool the pool to free
+ */
+void pool_free(BoardPool *pool) {
+  for ( size_t i = 0; i < pool -> count; i++ ) {
+    board_free(pool -> boards[i]);
+  }
+  free(pool -> boards);
+  pool -> boards = NULL;
+  pool -> count = 0;
+  if ( pool -> capacity > 0 ) {
+    pthread_mutex_destroy(&pool -> lock);
+  }
+  pool -> capacity = 0;
+}
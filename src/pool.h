@@ -0,0 +1,69 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "board.h"
+
+/**
+ * A set of idle boards waiting to be played on again. Taking a board of a
+ * size the pool already holds just resets it, so once a workload has warmed
+ * the pool up, starting a game allocates nothing. Safe to share between
+ * threads.
+ */
+typedef struct BoardPool {
+  pthread_mutex_t lock;
+  // Idle boards, oldest first, and how many can be kept
+  Board **boards;
+  size_t count;
+  size_t capacity;
+  // Boards made new, and boards handed out again, for reports
+  size_t created;
+  size_t reused;
+} BoardPool;
+
+
+/**
+ * Sets up an empty pool.
+ *
+ * @param pool the pool to set up
+ * @param capacity the most idle boards to keep, at least 1
+ * @return 0 if successful, else 1 if there isn't enough memory
+ */
+int pool_init(BoardPool *pool, size_t capacity);
+
+/**
+ * Gets a board ready for a new game, reusing an idle one of the same size if
+ * there is one, else making a new one.
+ *
+ * @param pool the pool to take from
+ * @param width the horizontal count of tiles across the board
+ * @param height the vertical count of tiles across the board
+ * @param mines the number of mines to place
+ * @param seed the seed to place the mines from
+ * @param first_zero whether the mines wait for the first tile exposed
+ * @return the board, or NULL if a new one couldn't be made
+ */
+Board *pool_take(BoardPool *pool, int width, int height, int64_t mines,
+    uint64_t seed, bool first_zero);
+
+/**
+ * Hands a board back to the pool once its game is over. If the pool is full,
+ * the board that's been idle longest is freed to make room.
+ *
+ * @param pool the pool to give to
+ * @param board the board to give back, or NULL to do nothing
+ */
+void pool_give(BoardPool *pool, Board *board);
+
+/**
+ * Frees every idle board in a pool, and the pool's own memory. Boards still
+ * taken must be freed by whoever has them.
+ *
+ * @param pool the pool to free
+ */
+void pool_free(BoardPool *pool);
+
+#endif
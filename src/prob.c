@@ -0,0 +1,1115 @@
+#define _XOPEN_SOURCE 700
+
+#include "prob.h"
+#include "batch.h"
+#include "log.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+/** Most hidden tiles in a component that are counted exactly. */
+#define PROB_MAX_VARS 512
+/** Most backtracking steps spent counting one component. */
+#define PROB_NODE_BUDGET ( 1u << 22 )
+/**
+ * Most multiply-adds spent combining components exactly. Past this, the
+ * components are treated as independent, which is very close when plenty of
+ * hidden tiles are untouched by numbers.
+ */
+#define PROB_COMBINE_BUDGET 50000000.0
+/** Number of components remembered by shape. */
+#define PROB_CACHE_SLOTS 4096
+
+/**
+ * Counted placements for one shape of component, remembered across updates.
+ */
+typedef struct CacheEntry {
+  uint64_t hash;
+  // The component's shape, as built by build_component
+  int *shape;
+  size_t shape_len;
+  // Whether counting finished within budget
+  bool exact;
+  // Placements using each number of mines, and how many of those put a mine
+  // on each tile
+  double *counts;
+  double *hits;
+} CacheEntry;
+
+/**
+ * A group of hidden tiles that share numbers with each other, but none with
+ * any other group.
+ */
+typedef struct Component {
+  // Where its tiles start in order_vars, and how many
+  int first_var;
+  int vars;
+  // Its shape: tile and number counts, then each number's mines left, tile
+  // count, and tiles, numbered in the order they're stored in order_vars
+  size_t shape_start;
+  size_t shape_len;
+  uint64_t hash;
+  // Counted placements, from the cache or counted this update
+  CacheEntry *entry;
+  // Set if the entry didn't fit in the cache, and is freed after the update
+  bool owned;
+} Component;
+
+/**
+ * A variable and the tile it stands for, for sorting variables by position.
+ */
+typedef struct VarCell {
+  size_t cell;
+  int var;
+} VarCell;
+
+/**
+ * Working memory for a Prob, grown as needed and kept between updates.
+ */
+struct prob_work {
+  // Variable number of each tile in the board's cells, or -1
+  int *var_of;
+  // Hidden tiles next to the frontier, by variable number
+  size_t *var_cell;
+  size_t var_count;
+  size_t var_cap;
+  // Numbers with unproven tiles around them: the tile, mines left, and where
+  // its variables start in con_vars
+  size_t *con_cell;
+  int *con_need;
+  int *con_start;
+  size_t con_count;
+  size_t con_cap;
+  int *con_vars;
+  size_t con_vars_cap;
+  // Numbers around each variable, listed from var_con_start
+  int *var_con_start;
+  int *var_cons;
+  size_t var_cons_cap;
+  // Variables in component order, each variable's place in its component,
+  // and which variables and numbers have been reached
+  int *order_vars;
+  int *local_of;
+  unsigned char *var_seen;
+  unsigned char *con_seen;
+  size_t con_seen_cap;
+  int *queue;
+  // Each variable's tile, sorted by position, to start components from
+  VarCell *roots;
+  // Room in each per-variable array from var_con_start to roots
+  size_t order_cap;
+  // Components, and their shapes
+  Component *comps;
+  size_t comp_cap;
+  int *shapes;
+  size_t shape_len;
+  size_t shape_cap;
+  // Weight of each number of mines in the components, the weight of the
+  // components other than one for each, and what each mine in it gains
+  double *weight;
+  double *others;
+  double *gain;
+  size_t totals_cap;
+  // Each exact component's counts and hits, scaled so the largest count is
+  // 1, and where each component's start, or SIZE_MAX if it isn't exact
+  double *scaled;
+  size_t scaled_cap;
+  size_t *scaled_at;
+  // Placements in the components before and after each one, where each
+  // component's start, and how many mines they can hold, plus one
+  double *prefix;
+  size_t prefix_cap;
+  double *suffix;
+  size_t suffix_cap;
+  size_t *prefix_at;
+  size_t *prefix_len;
+  size_t *suffix_at;
+  size_t *suffix_len;
+  // Room in each per-component array from scaled_at to suffix_len
+  size_t poly_cap;
+  // Remembered components, by hash
+  CacheEntry *cache[PROB_CACHE_SLOTS];
+};
+
+/**
+ * Makes sure an array has room for a number of items, growing it if not.
+ *
+ * @param items the array to grow
+ * @param capacity how many items it has room for
+ * @param needed how many items it needs room for
+ * @param size the size of each item
+ */
+static void reserve(void *items, size_t *capacity, size_t needed, size_t size) {
+  void **array = items;
+  if ( needed <= *capacity ) {
+    return;
+  }
+  size_t grown = *capacity ? *capacity : 64;
+  while ( grown < needed ) {
+    grown *= 2;
+  }
+  void *larger = realloc(*array, grown * size);
+  if ( !larger ) {
+    LOG_ERROR("Out of memory growing a probability table to %zu entries.",
+        grown);
+    exit(EXIT_FAILURE);
+  }
+  *array = larger;
+  *capacity = grown;
+}
+
+/**
+ * Works out how much memory the odds for a board of a given size take up
+ * front: a float of odds and an int variable number per tile, and the list of
+ * changed odds. Its work lists grow with the frontier.
+ *
+ * @param width the horizontal count of tiles across the board
+ * @param height the vertical count of tiles across the board
+ * @return the number of bytes, or 0 if the size is out of range or too big to
+ *  address
+ */
+size_t prob_bytes(int width, int height) {
+  if ( board_bytes(width, height) == 0 ) {
+    return 0;
+  }
+  // The grid and variable numbers cover the border ring too
+  size_t tiles = ( (size_t) width + 2 ) * ( (size_t) height + 2 );
+  size_t per_tile = sizeof(float) + sizeof(int);
+  size_t extra = sizeof(Prob) + sizeof(struct prob_work)
+    + ( sizeof(size_t) + sizeof(float) ) * CHANGES_MAX;
+  if ( tiles > ( SIZE_MAX - extra ) / per_tile ) {
+    return 0;
+  }
+  return extra + per_tile * tiles;
+}
+
+/**
+ * Constructor for a Prob.
+ *
+ * @param board the board to study
+ * @param solver the solver keeping the board's frontier
+ * @param threads threads to count components on, or 0 for one per core
+ * @return the newly created Prob, or NULL if there isn't enough memory
+ */
+Prob *newProb(Board *board, Solver *solver, int threads) {
+  size_t len_total = (size_t) board -> stride * ( board -> height + 2 );
+  Prob *prob = calloc(1, sizeof(Prob));
+  float *grid = malloc(sizeof(float) * len_total);
+  struct prob_work *work = calloc(1, sizeof(struct prob_work));
+  int *var_of = malloc(sizeof(int) * len_total);
+  size_t *changes = malloc(sizeof(size_t) * CHANGES_MAX);
+  float *changes_from = malloc(sizeof(float) * CHANGES_MAX);
+  if ( !prob || !grid || !work || !var_of || !changes || !changes_from ) {
+    LOG_ERROR("Not enough memory to work out the odds on a %dx%d board.",
+        board -> width, board -> height);
+    free(prob);
+    free(grid);
+    free(work);
+    free(var_of);
+    free(changes);
+    free(changes_from);
+    return NULL;
+  }
+  prob -> board = board;
+  prob -> solver = solver;
+  prob -> threads = threads;
+  prob -> grid = grid;
+  prob -> changes = changes;
+  prob -> changes_from = changes_from;
+  for ( size_t i = 0; i < len_total; i++ ) {
+    prob -> grid[i] = -1;
+  }
+  prob -> work = work;
+  prob -> work -> var_of = var_of;
+  for ( size_t i = 0; i < len_total; i++ ) {
+    prob -> work -> var_of[i] = -1;
+  }
+  return prob;
+}
+
+/**
+ * Frees a remembered component.
+ *
+ * @param entry the entry to free, or NULL
+ */
+static void cache_entry_free(CacheEntry *entry) {
+  if ( entry ) {
+    free(entry -> shape);
+    free(entry -> counts);
+    free(entry -> hits);
+    free(entry);
+  }
+}
+
+/**
+ * Frees a Prob and everything it holds. Leaves its board and solver alone.
+ *
+ * @param prob the prob to free
+ */
+void prob_free(Prob *prob) {
+  struct prob_work *work = prob -> work;
+  for ( int i = 0; i < PROB_CACHE_SLOTS; i++ ) {
+    cache_entry_free(work -> cache[i]);
+  }
+  free(work -> var_of);
+  free(work -> var_cell);
+  free(work -> con_cell);
+  free(work -> con_need);
+  free(work -> con_start);
+  free(work -> con_vars);
+  free(work -> var_con_start);
+  free(work -> var_cons);
+  free(work -> order_vars);
+  free(work -> local_of);
+  free(work -> var_seen);
+  free(work -> con_seen);
+  free(work -> queue);
+  free(work -> roots);
+  free(work -> comps);
+  free(work -> shapes);
+  free(work -> weight);
+  free(work -> others);
+  free(work -> gain);
+  free(work -> scaled);
+  free(work -> scaled_at);
+  free(work -> prefix);
+  free(work -> suffix);
+  free(work -> prefix_at);
+  free(work -> prefix_len);
+  free(work -> suffix_at);
+  free(work -> suffix_len);
+  free(work);
+  free(prob -> grid);
+  free(prob -> changes);
+  free(prob -> changes_from);
+  free(prob);
+}
+
+/**
+ * Lists every frontier number with unproven tiles around it, and gives each
+ * of those tiles a variable number.
+ *
+ * @param prob the prob to list constraints for
+ */
+static void find_constraints(Prob *prob) {
+  struct prob_work *work = prob -> work;
+  size_t frontier_len;
+  const size_t *frontier = solver_frontier(prob -> solver, &frontier_len);
+  work -> var_count = 0;
+  work -> con_count = 0;
+  size_t con_vars_len = 0;
+
+  for ( size_t f = 0; f < frontier_len; f++ ) {
+    size_t unknown[8];
+    int need;
+    int length = solver_unknown_around(prob -> solver, frontier[f], unknown,
+        &need);
+    if ( length == 0 ) {
+      continue;
+    }
+    if ( work -> con_count + 1 >= work -> con_cap ) {
+      // The per-number arrays share con_cap, so grow them together
+      size_t cap = work -> con_cap;
+      reserve(&work -> con_cell, &cap, work -> con_count + 2, sizeof(size_t));
+      cap = work -> con_cap;
+      reserve(&work -> con_need, &cap, work -> con_count + 2, sizeof(int));
+      cap = work -> con_cap;
+      reserve(&work -> con_start, &cap, work -> con_count + 2, sizeof(int));
+      work -> con_cap = cap;
+    }
+    reserve(&work -> con_vars, &work -> con_vars_cap, con_vars_len + 8,
+        sizeof(int));
+
+    size_t con = work -> con_count++;
+    work -> con_cell[con] = frontier[f];
+    work -> con_need[con] = need;
+    work -> con_start[con] = con_vars_len;
+    for ( int i = 0; i < length; i++ ) {
+      int *var = &work -> var_of[unknown[i]];
+      if ( *var < 0 ) {
+        reserve(&work -> var_cell, &work -> var_cap, work -> var_count + 1,
+            sizeof(size_t));
+        *var = work -> var_count;
+        work -> var_cell[work -> var_count++] = unknown[i];
+      }
+      work -> con_vars[con_vars_len++] = *var;
+    }
+  }
+  if ( work -> con_count > 0 ) {
+    work -> con_start[work -> con_count] = con_vars_len;
+  }
+}
+
+/**
+ * Orders variables by their tile's position, for qsort.
+ */
+static int compare_var_cells(const void *a, const void *b) {
+  size_t left = ( (const VarCell *) a ) -> cell;
+  size_t right = ( (const VarCell *) b ) -> cell;
+  return ( left > right ) - ( left < right );
+}
+
+/**
+ * Splits the variables into components, numbering each component's tiles and
+ * numbers in an order that depends only on the component's shape, and
+ * records each shape.
+ *
+ * @param prob the prob to split variables for
+ * @return the number of components
+ */
+static size_t build_components(Prob *prob) {
+  struct prob_work *work = prob -> work;
+  size_t vars = work -> var_count;
+  size_t cons = work -> con_count;
+  size_t con_vars_len = cons > 0 ? (size_t) work -> con_start[cons] : 0;
+
+  // Size the per-variable arrays, which share order_cap, so grow them
+  // together
+  if ( vars + 1 > work -> order_cap ) {
+    size_t cap = work -> order_cap;
+    reserve(&work -> var_con_start, &cap, vars + 1, sizeof(int));
+    cap = work -> order_cap;
+    reserve(&work -> order_vars, &cap, vars + 1, sizeof(int));
+    cap = work -> order_cap;
+    reserve(&work -> local_of, &cap, vars + 1, sizeof(int));
+    cap = work -> order_cap;
+    reserve(&work -> var_seen, &cap, vars + 1, 1);
+    cap = work -> order_cap;
+    reserve(&work -> queue, &cap, vars + 1, sizeof(int));
+    cap = work -> order_cap;
+    reserve(&work -> roots, &cap, vars + 1, sizeof(VarCell));
+    work -> order_cap = cap;
+  }
+  reserve(&work -> var_cons, &work -> var_cons_cap, con_vars_len + 1,
+      sizeof(int));
+  reserve(&work -> con_seen, &work -> con_seen_cap, cons + 1, 1);
+  memset(work -> var_seen, 0, vars);
+  memset(work -> con_seen, 0, cons);
+
+  // List the numbers around each variable, in board order
+  memset(work -> var_con_start, 0, sizeof(int) * ( vars + 1 ));
+  for ( size_t i = 0; i < con_vars_len; i++ ) {
+    work -> var_con_start[work -> con_vars[i] + 1]++;
+  }
+  for ( size_t v = 0; v < vars; v++ ) {
+    work -> var_con_start[v + 1] += work -> var_con_start[v];
+  }
+  int *fill = work -> local_of;
+  memcpy(fill, work -> var_con_start, sizeof(int) * vars);
+  for ( size_t c = 0; c < cons; c++ ) {
+    for ( int i = work -> con_start[c]; i < work -> con_start[c + 1]; i++ ) {
+      work -> var_cons[fill[work -> con_vars[i]]++] = c;
+    }
+  }
+
+  // Start each component from its first tile in board order
+  VarCell *roots = work -> roots;
+  for ( size_t v = 0; v < vars; v++ ) {
+    roots[v] = (VarCell) { work -> var_cell[v], v };
+  }
+  qsort(roots, vars, sizeof(VarCell), compare_var_cells);
+  int *queue = work -> queue;
+
+  size_t comp_count = 0;
+  size_t ordered = 0;
+  work -> shape_len = 0;
+  for ( size_t r = 0; r < vars; r++ ) {
+    int root = roots[r].var;
+    if ( work -> var_seen[root] ) {
+      continue;
+    }
+    reserve(&work -> comps, &work -> comp_cap, comp_count + 1,
+        sizeof(Component));
+    Component *comp = &work -> comps[comp_count++];
+    comp -> first_var = ordered;
+    comp -> shape_start = work -> shape_len;
+    comp -> entry = NULL;
+    comp -> owned = false;
+
+    // Reserve the tile and number counts at the start of the shape
+    reserve(&work -> shapes, &work -> shape_cap, work -> shape_len + 2,
+        sizeof(int));
+    work -> shape_len += 2;
+    int con_total = 0;
+
+    // Breadth-first through shared numbers, taking each variable's numbers
+    // in board order
+    size_t head = 0;
+    size_t tail = 0;
+    queue[tail++] = root;
+    work -> var_seen[root] = 1;
+    while ( head < tail ) {
+      int var = queue[head++];
+      work -> local_of[var] = ordered - comp -> first_var;
+      work -> order_vars[ordered++] = var;
+      for ( int i = work -> var_con_start[var];
+          i < work -> var_con_start[var + 1]; i++ ) {
+        int con = work -> var_cons[i];
+        if ( work -> con_seen[con] ) {
+          continue;
+        }
+        work -> con_seen[con] = 1;
+        con_total++;
+        for ( int j = work -> con_start[con]; j < work -> con_start[con + 1];
+            j++ ) {
+          int other = work -> con_vars[j];
+          if ( !work -> var_seen[other] ) {
+            work -> var_seen[other] = 1;
+            queue[tail++] = other;
+          }
+        }
+      }
+    }
+    comp -> vars = ordered - comp -> first_var;
+
+    // Now every tile has its local number, write out each number
+    for ( int v = comp -> first_var; v < comp -> first_var + comp -> vars; v++ ) {
+      int var = work -> order_vars[v];
+      for ( int i = work -> var_con_start[var];
+          i < work -> var_con_start[var + 1]; i++ ) {
+        int con = work -> var_cons[i];
+        // Write each number once, from its first tile in local order
+        if ( work -> con_seen[con] != 1 ) {
+          continue;
+        }
+        work -> con_seen[con] = 2;
+        int size = work -> con_start[con + 1] - work -> con_start[con];
+        reserve(&work -> shapes, &work -> shape_cap,
+            work -> shape_len + 2 + size, sizeof(int));
+        int *out = work -> shapes + work -> shape_len;
+        *out++ = work -> con_need[con];
+        *out++ = size;
+        for ( int j = work -> con_start[con]; j < work -> con_start[con + 1];
+            j++ ) {
+          *out++ = work -> local_of[work -> con_vars[j]];
+        }
+        work -> shape_len += 2 + size;
+      }
+    }
+    work -> shapes[comp -> shape_start] = comp -> vars;
+    work -> shapes[comp -> shape_start + 1] = con_total;
+    comp -> shape_len = work -> shape_len - comp -> shape_start;
+
+    // Hash the shape, FNV-1a
+    uint64_t hash = 14695981039346656037u;
+    const unsigned char *bytes =
+      (const unsigned char *) ( work -> shapes + comp -> shape_start );
+    for ( size_t i = 0; i < comp -> shape_len * sizeof(int); i++ ) {
+      hash = ( hash ^ bytes[i] ) * 1099511628211u;
+    }
+    comp -> hash = hash;
+  }
+  return comp_count;
+}
+
+/**
+ * State for counting the placements in one component by backtracking.
+ */
+typedef struct Search {
+  int vars;
+  // Numbers around each tile, listed from var_start
+  const int *var_start;
+  const int *var_cons;
+  // Each number's mines still to place, and tiles still to decide
+  int *need;
+  int *left;
+  unsigned char *mined;
+  // Placements by mines used, and mines on each tile by mines used
+  double *counts;
+  double *hits;
+  size_t steps;
+  bool gave_up;
+} Search;
+
+/**
+ * Tries both ways of deciding a tile, then the tiles after it.
+ *
+ * @param search the search in progress
+ * @param var the tile to decide
+ * @param mines the mines placed so far
+ */
+static void search_from(Search *search, int var, int mines) {
+  if ( search -> gave_up || ++search -> steps > PROB_NODE_BUDGET ) {
+    search -> gave_up = true;
+    return;
+  }
+  // Every tile decided, and every number was checked along the way
+  if ( var == search -> vars ) {
+    search -> counts[mines]++;
+    double *hits = search -> hits + mines;
+    for ( int v = 0; v < search -> vars; v++ ) {
+      if ( search -> mined[v] ) {
+        hits[(size_t) v * ( search -> vars + 1 )]++;
+      }
+    }
+    return;
+  }
+
+  for ( int mine = 0; mine <= 1; mine++ ) {
+    // Each number needs mines left to place, and tiles left to place them on
+    bool fits = true;
+    for ( int i = search -> var_start[var]; i < search -> var_start[var + 1];
+        i++ ) {
+      int con = search -> var_cons[i];
+      int need = search -> need[con] - mine;
+      if ( need < 0 || need > search -> left[con] - 1 ) {
+        fits = false;
+        break;
+      }
+    }
+    if ( !fits ) {
+      continue;
+    }
+    for ( int i = search -> var_start[var]; i < search -> var_start[var + 1];
+        i++ ) {
+      search -> need[search -> var_cons[i]] -= mine;
+      search -> left[search -> var_cons[i]]--;
+    }
+    search -> mined[var] = mine;
+    search_from(search, var + 1, mines + mine);
+    for ( int i = search -> var_start[var]; i < search -> var_start[var + 1];
+        i++ ) {
+      search -> need[search -> var_cons[i]] += mine;
+      search -> left[search -> var_cons[i]]++;
+    }
+  }
+}
+
+/**
+ * Counts every placement of mines in a component with the given shape.
+ *
+ * @param shape the component's shape, as built by build_components
+ * @param shape_len the length of the shape
+ * @param hash the shape's hash
+ * @return the counts, ready to cache
+ */
+static CacheEntry *count_component(const int *shape, size_t shape_len,
+    uint64_t hash) {
+  int vars = shape[0];
+  int cons = shape[1];
+  CacheEntry *entry = calloc(1, sizeof(CacheEntry));
+  entry -> hash = hash;
+  entry -> shape_len = shape_len;
+  entry -> shape = malloc(sizeof(int) * shape_len);
+  memcpy(entry -> shape, shape, sizeof(int) * shape_len);
+  if ( vars > PROB_MAX_VARS ) {
+    entry -> exact = false;
+    return entry;
+  }
+  entry -> counts = calloc(vars + 1, sizeof(double));
+  entry -> hits = calloc((size_t) vars * ( vars + 1 ), sizeof(double));
+
+  // List the numbers around each tile
+  int *var_start = calloc(vars + 1, sizeof(int));
+  int *need = malloc(sizeof(int) * cons);
+  int *left = malloc(sizeof(int) * cons);
+  const int *con = shape + 2;
+  for ( int c = 0; c < cons; c++ ) {
+    need[c] = con[0];
+    left[c] = con[1];
+    for ( int i = 0; i < con[1]; i++ ) {
+      var_start[con[2 + i] + 1]++;
+    }
+    con += 2 + con[1];
+  }
+  for ( int v = 0; v < vars; v++ ) {
+    var_start[v + 1] += var_start[v];
+  }
+  int *var_cons = malloc(sizeof(int) * ( var_start[vars] + 1 ));
+  int *fill = malloc(sizeof(int) * ( vars + 1 ));
+  memcpy(fill, var_start, sizeof(int) * vars);
+  con = shape + 2;
+  for ( int c = 0; c < cons; c++ ) {
+    for ( int i = 0; i < con[1]; i++ ) {
+      var_cons[fill[con[2 + i]]++] = c;
+    }
+    con += 2 + con[1];
+  }
+
+  Search search = { vars, var_start, var_cons, need, left,
+    calloc(vars + 1, 1), entry -> counts, entry -> hits, 0, false };
+  search_from(&search, 0, 0);
+  entry -> exact = !search.gave_up;
+
+  free(search.mined);
+  free(fill);
+  free(var_cons);
+  free(var_start);
+  free(need);
+  free(left);
+  return entry;
+}
+
+/**
+ * A share of the components for one thread to count.
+ */
+typedef struct CountJob {
+  pthread_t thread;
+  struct prob_work *work;
+  Component **comps;
+  size_t count;
+  size_t stride;
+  bool running;
+} CountJob;
+
+/**
+ * Counts every stride-th component in a job's list.
+ *
+ * @param arg the CountJob to run
+ * @return NULL
+ */
+static void *run_count_job(void *arg) {
+  CountJob *job = arg;
+  for ( size_t i = 0; i < job -> count; i += job -> stride ) {
+    Component *comp = job -> comps[i];
+    comp -> entry = count_component(job -> work -> shapes + comp -> shape_start,
+        comp -> shape_len, comp -> hash);
+  }
+  return NULL;
+}
+
+/**
+ * Finds each component's counts in the cache, and counts the rest across
+ * threads, adding them to the cache.
+ *
+ * @param prob the prob to count components for
+ * @param comp_count the number of components
+ */
+static void count_components(Prob *prob, size_t comp_count) {
+  struct prob_work *work = prob -> work;
+  Component **missing = malloc(sizeof(Component *) * ( comp_count + 1 ));
+  size_t missing_count = 0;
+  prob -> cache_hits = 0;
+
+  for ( size_t c = 0; c < comp_count; c++ ) {
+    Component *comp = &work -> comps[c];
+    CacheEntry *entry = work -> cache[comp -> hash % PROB_CACHE_SLOTS];
+    if ( entry && entry -> hash == comp -> hash
+        && entry -> shape_len == comp -> shape_len
+        && memcmp(entry -> shape, work -> shapes + comp -> shape_start,
+          sizeof(int) * comp -> shape_len) == 0 ) {
+      comp -> entry = entry;
+      prob -> cache_hits++;
+    } else {
+      missing[missing_count++] = comp;
+    }
+  }
+
+  // Count what's missing, spread across threads if there's enough of it
+  int threads = batch_threads(prob -> threads);
+  if ( (size_t) threads > missing_count ) {
+    threads = missing_count > 0 ? missing_count : 1;
+  }
+  CountJob jobs[threads];
+  for ( int t = 0; t < threads; t++ ) {
+    jobs[t] = (CountJob) { .work = work, .comps = missing + t,
+      .count = missing_count - t, .stride = threads };
+    // This thread takes the first share itself
+    jobs[t].running = t > 0
+      && pthread_create(&jobs[t].thread, NULL, run_count_job, &jobs[t]) == 0;
+  }
+  for ( int t = 0; t < threads; t++ ) {
+    if ( jobs[t].running ) {
+      pthread_join(jobs[t].thread, NULL);
+    } else {
+      run_count_job(&jobs[t]);
+    }
+  }
+
+  // Remember what was counted, replacing whatever shared its slot, unless
+  // another component in this update is still using that
+  for ( size_t m = 0; m < missing_count; m++ ) {
+    Component *comp = missing[m];
+    CacheEntry **slot = &work -> cache[comp -> hash % PROB_CACHE_SLOTS];
+    bool in_use = false;
+    for ( size_t c = 0; *slot && c < comp_count && !in_use; c++ ) {
+      in_use = work -> comps[c].entry == *slot;
+    }
+    if ( in_use ) {
+      comp -> owned = true;
+    } else {
+      cache_entry_free(*slot);
+      *slot = comp -> entry;
+    }
+  }
+  free(missing);
+}
+
+/**
+ * Finds the natural log of n choose k.
+ *
+ * @param n the number to choose from
+ * @param k the number to choose
+ * @return log(n choose k)
+ */
+static double log_choose(double n, double k) {
+  return lgamma(n + 1) - lgamma(k + 1) - lgamma(n - k + 1);
+}
+
+/**
+ * Multiplies two polynomials, given by their coefficients.
+ *
+ * @param a the first polynomial
+ * @param a_len the number of coefficients in a
+ * @param b the second polynomial
+ * @param b_len the number of coefficients in b
+ * @param out where to place the a_len + b_len - 1 coefficients of the product
+ */
+static void convolve(const double *a, size_t a_len, const double *b,
+    size_t b_len, double *out) {
+  memset(out, 0, sizeof(double) * ( a_len + b_len - 1 ));
+  for ( size_t i = 0; i < a_len; i++ ) {
+    if ( a[i] == 0 ) {
+      continue;
+    }
+    for ( size_t j = 0; j < b_len; j++ ) {
+      out[i + j] += a[i] * b[j];
+    }
+  }
+}
+
+/**
+ * Works out the chance of a mine on a tile outside every component counted
+ * exactly, from what the solver proved.
+ *
+ * @param prob the prob being updated
+ * @param index the index of the tile
+ * @param interior_chance the chance for tiles no counted number touches
+ * @return the chance, or -1 for exposed tiles
+ */
+static float plain_chance(const Prob *prob, size_t index,
+    double interior_chance) {
+  const unsigned char *marks = prob -> solver -> marks;
+  if ( tile_is_exposed(prob -> board -> cells[index]) ) {
+    return -1;
+  }
+  return ( marks[index] & SOLVE_MINE ) ? 1
+    : ( marks[index] & SOLVE_SAFE ) ? 0 : interior_chance;
+}
+
+/**
+ * Sets the chance of a mine on a tile, noting it if it changed, and keeps
+ * track of the safest tile to try. Ties go to the tile first in board order.
+ *
+ * @param prob the prob being updated
+ * @param index the index of the tile
+ * @param chance the tile's chance, or negative if it has none
+ */
+static void set_chance(Prob *prob, size_t index, float chance) {
+  float before = prob -> grid[index];
+  if ( chance != before ) {
+    if ( prob -> changes_len < CHANGES_MAX ) {
+      prob -> changes[prob -> changes_len] = index;
+      prob -> changes_from[prob -> changes_len++] = before;
+    } else {
+      prob -> changes_overflow = true;
+    }
+    prob -> grid[index] = chance;
+  }
+  if ( chance >= 0 && !tile_is_flagged(prob -> board -> cells[index])
+      && ( chance < prob -> safest_chance
+        || ( chance == prob -> safest_chance && index < prob -> safest ) ) ) {
+    prob -> safest = index;
+    prob -> safest_chance = chance;
+  }
+}
+
+/**
+ * Works out the chance of a mine on every hidden tile, into prob -> grid.
+ * The solver must be up to date with the board, and solved.
+ *
+ * @param prob the prob to update
+ * @return 0 if successful, else 1 if no placement of the mines fits the
+ *  numbers showing.
+ */
+int prob_update(Prob *prob) {
+  Board *board = prob -> board;
+  const unsigned char *marks = prob -> solver -> marks;
+  struct prob_work *work = prob -> work;
+  prob -> exact = true;
+  prob -> safest = 0;
+  prob -> safest_chance = 2;
+  prob -> changes_len = 0;
+  prob -> changes_overflow = false;
+
+  // Split the frontier's hidden tiles into components, and count them
+  find_constraints(prob);
+  size_t comp_count = build_components(prob);
+  prob -> components = comp_count;
+  count_components(prob, comp_count);
+
+  // Count the mines already known, and the hidden tiles no number touches.
+  // Components too big to count join the untouched tiles.
+  int64_t mines_left = board -> mineCount;
+  double interior = 0;
+  for ( int y = 0; y < board -> height; y++ ) {
+    for ( int x = 0; x < board -> width; x++ ) {
+      size_t index = board_index(board, x, y);
+      Tile tile = board -> cells[index];
+      if ( tile_is_exposed(tile) ) {
+        mines_left -= tile_is_mine(tile);
+      } else if ( marks[index] & SOLVE_MINE ) {
+        mines_left--;
+      } else if ( !( marks[index] & SOLVE_SAFE ) ) {
+        interior++;
+      }
+    }
+  }
+  size_t total_len = 1;
+  for ( size_t c = 0; c < comp_count; c++ ) {
+    Component *comp = &work -> comps[c];
+    if ( comp -> entry -> exact ) {
+      interior -= comp -> vars;
+      total_len += comp -> vars;
+    } else {
+      prob -> exact = false;
+    }
+  }
+
+  // Make room for this update's sums. The arrays sharing a capacity grow
+  // together.
+  if ( total_len > work -> totals_cap ) {
+    size_t cap = work -> totals_cap;
+    reserve(&work -> weight, &cap, total_len, sizeof(double));
+    cap = work -> totals_cap;
+    reserve(&work -> others, &cap, total_len, sizeof(double));
+    cap = work -> totals_cap;
+    reserve(&work -> gain, &cap, total_len, sizeof(double));
+    work -> totals_cap = cap;
+  }
+  if ( comp_count + 1 > work -> poly_cap ) {
+    size_t cap = work -> poly_cap;
+    reserve(&work -> scaled_at, &cap, comp_count + 1, sizeof(size_t));
+    cap = work -> poly_cap;
+    reserve(&work -> prefix_at, &cap, comp_count + 1, sizeof(size_t));
+    cap = work -> poly_cap;
+    reserve(&work -> prefix_len, &cap, comp_count + 1, sizeof(size_t));
+    cap = work -> poly_cap;
+    reserve(&work -> suffix_at, &cap, comp_count + 1, sizeof(size_t));
+    cap = work -> poly_cap;
+    reserve(&work -> suffix_len, &cap, comp_count + 1, sizeof(size_t));
+    work -> poly_cap = cap;
+  }
+
+  // Weight for each number of mines in the components: the ways to place the
+  // rest among the untouched tiles, relative to the most likely
+  double *weight = work -> weight;
+  double weight_max = -INFINITY;
+  for ( size_t k = 0; k < total_len; k++ ) {
+    double rest = mines_left - (double) k;
+    weight[k] = ( rest < 0 || rest > interior ) ? -INFINITY
+      : log_choose(interior, rest);
+    if ( weight[k] > weight_max ) {
+      weight_max = weight[k];
+    }
+  }
+  for ( size_t k = 0; k < total_len; k++ ) {
+    weight[k] = exp(weight[k] - weight_max);
+  }
+
+  // Scale each component's counts so the largest is 1, which keeps the
+  // products in range and cancels out in the end
+  size_t *scaled_at = work -> scaled_at;
+  size_t scaled_len = 0;
+  for ( size_t c = 0; c < comp_count; c++ ) {
+    size_t vars = work -> comps[c].vars;
+    scaled_at[c] = SIZE_MAX;
+    if ( work -> comps[c].entry -> exact ) {
+      scaled_at[c] = scaled_len;
+      scaled_len += ( vars + 1 ) * ( vars + 1 );
+    }
+  }
+  reserve(&work -> scaled, &work -> scaled_cap, scaled_len + 1,
+      sizeof(double));
+  for ( size_t c = 0; c < comp_count; c++ ) {
+    CacheEntry *entry = work -> comps[c].entry;
+    int vars = work -> comps[c].vars;
+    if ( scaled_at[c] == SIZE_MAX ) {
+      continue;
+    }
+    double *scaled = work -> scaled + scaled_at[c];
+    double largest = 0;
+    for ( int k = 0; k <= vars; k++ ) {
+      largest = fmax(largest, entry -> counts[k]);
+    }
+    for ( size_t i = 0; i < (size_t) ( vars + 1 ) * ( vars + 1 ); i++ ) {
+      double value = i <= (size_t) vars ? entry -> counts[i]
+        : entry -> hits[i - vars - 1];
+      scaled[i] = largest > 0 ? value / largest : 0;
+    }
+  }
+
+  // Combining exactly takes each component against all the others. Estimate
+  // how long that takes, by the prefix and suffix sizes.
+  double cost = 0;
+  size_t seen = 1;
+  for ( size_t c = 0; c < comp_count; c++ ) {
+    if ( scaled_at[c] != SIZE_MAX ) {
+      cost += (double) seen * ( total_len - seen );
+      seen += work -> comps[c].vars;
+    }
+  }
+  bool combine_exact = cost <= PROB_COMBINE_BUDGET;
+
+  // Polynomials of the placements in the components before and after each,
+  // laid out first so there's room for them all
+  size_t *prefix_at = work -> prefix_at;
+  size_t *prefix_len = work -> prefix_len;
+  size_t *suffix_at = work -> suffix_at;
+  size_t *suffix_len = work -> suffix_len;
+  prefix_at[0] = 0;
+  prefix_len[0] = 1;
+  for ( size_t c = 0; c < comp_count; c++ ) {
+    size_t vars = scaled_at[c] != SIZE_MAX ? work -> comps[c].vars : 0;
+    prefix_at[c + 1] = prefix_at[c] + prefix_len[c];
+    prefix_len[c + 1] = prefix_len[c] + vars;
+  }
+  suffix_at[comp_count] = 0;
+  suffix_len[comp_count] = 1;
+  for ( size_t c = comp_count; combine_exact && c-- > 0; ) {
+    size_t vars = scaled_at[c] != SIZE_MAX ? work -> comps[c].vars : 0;
+    suffix_at[c] = suffix_at[c + 1] + suffix_len[c + 1];
+    suffix_len[c] = suffix_len[c + 1] + vars;
+  }
+  reserve(&work -> prefix, &work -> prefix_cap,
+      prefix_at[comp_count] + prefix_len[comp_count], sizeof(double));
+  reserve(&work -> suffix, &work -> suffix_cap, combine_exact
+      ? suffix_at[0] + suffix_len[0] : 1, sizeof(double));
+  double *prefix = work -> prefix;
+  double *suffix = work -> suffix;
+  prefix[0] = 1;
+  for ( size_t c = 0; c < comp_count; c++ ) {
+    if ( scaled_at[c] != SIZE_MAX ) {
+      convolve(prefix + prefix_at[c], prefix_len[c],
+          work -> scaled + scaled_at[c], work -> comps[c].vars + 1,
+          prefix + prefix_at[c + 1]);
+    } else {
+      memcpy(prefix + prefix_at[c + 1], prefix + prefix_at[c],
+          sizeof(double) * prefix_len[c]);
+    }
+  }
+  suffix[suffix_at[comp_count]] = 1;
+  for ( size_t c = comp_count; combine_exact && c-- > 0; ) {
+    if ( scaled_at[c] != SIZE_MAX ) {
+      convolve(suffix + suffix_at[c + 1], suffix_len[c + 1],
+          work -> scaled + scaled_at[c], work -> comps[c].vars + 1,
+          suffix + suffix_at[c]);
+    } else {
+      memcpy(suffix + suffix_at[c], suffix + suffix_at[c + 1],
+          sizeof(double) * suffix_len[c + 1]);
+    }
+  }
+
+  // Weight of every placement, and the chance for untouched tiles
+  const double *all = prefix + prefix_at[comp_count];
+  size_t all_len = prefix_len[comp_count];
+  double total = 0;
+  double interior_mines = 0;
+  for ( size_t k = 0; k < all_len; k++ ) {
+    total += all[k] * weight[k];
+    interior_mines += all[k] * weight[k] * ( mines_left - (double) k );
+  }
+  int status = EXIT_SUCCESS;
+  if ( !( total > 0 ) ) {
+    LOG_ERROR("No placement of %lld mines fits the numbers showing.",
+        (long long) board -> mineCount);
+    status = EXIT_FAILURE;
+  }
+  double interior_chance = interior > 0 ? interior_mines / total / interior : 0;
+  if ( !combine_exact ) {
+    prob -> exact = false;
+  }
+
+  // Fill in the chances: known and untouched tiles first, in board order,
+  // leaving the components' tiles for below
+  for ( int y = 0; y < board -> height; y++ ) {
+    for ( int x = 0; x < board -> width; x++ ) {
+      size_t index = board_index(board, x, y);
+      if ( work -> var_of[index] >= 0 ) {
+        continue;
+      }
+      set_chance(prob, index, status == EXIT_SUCCESS
+          ? plain_chance(prob, index, interior_chance) : -1);
+    }
+  }
+
+  // Then each component's tiles
+  double *others = work -> others;
+  double *gain = work -> gain;
+  for ( size_t c = 0; c < comp_count; c++ ) {
+    int vars = work -> comps[c].vars;
+    const int *order = work -> order_vars + work -> comps[c].first_var;
+    if ( status != EXIT_SUCCESS || scaled_at[c] == SIZE_MAX ) {
+      // Components too big to count are filled in like untouched tiles
+      for ( int v = 0; v < vars; v++ ) {
+        size_t index = work -> var_cell[order[v]];
+        set_chance(prob, index, status == EXIT_SUCCESS
+            ? plain_chance(prob, index, interior_chance) : -1);
+      }
+      continue;
+    }
+    const double *scaled = work -> scaled + scaled_at[c];
+    // Weight of the rest of the board, for each number of mines here
+    if ( combine_exact ) {
+      convolve(prefix + prefix_at[c], prefix_len[c],
+          suffix + suffix_at[c + 1], suffix_len[c + 1], others);
+      size_t others_len = prefix_len[c] + suffix_len[c + 1] - 1;
+      for ( int k = 0; k <= vars; k++ ) {
+        gain[k] = 0;
+        for ( size_t j = 0; j < others_len; j++ ) {
+          gain[k] += others[j] * weight[k + j];
+        }
+        gain[k] /= total;
+      }
+    } else {
+      // Treat this component as independent of the others: each extra mine
+      // here costs the ratio between neighboring weights at the total the
+      // board most likely has
+      size_t mode = 0;
+      for ( size_t k = 0; k < all_len; k++ ) {
+        if ( all[k] * weight[k] > all[mode] * weight[mode] ) {
+          mode = k;
+        }
+      }
+      double rest = mines_left - (double) mode;
+      double ratio = interior > 0 ? rest / ( interior - rest + 1 ) : 1;
+      double sum = 0;
+      double power = 1;
+      for ( int k = 0; k <= vars; k++, power *= ratio ) {
+        gain[k] = power;
+        sum += scaled[k] * power;
+      }
+      for ( int k = 0; k <= vars; k++ ) {
+        gain[k] = sum > 0 ? gain[k] / sum : 0;
+      }
+    }
+    for ( int v = 0; v < vars; v++ ) {
+      const double *hits = scaled + vars + 1 + (size_t) v * ( vars + 1 );
+      double chance = 0;
+      for ( int k = 0; k <= vars; k++ ) {
+        chance += hits[k] * gain[k];
+      }
+      set_chance(prob, work -> var_cell[order[v]], chance);
+    }
+  }
+
+  LOG_DEBUG("Probabilities: %zu components (%zu cached), %s, safest %.3f,"
+      " %zu changed.", comp_count, prob -> cache_hits,
+      prob -> exact ? "exact" : "estimated", prob -> safest_chance,
+      prob -> changes_len);
+
+  // Free the components that didn't fit in the cache, and clear the variable
+  // numbers for next time
+  for ( size_t c = 0; c < comp_count; c++ ) {
+    if ( work -> comps[c].owned ) {
+      cache_entry_free(work -> comps[c].entry);
+    }
+  }
+  for ( size_t v = 0; v < work -> var_count; v++ ) {
+    work -> var_of[work -> var_cell[v]] = -1;
+  }
+  return status;
+}
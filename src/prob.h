@@ -0,0 +1,91 @@
+#ifndef PROB_H
+#define PROB_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "board.h"
+#include "solver.h"
+
+/**
+ * Works out the exact chance that each hidden tile is a mine, from the
+ * numbers showing and the board's mine count.
+ *
+ * The hidden tiles next to the frontier are split into components that share
+ * no numbers, and every way of placing mines in each component is counted by
+ * backtracking. Components are counted in parallel, and each result is
+ * cached by the component's shape, so components a move didn't touch aren't
+ * counted again. The components are then combined, weighting each total by
+ * the number of ways to place the rest of the mines among the hidden tiles
+ * no number touches.
+ */
+typedef struct Prob {
+  // Board being studied, and the solver keeping its frontier
+  Board *board;
+  Solver *solver;
+  // Threads to count components on, or 0 for one per core
+  int threads;
+  // Chance that each tile in board -> cells is a mine, from 0 to 1. Negative
+  // for exposed and border tiles.
+  float *grid;
+  // Tiles whose chance changed in the last update, and the chance each had
+  // before, up to CHANGES_MAX of them. If more changed, changes_overflow is
+  // set instead.
+  size_t *changes;
+  float *changes_from;
+  size_t changes_len;
+  bool changes_overflow;
+  // Hidden, unflagged tile least likely to be a mine, and its chance. The
+  // index is 0 if there isn't one.
+  size_t safest;
+  float safest_chance;
+  // Whether every chance is exact. Components too big to count in time, or
+  // too many to combine exactly, are estimated instead.
+  bool exact;
+  // Components found in the last update, and how many came from the cache
+  size_t components;
+  size_t cache_hits;
+  // Working memory, kept between updates
+  struct prob_work *work;
+} Prob;
+
+
+/**
+ * Constructor for a Prob.
+ *
+ * @param board the board to study
+ * @param solver the solver keeping the board's frontier
+ * @param threads threads to count components on, or 0 for one per core
+ * @return the newly created Prob, or NULL if there isn't enough memory
+ */
+Prob *newProb(Board *board, Solver *solver, int threads);
+
+/**
+ * Frees a Prob and everything it holds. Leaves its board and solver alone.
+ *
+ * @param prob the prob to free
+ */
+void prob_free(Prob *prob);
+
+/**
+ * Works out how much memory the odds for a board of a given size take up
+ * front: a float of odds and an int variable number per tile, and the list of
+ * changed odds. Its work lists grow with the frontier.
+ *
+ * @param width the horizontal count of tiles across the board
+ * @param height the vertical count of tiles across the board
+ * @return the number of bytes, or 0 if the size is out of range or too big to
+ *  address
+ */
+size_t prob_bytes(int width, int height);
+
+/**
+ * Works out the chance of a mine on every hidden tile, into prob -> grid.
+ * The solver must be up to date with the board, and solved.
+ *
+ * @param prob the prob to update
+ * @return 0 if successful, else 1 if no placement of the mines fits the
+ *  numbers showing.
+ */
+int prob_update(Prob *prob);
+
+#endif
@@ -0,0 +1,917 @@
+#define _XOPEN_SOURCE 700
+
+#include "render.h"
+#include "log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <stdbool.h>
+
+///** Resets all color / format settings. */
+//#define COLOR_NC "\033[0m"
+///** Fades the foreground color when printed. */
+//#define COLOR_FADE "\033[2m"
+///** Underlines the foreground when printed. */
+//#define COLOR_UNDERLINE "\033[4m"
+///** Inverts the background and foreground colors when printed. */
+//#define COLOR_INV "\033[7m"
+
+/** Format code for clearing all formatting. */
+#define FMT_NONE 0
+/** Format code for dimming. */
+#define FMT_DIM 2
+/** Format code for underlining. */
+#define FMT_UND 4
+/** Format for inverting foreground and background colors. */
+#define FMT_INV 7
+/** Color code for red */
+#define COLOR_RED 31 // To be used for 5's as "Maroon"
+/** Color code for green */
+#define COLOR_GREEN 33
+/** Color code for blue */
+#define COLOR_BLUE 34
+/** Color code for magenta */
+#define COLOR_MAGENTA 35
+/** Color code for cyan */
+#define COLOR_CYAN 36
+/** Color code for light gray */
+#define COLOR_L_GRAY 37
+/** Color code for background red */
+#define COLOR_BG_RED 41
+/** Color code for dark gray */
+#define COLOR_D_GRAY 90
+/** Color code for light red */
+#define COLOR_L_RED 91
+/** Color code for light green */
+#define COLOR_L_GREEN 92
+/** Color code for light yellow */
+#define COLOR_L_YELLOW 93
+/** Color code for whilte */
+#define COLOR_WHITE 97
+/** Color code for background green */
+#define COLOR_BG_GREEN 42
+/** Color code for background yellow */
+#define COLOR_BG_YELLOW 43
+/** Color code for background as light red */
+#define COLOR_BG_L_RED 101
+/** Color code for background as light green */
+#define COLOR_BG_L_GREEN 102
+/** Color code for background as light yellow */
+#define COLOR_BG_L_YELLOW 103
+
+/** Expands a style code before turning it into a string. */
+#define STRINGIFY(code) #code
+/** The escape sequence that applies a style code, as a string literal. */
+#define ESC(code) "\033[" STRINGIFY(code) "m"
+/** A Style table entry for a string literal escape sequence. */
+#define STYLE(seq) { seq, sizeof(seq) - 1 }
+
+/** Sequence printed after every tile to clear its styling. */
+#define RESET ESC(FMT_NONE)
+
+/** Initial size of a frame's buffer. */
+#define FRAME_INITIAL_CAPACITY 4096
+
+/** Escape sequence moving the cursor home and clearing the terminal. */
+#define CLEAR_SCREEN "\033[H\033[2J"
+/** Escape sequence clearing from the cursor to the end of the terminal. */
+#define CLEAR_BELOW "\033[J"
+/** Longest escape sequence moving the cursor to a row and column. */
+#define MOVE_MAX sizeof("\033[65535;65535H")
+
+/** Lines left free below the board for prompts when fitting a view. */
+#define VIEW_SPARE_LINES 4
+
+/**
+ * Fraction of the view that can change before the whole view is redrawn
+ * instead, as 1 in this many tiles. Each changed tile also redraws its
+ * neighbors, and costs a cursor move on top of the tile itself.
+ */
+#define REDRAW_FRACTION 8
+
+/** Set when the terminal is resized, until the next update notices. */
+static volatile sig_atomic_t resized = 0;
+
+/** Chance of a mine on each tile, shown behind hidden tiles, or NULL. */
+static const float *heatmap = NULL;
+/** Set when the heatmap changes, until the next update redraws it. */
+static bool heat_changed = false;
+
+/**
+ * An escape sequence applied before a tile is printed.
+ */
+typedef struct style_struct {
+  const char *seq;
+  size_t length;
+} Style;
+
+/** Index into STYLES for a tile printed with no styling. */
+#define STYLE_PLAIN 0
+/** Index into STYLES for the tile under the cursor. */
+#define STYLE_CURSOR 1
+/** Index into STYLES for an exposed flag with no bomb under it. */
+#define STYLE_WRONG_FLAG 2
+/** Index into STYLES for a flag, or an exposed bomb. */
+#define STYLE_FLAG 3
+/** Index into STYLES for an exposed 1. Numbers 2-8 follow in order. */
+#define STYLE_NUMBER 4
+/** Index into STYLES for an exposed, faded 1. Numbers 2-8 follow in order. */
+#define STYLE_NUMBER_DIM 12
+/**
+ * Index into STYLES for a hidden tile that's surely safe, on the heatmap.
+ * Tiles more and more likely to be mines follow, through a sure mine.
+ */
+#define STYLE_HEAT 20
+/** Number of heatmap styles. */
+#define HEAT_LEVELS 6
+
+/**
+ * Escape sequences for each way a tile can be styled, so rendering never has
+ * to format one.
+ */
+static const Style STYLES[] = {
+  STYLE(""),
+  STYLE(ESC(FMT_INV)),
+  STYLE(ESC(COLOR_BG_L_RED)),
+  STYLE(ESC(COLOR_BG_RED)),
+  // Numbers
+  STYLE(ESC(COLOR_BLUE)),
+  STYLE(ESC(COLOR_L_GREEN)),
+  STYLE(ESC(COLOR_L_RED)),
+  STYLE(ESC(COLOR_MAGENTA)),
+  STYLE(ESC(COLOR_RED)),
+  STYLE(ESC(COLOR_CYAN)),
+  STYLE(ESC(COLOR_D_GRAY)),
+  STYLE(ESC(COLOR_L_GRAY)),
+  // Faded numbers, with nothing left to expose around them
+  STYLE(ESC(COLOR_BLUE) ESC(FMT_DIM)),
+  STYLE(ESC(COLOR_L_GREEN) ESC(FMT_DIM)),
+  STYLE(ESC(COLOR_L_RED) ESC(FMT_DIM)),
+  STYLE(ESC(COLOR_MAGENTA) ESC(FMT_DIM)),
+  STYLE(ESC(COLOR_RED) ESC(FMT_DIM)),
+  STYLE(ESC(COLOR_CYAN) ESC(FMT_DIM)),
+  STYLE(ESC(COLOR_D_GRAY) ESC(FMT_DIM)),
+  STYLE(ESC(COLOR_L_GRAY) ESC(FMT_DIM)),
+  // Heatmap, from surely safe to surely a mine
+  STYLE(ESC(COLOR_BG_GREEN)),
+  STYLE(ESC(COLOR_BG_L_GREEN)),
+  STYLE(ESC(COLOR_BG_L_YELLOW)),
+  STYLE(ESC(COLOR_BG_YELLOW)),
+  STYLE(ESC(COLOR_BG_L_RED)),
+  STYLE(ESC(COLOR_BG_RED)),
+};
+
+/**
+ * Gets the current time in milliseconds from a monotonic clock.
+ *
+ * @return the current time in milliseconds
+ */
+static double now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/**
+ * Initializes an empty frame.
+ *
+ * @param frame the frame to initialize
+ */
+void frame_init(Frame *frame) {
+  frame -> data = NULL;
+  frame -> length = 0;
+  frame -> capacity = 0;
+  frame -> bytes = 0;
+  frame -> render_ms = 0;
+}
+
+/**
+ * Frees a frame's buffer.
+ *
+ * @param frame the frame to free
+ */
+void frame_free(Frame *frame) {
+  free(frame -> data);
+  frame_init(frame);
+}
+
+/**
+ * Makes sure a frame has room for more bytes, doubling its buffer as needed.
+ *
+ * @param frame the frame to grow
+ * @param length the number of bytes that are about to be added
+ */
+static void frame_reserve(Frame *frame, size_t length) {
+  if ( frame -> length + length <= frame -> capacity ) {
+    return;
+  }
+  size_t capacity = frame -> capacity ? frame -> capacity
+    : FRAME_INITIAL_CAPACITY;
+  while ( capacity < frame -> length + length ) {
+    capacity *= 2;
+  }
+  char *data = realloc(frame -> data, capacity);
+  if ( !data ) {
+    LOG_ERROR("Out of memory growing frame to %zu bytes.", capacity);
+    exit(EXIT_FAILURE);
+  }
+  frame -> data = data;
+  frame -> capacity = capacity;
+}
+
+/**
+ * Adds bytes to the end of a frame, growing its buffer if needed.
+ *
+ * @param frame the frame to add to
+ * @param bytes the bytes to add
+ * @param length the number of bytes to add
+ */
+void frame_append(Frame *frame, const char *bytes, size_t length) {
+  frame_reserve(frame, length);
+  memcpy(frame -> data + frame -> length, bytes, length);
+  frame -> length += length;
+}
+
+/**
+ * Adds a string literal to the end of a frame.
+ */
+#define frame_literal(frame, str) frame_append(frame, str, sizeof(str) - 1)
+
+/**
+ * Sends a frame's contents to a file descriptor with a single write, then
+ * empties it. Only retries if the write is interrupted or cut short.
+ *
+ * @param frame the frame to send
+ * @param fd the file descriptor to write to
+ * @return 0 if successful, else -1 if the write failed.
+ */
+int frame_flush(Frame *frame, int fd) {
+  size_t sent = 0;
+  while ( sent < frame -> length ) {
+    ssize_t written = write(fd, frame -> data + sent, frame -> length - sent);
+    if ( written < 0 ) {
+      if ( errno == EINTR ) {
+        continue;
+      }
+      LOG_ERROR("Failed to write frame: %s", strerror(errno));
+      frame -> length = 0;
+      return -1;
+    }
+    sent += written;
+  }
+  frame -> bytes = sent;
+  frame -> length = 0;
+  return 0;
+}
+
+/**
+ * Picks the heatmap shade for a chance of a mine. Sure tiles get the ends of
+ * the scale, and the rest share the middle.
+ *
+ * @param chance the chance of a mine, from 0 to 1, or negative for none
+ * @return the shade, from 0 to HEAT_LEVELS - 1, or -1 to leave it unshaded
+ */
+static int heat_level(float chance) {
+  if ( chance < 0 ) {
+    return -1;
+  }
+  return chance <= 0 ? 0 : chance >= 1 ? HEAT_LEVELS - 1
+    : 1 + (int) ( chance * ( HEAT_LEVELS - 2 ) );
+}
+
+/**
+ * Picks how a tile should be styled.
+ *
+ * @param board the board the tile is on
+ * @param x the x position of the tile
+ * @param y the y position of the tile
+ * @return an index into STYLES
+ */
+static int tile_style(Board *board, int x, int y) {
+  size_t index = board_index(board, x, y);
+  Tile tile = board -> cells[index];
+  short bomb = tile_bomb(tile);
+
+  // If this tile is selected
+  if ( y == board -> cur_y && x == board -> cur_x ) {
+    // Print this tile, inverted
+    return STYLE_CURSOR;
+  }
+  // If this tile is flagged INCORRECTLY, and exposed
+  if ( tile_is_flagged(tile) && tile_is_exposed(tile) && bomb != BOMB_HERE ) {
+    // Print with background as light red
+    return STYLE_WRONG_FLAG;
+  }
+  // If this tile is flagged or an exposed bomb
+  if ( tile_is_flagged(tile) || ( tile_is_exposed(tile) && bomb == BOMB_HERE ) ) {
+    // Print with background as red
+    return STYLE_FLAG;
+  }
+  // If this tile is an exposed number
+  if ( tile_is_exposed(tile) && bomb > 0 && bomb < BOMB_HERE ) {
+    // If it's satisfied, but there's still nearby blanks, it could be
+    // underlined, but that's a bit cheat-y. Otherwise, if there are no
+    // nearby blanks, print it faded.
+    if ( board_tile_done(board, index) ) {
+      return STYLE_NUMBER_DIM + bomb - 1;
+    }
+    return STYLE_NUMBER + bomb - 1;
+  }
+  // If there's a heatmap, shade hidden tiles by their chance of a mine
+  if ( heatmap && !tile_is_exposed(tile) && heat_level(heatmap[index]) >= 0 ) {
+    return STYLE_HEAT + heat_level(heatmap[index]);
+  }
+  return STYLE_PLAIN;
+}
+
+/**
+ * Writes one tile to a buffer: its styling, the tile, then a reset.
+ * There must be room for at least TILE_MAX bytes.
+ *
+ * @param out where to write the tile
+ * @param board the board the tile is on
+ * @param x the x position of the tile
+ * @param y the y position of the tile
+ * @return the position just after what was written
+ */
+static char *write_tile(char *out, Board *board, int x, int y) {
+  const Style *style = &STYLES[tile_style(board, x, y)];
+  memcpy(out, style -> seq, style -> length);
+  out += style -> length;
+  *out++ = tile_toChar(*board_tile(board, x, y));
+  memcpy(out, RESET, sizeof(RESET) - 1);
+  return out + sizeof(RESET) - 1;
+}
+
+/** The longest write_tile can write: the longest style, tile, and reset. */
+#define TILE_MAX ( sizeof(ESC(COLOR_L_GRAY) ESC(FMT_DIM)) + sizeof(RESET) )
+
+/**
+ * Counts the digits in a positive number.
+ *
+ * @param number the number to count digits of
+ * @return the number of decimal digits
+ */
+static int digits(int number) {
+  int count = 1;
+  for ( ; number >= 10; number /= 10 ) {
+    count++;
+  }
+  return count;
+}
+
+/**
+ * Sets up the parts of a view that depend only on the board: how wide the row
+ * labels are and how many lines the column labels take.
+ *
+ * @param view the view to set up
+ * @param board the board it looks at
+ */
+static void view_labels(View *view, const Board *board) {
+  view -> label_width = digits(board -> height);
+  if ( view -> label_width < 2 ) {
+    view -> label_width = 2;
+  }
+  view -> header_lines = board_column_chars(board -> width);
+}
+
+/**
+ * Sets a view to show the whole board.
+ *
+ * @param view the view to set
+ * @param board the board it looks at
+ */
+void view_full(View *view, const Board *board) {
+  view_labels(view, board);
+  view -> x0 = 0;
+  view -> y0 = 0;
+  view -> cols = board -> width;
+  view -> rows = board -> height;
+}
+
+/**
+ * Moves the start of a view along one axis so the cursor is inside it. If the
+ * cursor is already inside, the view stays put; otherwise it's centered on
+ * the cursor. Either way it stays on the board.
+ *
+ * @param start the first position shown
+ * @param shown how many positions are shown
+ * @param total how many positions there are on the board
+ * @param cursor the position that needs to be shown
+ * @return the new first position shown
+ */
+static int scroll_axis(int start, int shown, int total, int cursor) {
+  if ( cursor < start || cursor >= start + shown ) {
+    start = cursor - shown / 2;
+  }
+  if ( start > total - shown ) {
+    start = total - shown;
+  }
+  if ( start < 0 ) {
+    start = 0;
+  }
+  return start;
+}
+
+/**
+ * Fits a view to the terminal, scrolling it as little as needed to keep the
+ * board's cursor inside. Room is left below the board for VIEW_SPARE_LINES of
+ * prompts.
+ *
+ * @param view the view to fit, holding where it was scrolled to before
+ * @param board the board it looks at
+ * @param term_rows the number of lines on the terminal
+ * @param term_cols the number of columns on the terminal
+ */
+void view_fit(View *view, const Board *board, unsigned short term_rows,
+    unsigned short term_cols) {
+  view_labels(view, board);
+
+  // Column labels, then top and bottom borders
+  int rows = (int) term_rows - view -> header_lines - 2 - VIEW_SPARE_LINES;
+  // Row labels and "| ", then 2 characters per tile, then "|"
+  int cols = ( (int) term_cols - view -> label_width - 2 - 1 ) / 2;
+  view -> rows = rows < 1 ? 1 : rows > board -> height ? board -> height : rows;
+  view -> cols = cols < 1 ? 1 : cols > board -> width ? board -> width : cols;
+
+  view -> x0 = scroll_axis(view -> x0, view -> cols, board -> width,
+      board -> cur_x);
+  view -> y0 = scroll_axis(view -> y0, view -> rows, board -> height,
+      board -> cur_y);
+}
+
+/**
+ * Adds a border row to a frame, of the form +-----+ for the given width.
+ *
+ * @param frame the frame to add to
+ * @param view the view being rendered
+ */
+static void render_border(Frame *frame, const View *view) {
+  size_t width = view -> cols;
+  frame_reserve(frame, view -> label_width + 2 * width + 4);
+  char *out = frame -> data + frame -> length;
+  memset(out, ' ', view -> label_width);
+  out += view -> label_width;
+  *out++ = '+';
+  *out++ = '-';
+  memset(out, '-', 2 * width);
+  out += 2 * width;
+  *out++ = '+';
+  *out++ = '\n';
+  frame -> length = out - frame -> data;
+}
+
+/**
+ * Adds the column labels to a frame. Names longer than one letter are
+ * stacked, one letter per line, right aligned, so every column stays 2
+ * characters wide.
+ *
+ * @param frame the frame to add to
+ * @param view the view being rendered
+ */
+static void render_header(Frame *frame, const View *view) {
+  size_t line_length = view -> label_width + 2 + 2 * (size_t) view -> cols + 1;
+  frame_reserve(frame, line_length * view -> header_lines);
+  char *line = frame -> data + frame -> length;
+  memset(line, ' ', line_length * view -> header_lines);
+
+  for ( int col = 0; col < view -> cols; col++ ) {
+    char name[COLUMN_NAME_MAX];
+    int length = board_column_name(view -> x0 + col, name);
+    // Skip past the row labels and "| " to this column's spot
+    size_t offset = view -> label_width + 2 + 2 * (size_t) col;
+    for ( int i = 0; i < length; i++ ) {
+      int header_line = view -> header_lines - length + i;
+      line[header_line * line_length + offset] = name[i];
+    }
+  }
+  for ( int i = 1; i <= view -> header_lines; i++ ) {
+    line[i * line_length - 1] = '\n';
+  }
+  frame -> length += line_length * view -> header_lines;
+}
+
+/**
+ * Adds a single row of the board to a frame.
+ * Includes a border around the edge, of the form:
+ *
+ * +---+
+ * |   |
+ * |   |
+ * +---+
+ * ( for 3x2 )
+ *
+ * @param frame the frame to add to
+ * @param y the y position of the row to print
+ * @param board the board to print data from
+ * @param view the view being rendered
+ */
+static void render_row(Frame *frame, int y, Board *board, const View *view) {
+  frame_reserve(frame, view -> label_width + 8
+      + (size_t) view -> cols * ( TILE_MAX + 1 ));
+  char *out = frame -> data + frame -> length;
+  out += sprintf(out, "%*d| ", view -> label_width, y + 1);
+  for ( int x = view -> x0; x < view -> x0 + view -> cols; x++ ) {
+    // Print this tile, then the space after it
+    out = write_tile(out, board, x, y);
+    *out++ = ' ';
+  }
+  memcpy(out, "|\n", 2);
+  out += 2;
+  frame -> length = out - frame -> data;
+}
+
+/**
+ * Composes part of the board into a frame, with column and row labels and a
+ * border around the edge. Only the tiles in the view are looked at.
+ *
+ * @param frame the frame to add to
+ * @param board the game board to render
+ * @param view the part of the board to render
+ */
+void render_view(Frame *frame, Board *board, const View *view) {
+  render_header(frame, view);
+  render_border(frame, view);
+  for ( int y = view -> y0; y < view -> y0 + view -> rows; y++ ) {
+    render_row(frame, y, board, view);
+  }
+  render_border(frame, view);
+}
+
+/**
+ * Composes the whole board into a frame, with column and row labels and a
+ * border around the edge.
+ *
+ * @param frame the frame to add the board to
+ * @param board the game board to render
+ */
+void render_board(Frame *frame, Board *board) {
+  View view;
+  view_full(&view, board);
+  render_view(frame, board, &view);
+}
+
+/**
+ * Prints the provided board to stdout. Includes a border around the edge.
+ * The whole board goes out in one write.
+ *
+ * @param board the game board to print
+ */
+void board_print(Board *board) {
+  static Frame frame = { 0 };
+
+  // Anything printed with stdio so far has to come out before the board
+  fflush(stdout);
+
+  double start = now_ms();
+  render_board(&frame, board);
+  frame_flush(&frame, STDOUT_FILENO);
+  frame.render_ms = now_ms() - start;
+
+  LOG_DEBUG("Board printed: %zu bytes in %.3f ms.", frame.bytes,
+      frame.render_ms);
+}
+
+/**
+ * Picks how a tile on a plane should be styled, the same way tile_style does
+ * for a board.
+ *
+ * @param plane the plane the tile is on
+ * @param x the x position of the tile
+ * @param y the y position of the tile
+ * @return an index into STYLES
+ */
+static int plane_style(Plane *plane, int64_t x, int64_t y) {
+  Tile tile = *plane_tile(plane, x, y);
+  short bomb = tile_bomb(tile);
+  if ( y == plane -> cur_y && x == plane -> cur_x ) {
+    return STYLE_CURSOR;
+  }
+  if ( tile_is_flagged(tile) || ( tile_is_exposed(tile) && bomb == BOMB_HERE ) ) {
+    return STYLE_FLAG;
+  }
+  if ( tile_is_exposed(tile) && bomb > 0 && bomb < BOMB_HERE ) {
+    int flags;
+    int blanks;
+    plane_around(plane, x, y, &flags, &blanks);
+    return ( blanks == 0 ? STYLE_NUMBER_DIM : STYLE_NUMBER ) + bomb - 1;
+  }
+  return STYLE_PLAIN;
+}
+
+/**
+ * Fits a plane's view to the terminal, scrolling it as little as needed to
+ * keep the plane's cursor inside, and leaving a few lines free below it.
+ *
+ * @param view the view to fit, holding where it was scrolled to before
+ * @param plane the plane it looks at
+ * @param term_rows the number of lines on the terminal
+ * @param term_cols the number of columns on the terminal
+ */
+void plane_view_fit(PlaneView *view, const Plane *plane,
+    unsigned short term_rows, unsigned short term_cols) {
+  // Top and bottom borders, then "| ", 2 characters per tile, and "|"
+  int rows = (int) term_rows - 2 - VIEW_SPARE_LINES;
+  int cols = ( (int) term_cols - 2 - 1 ) / 2;
+  view -> rows = rows < 1 ? 1 : rows;
+  view -> cols = cols < 1 ? 1 : cols;
+  if ( plane -> cur_x < view -> x0 || plane -> cur_x >= view -> x0 + view -> cols ) {
+    view -> x0 = plane -> cur_x - view -> cols / 2;
+  }
+  if ( plane -> cur_y < view -> y0 || plane -> cur_y >= view -> y0 + view -> rows ) {
+    view -> y0 = plane -> cur_y - view -> rows / 2;
+  }
+}
+
+/**
+ * Composes part of a plane into a frame, drawn over whatever's on the
+ * terminal from the top left, with a border around the edge and everything
+ * below it cleared. Makes the chunks in view if they don't exist yet.
+ *
+ * @param frame the frame to add to
+ * @param plane the plane to render
+ * @param view the part of the plane to render
+ */
+void render_plane(Frame *frame, Plane *plane, const PlaneView *view) {
+  View border = { 0, 0, view -> cols, view -> rows, 0, 0 };
+  frame_literal(frame, "\033[H");
+  render_border(frame, &border);
+  for ( int row = 0; row < view -> rows; row++ ) {
+    frame_reserve(frame, 4 + view -> cols * ( TILE_MAX + 1 ));
+    char *out = frame -> data + frame -> length;
+    *out++ = '|';
+    *out++ = ' ';
+    int64_t y = view -> y0 + row;
+    for ( int64_t x = view -> x0; x < view -> x0 + view -> cols; x++ ) {
+      const Style *style = &STYLES[plane_style(plane, x, y)];
+      memcpy(out, style -> seq, style -> length);
+      out += style -> length;
+      *out++ = tile_toChar(*plane_tile(plane, x, y));
+      memcpy(out, RESET " ", sizeof(RESET));
+      out += sizeof(RESET);
+    }
+    memcpy(out, "|\n", 2);
+    frame -> length = out + 2 - frame -> data;
+  }
+  render_border(frame, &border);
+  frame_literal(frame, CLEAR_BELOW);
+}
+
+/**
+ * Shades hidden tiles by their chance of being a mine, from green for surely
+ * safe through red for surely a mine. Turning shading on or off, or shading
+ * from another grid, redraws the board on the next update. Changes within the
+ * same grid are only redrawn for tiles on the board's change list.
+ *
+ * @param grid the chance of a mine on each tile in the board's cells, from 0
+ *  to 1, or negative to leave a tile unshaded. NULL turns shading off. Read
+ *  each time a tile is drawn, so it must last until it's turned off.
+ */
+void render_heatmap(const float *grid) {
+  heat_changed = heat_changed || grid != heatmap;
+  heatmap = grid;
+}
+
+/**
+ * Checks whether two chances of a mine are shaded the same on the heatmap,
+ * so a tile going from one to the other needn't be redrawn.
+ *
+ * @param before the chance the tile had
+ * @param after the chance the tile has now
+ * @return true if they're shaded the same
+ */
+bool render_heat_alike(float before, float after) {
+  return heat_level(before) == heat_level(after);
+}
+
+/**
+ * Notes that the terminal was resized.
+ *
+ * @param signal the signal received, SIGWINCH
+ */
+static void on_resize(int signal) {
+  (void) signal;
+  resized = 1;
+}
+
+/**
+ * Works out how much memory a screen takes to draw a board of a given size,
+ * past its frame: a redraw mark per tile.
+ *
+ * @param width the horizontal count of tiles across the board
+ * @param height the vertical count of tiles across the board
+ * @return the number of bytes, or 0 if the size is out of range or too big to
+ *  address
+ */
+size_t screen_bytes(int width, int height) {
+  if ( board_bytes(width, height) == 0 ) {
+    return 0;
+  }
+  // Marks cover the border ring too
+  return ( (size_t) width + 2 ) * ( (size_t) height + 2 );
+}
+
+/**
+ * Initializes a screen with nothing drawn on it. If stdout is a terminal,
+ * starts watching for it to be resized.
+ *
+ * @param screen the screen to initialize
+ */
+void screen_init(Screen *screen) {
+  frame_init(&screen -> frame);
+  screen -> drawn = false;
+  memset(&screen -> view, 0, sizeof(View));
+  screen -> seen = NULL;
+  screen -> seen_len = 0;
+  screen -> full_redraws = 0;
+  screen -> diff_updates = 0;
+
+  if ( isatty(STDOUT_FILENO) ) {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = on_resize;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGWINCH, &action, NULL);
+  }
+}
+
+/**
+ * Frees a screen's buffers.
+ *
+ * @param screen the screen to free
+ */
+void screen_free(Screen *screen) {
+  frame_free(&screen -> frame);
+  free(screen -> seen);
+  screen -> seen = NULL;
+  screen -> seen_len = 0;
+  screen -> drawn = false;
+}
+
+/**
+ * Adds one tile to a frame, moving the terminal's cursor to it first.
+ * The tile must be inside the view.
+ *
+ * @param frame the frame to add to
+ * @param board the board the tile is on
+ * @param view the view on the terminal
+ * @param x the x position of the tile
+ * @param y the y position of the tile
+ */
+static void render_tile_at(Frame *frame, Board *board, const View *view,
+    int x, int y) {
+  frame_reserve(frame, MOVE_MAX + TILE_MAX);
+  char *out = frame -> data + frame -> length;
+  // Below the column labels and top border, right of the row labels and "| "
+  int row = view -> header_lines + 1 + ( y - view -> y0 ) + 1;
+  int column = view -> label_width + 2 + 2 * ( x - view -> x0 ) + 1;
+  out += sprintf(out, "\033[%d;%dH", row, column);
+  out = write_tile(out, board, x, y);
+  frame -> length = out - frame -> data;
+}
+
+/**
+ * Redraws a tile and its neighbors, unless they've been redrawn already or
+ * are out of view. A tile's neighbors can change style when it changes, when
+ * they run out of blanks around them.
+ *
+ * @param screen the screen being updated
+ * @param board the board the tile is on
+ * @param index the index of the tile that changed
+ */
+static void render_change(Screen *screen, Board *board, size_t index) {
+  const View *view = &screen -> view;
+  for ( int i = -1; i < 8; i++ ) {
+    size_t near = i < 0 ? index : index + board -> nearby[i];
+    if ( screen -> seen[near] || ( board -> cells[near] & TILE_BORDER ) ) {
+      continue;
+    }
+    screen -> seen[near] = true;
+    int x = board_x(board, near);
+    int y = board_y(board, near);
+    if ( x < view -> x0 || x >= view -> x0 + view -> cols
+        || y < view -> y0 || y >= view -> y0 + view -> rows ) {
+      continue;
+    }
+    render_tile_at(&screen -> frame, board, view, x, y);
+  }
+}
+
+/**
+ * Un-marks a tile and its neighbors as redrawn, ready for the next update.
+ *
+ * @param screen the screen being updated
+ * @param board the board the tile is on
+ * @param index the index of the tile that changed
+ */
+static void forget_change(Screen *screen, Board *board, size_t index) {
+  screen -> seen[index] = false;
+  for ( int i = 0; i < 8; i++ ) {
+    screen -> seen[index + board -> nearby[i]] = false;
+  }
+}
+
+/**
+ * Brings the terminal up to date with the board, then clears the board's
+ * list of changes. See render.h for when the whole board gets redrawn.
+ *
+ * @param screen what's currently on the terminal
+ * @param board the game board to show
+ */
+void screen_update(Screen *screen, Board *board) {
+  Frame *frame = &screen -> frame;
+
+  // Anything printed with stdio so far has to come out before the board
+  fflush(stdout);
+  double start = now_ms();
+
+  // Not a terminal, so there's nowhere to move the cursor to
+  if ( !isatty(STDOUT_FILENO) ) {
+    render_board(frame, board);
+    frame_flush(frame, STDOUT_FILENO);
+    frame -> render_ms = now_ms() - start;
+    board_changes_clear(board);
+    return;
+  }
+
+  // Fit the view to the terminal, scrolling to follow the cursor
+  struct winsize size = { 0 };
+  ioctl(STDOUT_FILENO, TIOCGWINSZ, &size);
+  View old = screen -> view;
+  view_fit(&screen -> view, board, size.ws_row, size.ws_col);
+  const View *view = &screen -> view;
+
+  // Make sure there's a mark for every tile, border included, for redrawing
+  // only what changed
+  size_t len_total = (size_t) board -> stride * ( board -> height + 2 );
+  if ( screen -> seen_len != len_total ) {
+    free(screen -> seen);
+    screen -> seen = calloc(len_total, sizeof(unsigned char));
+    screen -> seen_len = screen -> seen ? len_total : 0;
+    if ( !screen -> seen ) {
+      LOG_DEBUG("Out of memory for %zu redraw marks, redrawing in full.",
+          len_total);
+    }
+  }
+
+  // Check whether anything forces a full redraw. Without marks, every frame
+  // is one.
+  size_t shown = (size_t) view -> cols * view -> rows;
+  bool full = !screen -> drawn || !screen -> seen || resized || heat_changed
+    || size.ws_row != screen -> rows || size.ws_col != screen -> cols
+    || board -> width != screen -> width || board -> height != screen -> height
+    || memcmp(&old, view, sizeof(View)) != 0
+    || board -> changes_overflow
+    || board -> changes_len > shown / REDRAW_FRACTION;
+
+  if ( full ) {
+    frame_literal(frame, CLEAR_SCREEN);
+    render_view(frame, board, view);
+    screen -> drawn = true;
+    resized = 0;
+    heat_changed = false;
+    screen -> rows = size.ws_row;
+    screen -> cols = size.ws_col;
+    screen -> width = board -> width;
+    screen -> height = board -> height;
+    screen -> full_redraws++;
+  } else {
+    // Redraw each changed tile, and the cursor where it was and where it is
+    for ( size_t i = 0; i < board -> changes_len; i++ ) {
+      render_change(screen, board, board -> changes[i]);
+    }
+    size_t cursor_old = board_index(board, screen -> cur_x, screen -> cur_y);
+    size_t cursor_new = board_index(board, board -> cur_x, board -> cur_y);
+    render_change(screen, board, cursor_old);
+    render_change(screen, board, cursor_new);
+
+    // Clear the marks for next time
+    for ( size_t i = 0; i < board -> changes_len; i++ ) {
+      forget_change(screen, board, board -> changes[i]);
+    }
+    forget_change(screen, board, cursor_old);
+    forget_change(screen, board, cursor_new);
+
+    // Leave the cursor below the board, like a full redraw does
+    frame_reserve(frame, MOVE_MAX + sizeof(CLEAR_BELOW));
+    frame -> length += sprintf(frame -> data + frame -> length,
+        "\033[%d;1H" CLEAR_BELOW, view -> header_lines + view -> rows + 3);
+    screen -> diff_updates++;
+  }
+  screen -> cur_x = board -> cur_x;
+  screen -> cur_y = board -> cur_y;
+
+  frame_flush(frame, STDOUT_FILENO);
+  frame -> render_ms = now_ms() - start;
+  board_changes_clear(board);
+
+  LOG_DEBUG("Screen %s: %zu bytes in %.3f ms.", full ? "redrawn" : "updated",
+      frame -> bytes, frame -> render_ms);
+}
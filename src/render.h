@@ -0,0 +1,248 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <stddef.h>
+#include "board.h"
+#include "plane.h"
+
+/**
+ * A frame of output being composed for the terminal. The buffer is kept
+ * between frames, so once it has grown to fit the board, rendering doesn't
+ * allocate.
+ */
+typedef struct Frame {
+  // Bytes composed so far
+  char *data;
+  size_t length;
+  size_t capacity;
+  // Size of the last frame sent, and how long it took to compose and send
+  size_t bytes;
+  double render_ms;
+} Frame;
+
+/**
+ * The part of a board that gets rendered, and how its labels are laid out.
+ */
+typedef struct View {
+  // First column and row shown, and how many of each
+  int x0;
+  int y0;
+  int cols;
+  int rows;
+  // Width of the row labels, in digits
+  int label_width;
+  // Lines taken by the column labels, one per letter of the longest name
+  int header_lines;
+} View;
+
+/**
+ * The part of an endless plane that gets rendered.
+ */
+typedef struct PlaneView {
+  // Top left tile shown, and how many columns and rows
+  int64_t x0;
+  int64_t y0;
+  int cols;
+  int rows;
+} PlaneView;
+
+/**
+ * What's currently shown on the terminal, so that only the tiles that changed
+ * since the last frame need to be sent.
+ */
+typedef struct Screen {
+  // Frame reused for every update
+  Frame frame;
+  // Whether a full board is on the terminal, drawn from the top left
+  _Bool drawn;
+  // Size of the board last drawn, and where its cursor was
+  int width;
+  int height;
+  int cur_x;
+  int cur_y;
+  // Part of the board on the terminal
+  View view;
+  // Size of the terminal when the board was last fully drawn
+  unsigned short rows;
+  unsigned short cols;
+  // Marks tiles already redrawn during an update. Sized to the board.
+  unsigned char *seen;
+  size_t seen_len;
+  // How many updates were full redraws, and how many only sent changes
+  size_t full_redraws;
+  size_t diff_updates;
+} Screen;
+
+
+/**
+ * Initializes an empty frame.
+ *
+ * @param frame the frame to initialize
+ */
+void frame_init(Frame *frame);
+
+/**
+ * Frees a frame's buffer.
+ *
+ * @param frame the frame to free
+ */
+void frame_free(Frame *frame);
+
+/**
+ * Adds bytes to the end of a frame, growing its buffer if needed.
+ *
+ * @param frame the frame to add to
+ * @param bytes the bytes to add
+ * @param length the number of bytes to add
+ */
+void frame_append(Frame *frame, const char *bytes, size_t length);
+
+/**
+ * Sends a frame's contents to a file descriptor with a single write, then
+ * empties it.
+ *
+ * @param frame the frame to send
+ * @param fd the file descriptor to write to
+ * @return 0 if successful, else -1 if the write failed.
+ */
+int frame_flush(Frame *frame, int fd);
+
+/**
+ * Sets a view to show the whole board.
+ *
+ * @param view the view to set
+ * @param board the board it looks at
+ */
+void view_full(View *view, const Board *board);
+
+/**
+ * Fits a view to the terminal, scrolling it as little as needed to keep the
+ * board's cursor inside, and leaving a few lines free below the board.
+ *
+ * @param view the view to fit, holding where it was scrolled to before
+ * @param board the board it looks at
+ * @param term_rows the number of lines on the terminal
+ * @param term_cols the number of columns on the terminal
+ */
+void view_fit(View *view, const Board *board, unsigned short term_rows,
+    unsigned short term_cols);
+
+/**
+ * Composes part of the board into a frame, with column and row labels and a
+ * border around the edge. Only the tiles in the view are looked at, so the
+ * cost depends on the view's size, not the board's.
+ *
+ * @param frame the frame to add to
+ * @param board the game board to render
+ * @param view the part of the board to render
+ */
+void render_view(Frame *frame, Board *board, const View *view);
+
+/**
+ * Composes the whole board into a frame, with column and row labels and a
+ * border around the edge.
+ *
+ * @param frame the frame to add the board to
+ * @param board the game board to render
+ */
+void render_board(Frame *frame, Board *board);
+
+/**
+ * Fits a plane's view to the terminal, scrolling it as little as needed to
+ * keep the plane's cursor inside, and leaving a few lines free below it.
+ *
+ * @param view the view to fit, holding where it was scrolled to before
+ * @param plane the plane it looks at
+ * @param term_rows the number of lines on the terminal
+ * @param term_cols the number of columns on the terminal
+ */
+void plane_view_fit(PlaneView *view, const Plane *plane,
+    unsigned short term_rows, unsigned short term_cols);
+
+/**
+ * Composes part of a plane into a frame, drawn over whatever's on the
+ * terminal from the top left, with a border around the edge and everything
+ * below it cleared. Makes the chunks in view if they don't exist yet.
+ *
+ * @param frame the frame to add to
+ * @param plane the plane to render
+ * @param view the part of the plane to render
+ */
+void render_plane(Frame *frame, Plane *plane, const PlaneView *view);
+
+/**
+ * Shades hidden tiles by their chance of being a mine, from green for surely
+ * safe through red for surely a mine. Turning shading on or off, or shading
+ * from another grid, redraws the board on the next update. Changes within the
+ * same grid are only redrawn for tiles on the board's change list.
+ *
+ * @param grid the chance of a mine on each tile in the board's cells, from 0
+ *  to 1, or negative to leave a tile unshaded. NULL turns shading off. Read
+ *  each time a tile is drawn, so it must last until it's turned off.
+ */
+void render_heatmap(const float *grid);
+
+/**
+ * Checks whether two chances of a mine are shaded the same on the heatmap,
+ * so a tile going from one to the other needn't be redrawn.
+ *
+ * @param before the chance the tile had
+ * @param after the chance the tile has now
+ * @return true if they're shaded the same
+ */
+_Bool render_heat_alike(float before, float after);
+
+/**
+ * Works out how much memory a screen takes to draw a board of a given size,
+ * past its frame: a redraw mark per tile.
+ *
+ * @param width the horizontal count of tiles across the board
+ * @param height the vertical count of tiles across the board
+ * @return the number of bytes, or 0 if the size is out of range or too big to
+ *  address
+ */
+size_t screen_bytes(int width, int height);
+
+/**
+ * Initializes a screen with nothing drawn on it. If stdout is a terminal,
+ * starts watching for it to be resized.
+ *
+ * @param screen the screen to initialize
+ */
+void screen_init(Screen *screen);
+
+/**
+ * Frees a screen's buffers.
+ *
+ * @param screen the screen to free
+ */
+void screen_free(Screen *screen);
+
+/**
+ * Brings the terminal up to date with the board, then clears the board's
+ * list of changes.
+ *
+ * On a terminal, only the part of the board around the cursor that fits is
+ * shown, scrolling as the cursor moves. Only the tiles that changed, their
+ * neighbors, and the old and new cursor positions are sent, each by moving
+ * the terminal's cursor straight to it. The whole view is redrawn instead the
+ * first time, when the terminal or board was resized, when the view scrolled,
+ * or when so much changed that a full redraw is cheaper. If stdout isn't a terminal,
+ * the whole board is printed every time, like board_print.
+ *
+ * Either way, the terminal's cursor is left on the line below the board,
+ * with everything after it cleared.
+ *
+ * @param screen what's currently on the terminal
+ * @param board the game board to show
+ */
+void screen_update(Screen *screen, Board *board);
+
+/**
+ * Prints the provided board to stdout. Includes a border around the edge.
+ *
+ * @param board the game board to print
+ */
+void board_print(Board *board);
+
+#endif
@@ -0,0 +1,399 @@
+#define _XOPEN_SOURCE 700
+
+#include "replay.h"
+#include "render.h"
+#include "pool.h"
+#include "batch.h"
+#include "log.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <unistd.h>
+
+/** Size of the block the stream is read into. Also the longest line. */
+#define REPLAY_BUFFER 65536
+/** Most idle boards kept for later games, one per size recently played. */
+#define REPLAY_POOL_BOARDS 4
+
+/**
+ * Reads a stream one line at a time, handing out lines in place in its
+ * buffer instead of copying them.
+ */
+typedef struct Reader {
+  int fd;
+  // Bytes read but not handed out yet are data[start] to data[end]
+  char data[REPLAY_BUFFER];
+  size_t start;
+  size_t end;
+  bool eof;
+  // Whether the rest of a line too long for the buffer is being thrown away
+  bool skipping;
+  // Number of the last line handed out, from 1
+  unsigned long line;
+} Reader;
+
+/**
+ * A replay in progress: the board being played, and how its game is going.
+ */
+typedef struct Replay {
+  const ReplayConfig *config;
+  ReplayResult *result;
+  // Boards from earlier games, kept to start later ones of the same size on
+  Board *board;
+  BoardPool pool;
+  // Whether a game has started, and whether it has been won or lost
+  bool playing;
+  bool over;
+} Replay;
+
+/**
+ * Gets the next line from the stream, without its newline.
+ *
+ * @param reader the reader to read from
+ * @param line where to place a pointer to the start of the line, which stays
+ *  good until the next call
+ * @param length where to place the length of the line
+ * @return true if there was a line, false at the end of the stream
+ */
+static bool reader_next(Reader *reader, const char **line, size_t *length) {
+  while ( true ) {
+    // Hand out the next full line, if there's one in the buffer
+    char *start = reader -> data + reader -> start;
+    char *newline = memchr(start, '\n', reader -> end - reader -> start);
+    if ( newline ) {
+      reader -> start = newline + 1 - reader -> data;
+      reader -> line++;
+      if ( reader -> skipping ) {
+        reader -> skipping = false;
+        continue;
+      }
+      *line = start;
+      *length = newline - start;
+      return true;
+    }
+    // At the end, hand out whatever's left as the last line
+    if ( reader -> eof ) {
+      if ( reader -> start == reader -> end || reader -> skipping ) {
+        return false;
+      }
+      reader -> line++;
+      *line = start;
+      *length = reader -> end - reader -> start;
+      reader -> start = reader -> end;
+      return true;
+    }
+
+    // Move the partial line to the front, and fill in after it
+    memmove(reader -> data, start, reader -> end - reader -> start);
+    reader -> end -= reader -> start;
+    reader -> start = 0;
+    if ( reader -> end == REPLAY_BUFFER ) {
+      LOG_ERROR("Line %lu is too long, skipping it.", reader -> line + 1);
+      reader -> skipping = true;
+      reader -> end = 0;
+    }
+    ssize_t got = read(reader -> fd, reader -> data + reader -> end,
+        REPLAY_BUFFER - reader -> end);
+    if ( got < 0 && errno == EINTR ) {
+      continue;
+    }
+    if ( got < 0 ) {
+      LOG_ERROR("Problem reading moves: %s", strerror(errno));
+    }
+    if ( got <= 0 ) {
+      reader -> eof = true;
+    } else {
+      reader -> end += got;
+    }
+  }
+}
+
+/**
+ * Skips over spaces and tabs, and any carriage return.
+ *
+ * @param at the position to skip from, moved past the spaces
+ * @param end the end of the line
+ */
+static void skip_spaces(const char **at, const char *end) {
+  while ( *at < end && ( **at == ' ' || **at == '\t' || **at == '\r' ) ) {
+    ( *at )++;
+  }
+}
+
+/**
+ * Checks that nothing but spaces or a comment is left on a line.
+ *
+ * @param at the position to check from
+ * @param end the end of the line
+ * @return true if the rest of the line is empty
+ */
+static bool at_line_end(const char *at, const char *end) {
+  skip_spaces(&at, end);
+  return at == end || *at == '#';
+}
+
+/**
+ * Reads a number written in decimal digits, after any spaces.
+ *
+ * @param at the position to read from, moved past the number
+ * @param end the end of the line
+ * @param value where to place the number
+ * @return true if there was a number that fits in 64 bits
+ */
+static bool read_number(const char **at, const char *end, uint64_t *value) {
+  skip_spaces(at, end);
+  const char *first = *at;
+  *value = 0;
+  while ( *at < end && isdigit((unsigned char) **at) ) {
+    unsigned digit = **at - '0';
+    if ( *value > ( UINT64_MAX - digit ) / 10 ) {
+      return false;
+    }
+    *value = *value * 10 + digit;
+    ( *at )++;
+  }
+  return *at > first;
+}
+
+/**
+ * Reads a tile position, as a column of letters then a row number from 1,
+ * after any spaces.
+ *
+ * @param board the board the position is on, for bounds checking
+ * @param at the position to read from, moved past the tile position
+ * @param end the end of the line
+ * @param x where to place the x position of the tile
+ * @param y where to place the y position of the tile
+ * @return true if there was a position on the board
+ */
+static bool read_position(const Board *board, const char **at,
+    const char *end, int *x, int *y) {
+  skip_spaces(at, end);
+  const char *letters = *at;
+  while ( *at < end && isalpha((unsigned char) **at) ) {
+    ( *at )++;
+  }
+  int column = *at > letters ? board_column_parse(letters, *at - letters) : -1;
+  uint64_t row;
+  if ( column < 0 || !read_number(at, end, &row) ) {
+    return false;
+  }
+  if ( column >= board -> width || row < 1 || row > (uint64_t) board -> height ) {
+    return false;
+  }
+  *x = column;
+  *y = row - 1;
+  return true;
+}
+
+/**
+ * Starts a new game, handing the last board back to the pool and taking one
+ * of the new size, so streams that go back and forth between a few sizes
+ * don't allocate per game.
+ *
+ * @param replay the replay to start a game in
+ * @param width the width of the new board
+ * @param height the height of the new board
+ * @param mines the number of mines on the new board
+ * @param seed the seed to place the mines from
+ * @param first_zero whether the mines wait for the first tile exposed
+ * @return true if the board could be made
+ */
+static bool replay_start(Replay *replay, int width, int height,
+    int64_t mines, uint64_t seed, bool first_zero) {
+  if ( replay -> playing && !replay -> over ) {
+    replay -> result -> unfinished++;
+  }
+  pool_give(&replay -> pool, replay -> board);
+  replay -> board = pool_take(&replay -> pool, width, height, mines, seed,
+      first_zero);
+  if ( !replay -> board ) {
+    replay -> playing = false;
+    return false;
+  }
+  replay -> result -> games++;
+  replay -> playing = true;
+  replay -> over = false;
+  return true;
+}
+
+/**
+ * Counts a move that was applied, checks whether it ended the game, and
+ * prints the board if it's time to.
+ *
+ * @param replay the replay the move was made in
+ * @param status what the board returned for the move
+ */
+static void replay_moved(Replay *replay, short status) {
+  Board *board = replay -> board;
+  ReplayResult *result = replay -> result;
+  result -> moves++;
+  if ( status == LOSE_MINE ) {
+    result -> losses++;
+    replay -> over = true;
+  } else if ( status != EXIT_SUCCESS ) {
+    result -> rejected++;
+  } else if ( board -> exposed == board_safe_tiles(board) ) {
+    result -> wins++;
+    replay -> over = true;
+  }
+  // Nobody is following the changes, so keep the list from filling up
+  board_changes_clear(board);
+
+  unsigned long every = replay -> config -> render_every;
+  if ( every > 0 && result -> moves % every == 0 ) {
+    printf("After move %llu:\n", result -> moves);
+    board_print(board);
+  }
+}
+
+/**
+ * Reads and plays one line of the stream.
+ *
+ * @param replay the replay to play the line in
+ * @param line the start of the line
+ * @param end the end of the line
+ * @return true if the line could be read
+ */
+static bool replay_line(Replay *replay, const char *line, const char *end) {
+  const ReplayConfig *config = replay -> config;
+  const char *at = line;
+  skip_spaces(&at, end);
+  if ( at_line_end(at, end) ) {
+    return true;
+  }
+  char command = toupper((unsigned char) *at++);
+
+  // New game
+  if ( command == 'G' ) {
+    uint64_t width, height, mines, seed;
+    if ( !read_number(&at, end, &width) || !read_number(&at, end, &height) ||
+        !read_number(&at, end, &mines) || !read_number(&at, end, &seed) ) {
+      return false;
+    }
+    skip_spaces(&at, end);
+    bool first_zero = at < end && toupper((unsigned char) *at) == 'Z';
+    if ( first_zero ) {
+      at++;
+    }
+    if ( !at_line_end(at, end) ) {
+      return false;
+    }
+    if ( width < 1 || width > BOARD_SIDE_MAX || height < 1 ||
+        height > BOARD_SIDE_MAX || mines > width * height ) {
+      return false;
+    }
+    return replay_start(replay, width, height, mines, seed, first_zero);
+  }
+  if ( command != 'S' && command != 'E' && command != 'F' ) {
+    return false;
+  }
+
+  // Moves before any game line are on the configured board
+  if ( !replay -> playing && !replay_start(replay, config -> width,
+        config -> height, config -> mines, config -> seed,
+        config -> first_zero) ) {
+    return false;
+  }
+  Board *board = replay -> board;
+  int x = 0;
+  int y = 0;
+  if ( command != 'S' && !read_position(board, &at, end, &x, &y) ) {
+    return false;
+  }
+  if ( !at_line_end(at, end) ) {
+    return false;
+  }
+  if ( replay -> over ) {
+    replay -> result -> rejected++;
+    return true;
+  }
+
+  if ( command == 'S' ) {
+    board_expose_safe(board);
+    replay_moved(replay, EXIT_SUCCESS);
+  } else if ( command == 'E' ) {
+    replay_moved(replay, board_expose_pick(board, x, y));
+  } else {
+    replay_moved(replay, board_flag(board, x, y));
+  }
+  return true;
+}
+
+/**
+ * Plays a stream of moves read from a file descriptor, without a player and
+ * without printing the board between moves. See replay.h for the format.
+ *
+ * @param fd the file descriptor to read from
+ * @param config settings for the replay
+ * @param result where to place the totals
+ * @return 0 if every line could be read, else 1
+ */
+int replay_run(int fd, const ReplayConfig *config, ReplayResult *result) {
+  memset(result, 0, sizeof(*result));
+  Reader *reader = malloc(sizeof(Reader));
+  if ( !reader ) {
+    LOG_ERROR("Not enough memory for a %d byte replay buffer.",
+        REPLAY_BUFFER);
+    return EXIT_FAILURE;
+  }
+  reader -> fd = fd;
+  reader -> start = 0;
+  reader -> end = 0;
+  reader -> eof = false;
+  reader -> skipping = false;
+  reader -> line = 0;
+  Replay replay = { .config = config, .result = result };
+  if ( pool_init(&replay.pool, REPLAY_POOL_BOARDS) != EXIT_SUCCESS ) {
+    free(reader);
+    return EXIT_FAILURE;
+  }
+
+  // Play every line
+  uint64_t start = batch_now_ns();
+  const char *line;
+  size_t length;
+  while ( reader_next(reader, &line, &length) ) {
+    if ( !replay_line(&replay, line, line + length) ) {
+      LOG_ERROR("Line %lu: can't read \"%.*s\"", reader -> line,
+          (int) ( length < 40 ? length : 40 ), line);
+      result -> errors++;
+    }
+  }
+  if ( replay.playing && !replay.over ) {
+    result -> unfinished++;
+  }
+  result -> seconds = ( batch_now_ns() - start ) / 1e9;
+
+  // Show how the last game was left
+  if ( replay.board ) {
+    board_print(replay.board);
+    board_free(replay.board);
+  }
+  pool_free(&replay.pool);
+  free(reader);
+  return result -> errors > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/**
+ * Prints the totals from a replay.
+ *
+ * @param result the totals to print
+ * @param out where to print them
+ */
+void replay_print(const ReplayResult *result, FILE *out) {
+  double seconds = result -> seconds > 0 ? result -> seconds : 1e-9;
+  fprintf(out, "Replayed %llu games, %llu moves\n", result -> games,
+      result -> moves);
+  fprintf(out, "  Time:       %.3f s, %.0f games/s, %.0f moves/s\n",
+      result -> seconds, result -> games / seconds, result -> moves / seconds);
+  fprintf(out, "  Won:        %llu\n", result -> wins);
+  fprintf(out, "  Lost:       %llu\n", result -> losses);
+  fprintf(out, "  Unfinished: %llu\n", result -> unfinished);
+  fprintf(out, "  Rejected:   %llu moves\n", result -> rejected);
+  if ( result -> errors > 0 ) {
+    fprintf(out, "  Bad lines:  %llu\n", result -> errors);
+  }
+}
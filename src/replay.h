@@ -0,0 +1,72 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "board.h"
+
+/**
+ * Settings for replaying a stream of moves. Moves before the stream's first
+ * game line are played on a board made from these.
+ */
+typedef struct ReplayConfig {
+  int width;
+  int height;
+  int64_t mines;
+  uint64_t seed;
+  // Whether the mines wait for the first tile exposed, so it's a blank
+  bool first_zero;
+  // Print the board after every this many moves, or 0 to only print the last
+  // game's board at the end
+  unsigned long render_every;
+} ReplayConfig;
+
+/**
+ * Totals from replaying a stream of moves.
+ */
+typedef struct ReplayResult {
+  unsigned long long games;
+  unsigned long long wins;
+  unsigned long long losses;
+  // Games the stream moved on from, or ended, before they were won or lost
+  unsigned long long unfinished;
+  // Moves applied to a board, and moves the board turned down, like exposing
+  // a flagged tile or anything after a game was lost
+  unsigned long long moves;
+  unsigned long long rejected;
+  // Lines that couldn't be read
+  unsigned long long errors;
+  // Wall clock time for the whole stream
+  double seconds;
+} ReplayResult;
+
+/**
+ * Plays a stream of moves read from a file descriptor, without a player and
+ * without printing the board between moves. The stream is read in large
+ * blocks and parsed in place, so nothing is allocated per move. One command
+ * per line, in any case, with # starting a comment:
+ *  - G WIDTH HEIGHT MINES SEED starts a new game, or G WIDTH HEIGHT MINES
+ *    SEED Z to place the mines after the first tile exposed, away from it
+ *  - S exposes a safe starting tile, like the game does when it begins
+ *  - E COLUMN ROW exposes a tile, or chords it if it's a satisfied number
+ *  - F COLUMN ROW flags or unflags a tile
+ * Columns are letters and rows start at 1, as the game shows them, and may be
+ * run together with the action, as in "EA1".
+ *
+ * @param fd the file descriptor to read from
+ * @param config settings for the replay
+ * @param result where to place the totals
+ * @return 0 if every line could be read, else 1
+ */
+int replay_run(int fd, const ReplayConfig *config, ReplayResult *result);
+
+/**
+ * Prints the totals from a replay.
+ *
+ * @param result the totals to print
+ * @param out where to print them
+ */
+void replay_print(const ReplayResult *result, FILE *out);
+
+#endif
@@ -0,0 +1,77 @@
+#include "rng.h"
+
+/**
+ * Advances a splitmix64 state. Used to spread a single seed across the full
+ * state of a larger generator.
+ *
+ * @param state the splitmix64 state to advance
+ * @return the next 64 random bits
+ */
+static uint64_t splitmix64(uint64_t *state) {
+  uint64_t z = ( *state += 0x9E3779B97F4A7C15ULL );
+  z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+  z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+  return z ^ ( z >> 31 );
+}
+
+/**
+ * Rotates the bits of a 64-bit value to the left.
+ */
+static inline uint64_t rotl(uint64_t x, int k) {
+  return ( x << k ) | ( x >> ( 64 - k ) );
+}
+
+/**
+ * Seeds a generator, and sets it to use xoshiro256**. The same seed always
+ * produces the same sequence.
+ *
+ * @param rng the generator to seed
+ * @param seed any 64-bit value
+ */
+void rng_seed(Rng *rng, uint64_t seed) {
+  rng -> next = rng_xoshiro256ss;
+  // splitmix64 never produces an all-zero state, which xoshiro can't leave
+  for ( int i = 0; i < 4; i++ ) {
+    rng -> state[i] = splitmix64(&seed);
+  }
+}
+
+/**
+ * The xoshiro256** generator. Fast, with a period of 2^256 - 1.
+ *
+ * @param rng the generator to advance
+ * @return the next 64 random bits
+ */
+uint64_t rng_xoshiro256ss(Rng *rng) {
+  uint64_t *s = rng -> state;
+  uint64_t result = rotl(s[1] * 5, 7) * 9;
+  uint64_t t = s[1] << 17;
+
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl(s[3], 45);
+
+  return result;
+}
+
+/**
+ * Picks a random number below a bound, without the bias of a plain modulo.
+ * Values below 2^64 mod bound are rejected, so every remainder is backed by
+ * the same number of 64-bit values. At most half of all values are ever
+ * rejected, and usually far fewer.
+ *
+ * @param rng the generator to advance
+ * @param bound one more than the largest number to return. Must not be 0.
+ * @return a number in [0, bound), with every value equally likely
+ */
+uint64_t rng_below(Rng *rng, uint64_t bound) {
+  uint64_t threshold = -bound % bound;
+  uint64_t r;
+  do {
+    r = rng_next(rng);
+  } while ( r < threshold );
+  return r % bound;
+}
@@ -0,0 +1,55 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+/**
+ * Seedable pseudo-random number generator. The generator function is stored
+ * alongside its state, so a different algorithm can be plugged in by setting
+ * next after seeding.
+ */
+typedef struct Rng {
+  // Produces the next 64 random bits, advancing the state
+  uint64_t (*next)(struct Rng *rng);
+  // Generator state
+  uint64_t state[4];
+} Rng;
+
+
+/**
+ * Seeds a generator, and sets it to use xoshiro256**. The same seed always
+ * produces the same sequence.
+ *
+ * @param rng the generator to seed
+ * @param seed any 64-bit value
+ */
+void rng_seed(Rng *rng, uint64_t seed);
+
+/**
+ * The xoshiro256** generator. Fast, with a period of 2^256 - 1.
+ *
+ * @param rng the generator to advance
+ * @return the next 64 random bits
+ */
+uint64_t rng_xoshiro256ss(Rng *rng);
+
+/**
+ * Produces the next 64 random bits from a generator.
+ *
+ * @param rng the generator to advance
+ * @return the next 64 random bits
+ */
+static inline uint64_t rng_next(Rng *rng) {
+  return rng -> next(rng);
+}
+
+/**
+ * Picks a random number below a bound, without the bias of a plain modulo.
+ *
+ * @param rng the generator to advance
+ * @param bound one more than the largest number to return. Must not be 0.
+ * @return a number in [0, bound), with every value equally likely
+ */
+uint64_t rng_below(Rng *rng, uint64_t bound);
+
+#endif
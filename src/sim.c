@@ -0,0 +1,495 @@
+#include "sim.h"
+#include "batch.h"
+#include "solver.h"
+#include "prob.h"
+#include "log.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+/** Most moves a game can take per tile before it's counted as stuck. */
+#define MOVES_PER_TILE 4
+/** Random picks a guess tries before searching the board in order. */
+#define GUESS_TRIES 64
+
+/** How a simulated game ended. */
+typedef enum outcome_enum {
+  OUTCOME_WIN,
+  OUTCOME_LOSS,
+  OUTCOME_STUCK
+} Outcome;
+
+/**
+ * A batch of games being played, shared by every worker's callbacks.
+ */
+typedef struct SimBatch {
+  const SimConfig *config;
+  SimResult *result;
+  // Time each game took, in nanoseconds, one slot per game
+  uint64_t *latencies;
+} SimBatch;
+
+/**
+ * One worker's policy state, and its totals.
+ */
+typedef struct SimWorker {
+  void *state;
+  unsigned long long wins;
+  unsigned long long losses;
+  unsigned long long stuck;
+} SimWorker;
+
+/**
+ * Picks a random tile that's neither exposed nor flagged. There's always one
+ * while the game is still going.
+ *
+ * @param board the board to pick a tile on
+ * @param move where to place the pick, as an expose
+ * @return true if a tile was found
+ */
+static bool guess_blank(Board *board, Move *move) {
+  move -> action = EXPOSE;
+  // Random picks find a blank fast unless nearly everything is exposed
+  for ( int i = 0; i < GUESS_TRIES; i++ ) {
+    int x = rng_below(&board -> rng, board -> width);
+    int y = rng_below(&board -> rng, board -> height);
+    if ( !( *board_tile(board, x, y) & ( TILE_EXPOSED | TILE_FLAGGED ) ) ) {
+      move -> x = x;
+      move -> y = y;
+      return true;
+    }
+  }
+  // Otherwise, take the first one in order
+  for ( int y = 0; y < board -> height; y++ ) {
+    for ( int x = 0; x < board -> width; x++ ) {
+      if ( !( *board_tile(board, x, y) & ( TILE_EXPOSED | TILE_FLAGGED ) ) ) {
+        move -> x = x;
+        move -> y = y;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/**
+ * Policy that exposes random tiles until the game ends.
+ *
+ * @param state unused
+ * @param board the board to pick a move on
+ * @param move where to place the move
+ * @return true if a move was picked
+ */
+static bool pick_random(void *state, Board *board, Move *move) {
+  (void) state;
+  return guess_blank(board, move);
+}
+
+/**
+ * Policy that plays the moves a single numbered tile proves safe, and guesses
+ * when there are none:
+ *  - If a number has as many blanks and flags around it as its count, every
+ *    blank around it is a mine, so flag one.
+ *  - If a number already has its count of flags, every blank around it is
+ *    safe, so chord it.
+ *
+ * @param state unused
+ * @param board the board to pick a move on
+ * @param move where to place the move
+ * @return true if a move was picked
+ */
+static bool pick_local(void *state, Board *board, Move *move) {
+  (void) state;
+  for ( int y = 0; y < board -> height; y++ ) {
+    for ( int x = 0; x < board -> width; x++ ) {
+      size_t index = board_index(board, x, y);
+      Tile tile = board -> cells[index];
+      // Only exposed numbers with blanks left around them tell us anything
+      if ( ( tile & ( TILE_EXPOSED | TILE_MINE ) ) != TILE_EXPOSED
+          || tile_count(tile) == 0 || board_tile_done(board, index) ) {
+        continue;
+      }
+      if ( board_tile_satisfied(board, index) ) {
+        move -> action = EXPOSE;
+        move -> x = x;
+        move -> y = y;
+        return true;
+      }
+      if ( board_nearby_flags(board, index) + board_nearby_blanks(board, index)
+          == tile_count(tile) ) {
+        for ( int i = 0; i < 8; i++ ) {
+          size_t near = index + board -> nearby[i];
+          if ( !( board -> cells[near] & ( TILE_EXPOSED | TILE_FLAGGED ) ) ) {
+            move -> action = FLAG;
+            move -> x = board_x(board, near);
+            move -> y = board_y(board, near);
+            return true;
+          }
+        }
+      }
+    }
+  }
+  return guess_blank(board, move);
+}
+
+/**
+ * Makes a solver for a worker playing the solver policy.
+ *
+ * @param board the worker's board
+ * @return the solver, as the worker's state, or NULL if there isn't enough
+ *  memory
+ */
+static void *create_solver(const Board *board) {
+  return newSolver((Board *) board);
+}
+
+/**
+ * Frees a worker's solver.
+ *
+ * @param state the solver
+ */
+static void destroy_solver(void *state) {
+  solver_free(state);
+}
+
+/**
+ * Starts the solver on a new game.
+ *
+ * @param state the solver
+ * @param board the board, with its opening tile exposed
+ */
+static void start_solver(void *state, Board *board) {
+  (void) board;
+  solver_reset(state);
+}
+
+/**
+ * Brings a solver up to date, and picks a move it has proven: exposing a safe
+ * tile, or flagging a mine.
+ *
+ * @param solver the solver to pick with
+ * @param board the board to pick a move on
+ * @param move where to place the move
+ * @return true if there was a proven move, false if a guess is needed
+ */
+static bool pick_proven(Solver *solver, Board *board, Move *move) {
+  solver_update(solver);
+  solver_solve(solver);
+
+  size_t index;
+  if ( solver_next_safe(solver, &index) ) {
+    move -> action = EXPOSE;
+  } else if ( solver_next_mine(solver, &index) ) {
+    move -> action = FLAG;
+  } else {
+    return false;
+  }
+  move -> x = board_x(board, index);
+  move -> y = board_y(board, index);
+  return true;
+}
+
+/**
+ * Policy that exposes every tile the solver proves safe, flags every tile it
+ * proves mined, and guesses when it can't prove anything.
+ *
+ * @param state the solver
+ * @param board the board to pick a move on
+ * @param move where to place the move
+ * @return true if a move was picked
+ */
+static bool pick_solver(void *state, Board *board, Move *move) {
+  return pick_proven(state, board, move) || guess_blank(board, move);
+}
+
+/**
+ * Makes a solver, and a probability engine on top of it, for a worker
+ * playing the odds policy. The worker's own thread counts every component,
+ * since the workers already use every core.
+ *
+ * @param board the worker's board
+ * @return the probability engine, as the worker's state, or NULL if there
+ *  isn't enough memory
+ */
+static void *create_odds(const Board *board) {
+  Solver *solver = newSolver((Board *) board);
+  Prob *prob = solver ? newProb((Board *) board, solver, 1) : NULL;
+  if ( !prob && solver ) {
+    solver_free(solver);
+  }
+  return prob;
+}
+
+/**
+ * Works out how much memory the odds policy takes for boards of a given size.
+ *
+ * @param width the horizontal count of tiles across each board
+ * @param height the vertical count of tiles across each board
+ * @return the number of bytes, or 0 if the size is out of range or too big to
+ *  address
+ */
+static size_t odds_bytes(int width, int height) {
+  size_t solver = solver_bytes(width, height);
+  size_t prob = prob_bytes(width, height);
+  if ( solver == 0 || prob == 0 || solver > SIZE_MAX - prob ) {
+    return 0;
+  }
+  return solver + prob;
+}
+
+/**
+ * Frees a worker's probability engine and its solver.
+ *
+ * @param state the probability engine
+ */
+static void destroy_odds(void *state) {
+  Prob *prob = state;
+  solver_free(prob -> solver);
+  prob_free(prob);
+}
+
+/**
+ * Starts the solver under a probability engine on a new game.
+ *
+ * @param state the probability engine
+ * @param board the board, with its opening tile exposed
+ */
+static void start_odds(void *state, Board *board) {
+  (void) board;
+  solver_reset(( (Prob *) state ) -> solver);
+}
+
+/**
+ * Policy that plays like the solver policy, but guesses the tile least likely
+ * to be a mine.
+ *
+ * @param state the probability engine
+ * @param board the board to pick a move on
+ * @param move where to place the move
+ * @return true if a move was picked
+ */
+static bool pick_odds(void *state, Board *board, Move *move) {
+  Prob *prob = state;
+  if ( pick_proven(prob -> solver, board, move) ) {
+    return true;
+  }
+  if ( prob_update(prob) != EXIT_SUCCESS || prob -> safest == 0 ) {
+    return guess_blank(board, move);
+  }
+  move -> action = EXPOSE;
+  move -> x = board_x(board, prob -> safest);
+  move -> y = board_y(board, prob -> safest);
+  return true;
+}
+
+/** Policies that can be picked by name. */
+static const Policy POLICIES[] = {
+  { "random", "expose random tiles", NULL, NULL, NULL, NULL, pick_random },
+  { "local", "play moves single numbers prove safe, else guess",
+    NULL, NULL, NULL, NULL, pick_local },
+  { "solver", "play moves the solver proves safe, else guess",
+    create_solver, solver_bytes, destroy_solver, start_solver, pick_solver },
+  { "odds", "like solver, but guess the tile least likely to be a mine",
+    create_odds, odds_bytes, destroy_odds, start_odds, pick_odds },
+};
+
+/** Number of built-in policies. */
+#define POLICY_COUNT ( sizeof(POLICIES) / sizeof(Policy) )
+
+/**
+ * Finds a built-in policy by name.
+ *
+ * @param name the name of the policy
+ * @return the policy, or NULL if there isn't one by that name
+ */
+const Policy *sim_find_policy(const char *name) {
+  for ( size_t i = 0; i < POLICY_COUNT; i++ ) {
+    if ( strcmp(name, POLICIES[i].name) == 0 ) {
+      return &POLICIES[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Lists the built-in policies, one per line, with their descriptions.
+ *
+ * @param out where to print the list
+ */
+void sim_list_policies(FILE *out) {
+  for ( size_t i = 0; i < POLICY_COUNT; i++ ) {
+    fprintf(out, "    %-8s %s\n", POLICIES[i].name, POLICIES[i].description);
+  }
+}
+
+/**
+ * Plays one game to the end on a freshly reset board.
+ *
+ * @param board the board to play on
+ * @param policy the policy picking moves
+ * @param state the policy's state for this worker
+ * @return how the game ended
+ */
+static Outcome play_game(Board *board, const Policy *policy, void *state) {
+  int64_t goal = board_safe_tiles(board);
+  // Open the same way an interactive game does
+  board_expose_safe(board);
+  if ( policy -> start ) {
+    policy -> start(state, board);
+  }
+
+  size_t move_limit = (size_t) MOVES_PER_TILE * board -> width * board -> height;
+  Move move;
+  for ( size_t moves = 0; moves < move_limit; moves++ ) {
+    if ( board -> exposed == goal ) {
+      return OUTCOME_WIN;
+    }
+    if ( !policy -> pick(state, board, &move) ) {
+      return OUTCOME_STUCK;
+    }
+    board_changes_clear(board);
+    if ( move.action == EXPOSE ) {
+      if ( board_expose_pick(board, move.x, move.y) == LOSE_MINE ) {
+        return OUTCOME_LOSS;
+      }
+    } else {
+      board_flag(board, move.x, move.y);
+    }
+  }
+  return board -> exposed == goal ? OUTCOME_WIN : OUTCOME_STUCK;
+}
+
+/**
+ * Makes a worker's policy state, for the board it plays on.
+ *
+ * @param context the SimBatch
+ * @param state the worker's SimWorker
+ * @param board the worker's board
+ * @return true if the policy has its state
+ */
+static bool start_worker(void *context, void *state, Board *board) {
+  const Policy *policy = ( (SimBatch *) context ) -> config -> policy;
+  SimWorker *worker = state;
+  if ( !policy -> create ) {
+    return true;
+  }
+  worker -> state = policy -> create(board);
+  return worker -> state != NULL;
+}
+
+/**
+ * Plays one game of the batch.
+ *
+ * @param context the SimBatch
+ * @param state the worker's SimWorker
+ * @param board the board, reset for the game's seed
+ * @param index the game's place in the batch
+ */
+static void run_game(void *context, void *state, Board *board,
+    unsigned long long index) {
+  (void) index;
+  const Policy *policy = ( (SimBatch *) context ) -> config -> policy;
+  SimWorker *worker = state;
+  switch ( play_game(board, policy, worker -> state) ) {
+    case OUTCOME_WIN: worker -> wins++; break;
+    case OUTCOME_LOSS: worker -> losses++; break;
+    case OUTCOME_STUCK: worker -> stuck++; break;
+  }
+}
+
+/**
+ * Adds up a worker's totals, packing the latencies of the games that were
+ * played together so only they are sorted, and frees its policy state.
+ *
+ * @param context the SimBatch
+ * @param state the worker's SimWorker
+ * @param first the worker's first game
+ * @param count how many games it played
+ */
+static void finish_worker(void *context, void *state,
+    unsigned long long first, unsigned long long count) {
+  SimBatch *batch = context;
+  SimResult *result = batch -> result;
+  SimWorker *worker = state;
+  memmove(batch -> latencies + result -> games, batch -> latencies + first,
+      sizeof(uint64_t) * count);
+  result -> games += count;
+  result -> wins += worker -> wins;
+  result -> losses += worker -> losses;
+  result -> stuck += worker -> stuck;
+  if ( batch -> config -> policy -> destroy ) {
+    batch -> config -> policy -> destroy(worker -> state);
+  }
+}
+
+/**
+ * Plays a batch of games headlessly, spread across worker threads. Each
+ * worker takes one board from the pool and resets it for each of its games,
+ * so no memory is allocated per game.
+ *
+ * @param config the games to play
+ * @param result where to place the totals
+ * @return 0 if successful, else 1 if the workers couldn't be started or
+ *  couldn't get or set up boards, in which case only the games played are
+ *  counted
+ */
+int sim_run(const SimConfig *config, SimResult *result) {
+  memset(result, 0, sizeof(SimResult));
+  uint64_t *latencies = malloc(sizeof(uint64_t) * ( config -> games + 1 ));
+  if ( !latencies ) {
+    LOG_ERROR("Not enough memory to simulate %llu games.", config -> games);
+    return EXIT_FAILURE;
+  }
+
+  LOG_DEBUG("Simulating %llu games...", config -> games);
+  SimBatch batch = { config, result, latencies };
+  BatchConfig games = { config -> width, config -> height, config -> mines,
+    config -> seed, config -> first_zero, config -> games, config -> threads,
+    config -> pool, latencies, &batch, sizeof(SimWorker), start_worker,
+    run_game, finish_worker };
+  BatchResult run;
+  int status = batch_run(&games, &run);
+  result -> threads = run.threads;
+  result -> seconds = run.seconds;
+  if ( result -> games > 0 ) {
+    batch_sort_latencies(latencies, result -> games);
+    result -> p50_us = batch_percentile(latencies, result -> games, 50)
+      / 1000.0;
+    result -> p90_us = batch_percentile(latencies, result -> games, 90)
+      / 1000.0;
+    result -> p99_us = batch_percentile(latencies, result -> games, 99)
+      / 1000.0;
+    result -> max_us = latencies[result -> games - 1] / 1000.0;
+  }
+
+  free(latencies);
+  return status;
+}
+
+/**
+ * Prints a report of a batch of simulated games.
+ *
+ * @param config the games that were played
+ * @param result the totals from playing them
+ * @param out where to print the report
+ */
+void sim_print(const SimConfig *config, const SimResult *result, FILE *out) {
+  double games = result -> games > 0 ? result -> games : 1;
+  fprintf(out, "Simulated %llu games: %dx%d with %lld mines, seeds %llu-%llu, "
+      "policy %s, %d threads\n", result -> games, config -> width,
+      config -> height, (long long) config -> mines,
+      (unsigned long long) config -> seed,
+      (unsigned long long) ( config -> seed + config -> games - 1 ),
+      config -> policy -> name, result -> threads);
+  fprintf(out, "  Time:    %.3f s, %.0f games/s\n", result -> seconds,
+      result -> seconds > 0 ? result -> games / result -> seconds : 0);
+  fprintf(out, "  Won:     %llu (%.2f%%)\n", result -> wins,
+      100 * result -> wins / games);
+  fprintf(out, "  Lost:    %llu (%.2f%%)\n", result -> losses,
+      100 * result -> losses / games);
+  fprintf(out, "  Stuck:   %llu (%.2f%%)\n", result -> stuck,
+      100 * result -> stuck / games);
+  fprintf(out, "  Latency: p50 %.1f us, p90 %.1f us, p99 %.1f us, max %.1f us\n",
+      result -> p50_us, result -> p90_us, result -> p99_us, result -> max_us);
+}
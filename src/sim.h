@@ -0,0 +1,116 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "board.h"
+#include "input.h"
+#include "pool.h"
+
+/**
+ * A strategy for playing games without a player. Each simulation worker gets
+ * its own state from create, which is kept across every game that worker
+ * plays, so policies can reuse their memory instead of allocating per game.
+ */
+typedef struct Policy {
+  // Name used to pick the policy on the command line
+  const char *name;
+  // One-line description for usage messages
+  const char *description;
+  // Makes the state for one worker, for boards like this one, or returns
+  // NULL if there isn't enough memory. May be NULL if the policy keeps no
+  // state.
+  void *(*create)(const Board *board);
+  // Works out how much memory create takes for boards of a given size, or 0
+  // if they're too big. May be NULL if create is.
+  size_t (*bytes)(int width, int height);
+  // Frees a worker's state. May be NULL if create is.
+  void (*destroy)(void *state);
+  // Gets ready for a new game, after the opening tile is exposed. May be NULL.
+  void (*start)(void *state, Board *board);
+  // Picks the next move. Tiles changed by the last move are on the board's
+  // change list, which is cleared after each pick. Draws any randomness from
+  // board -> rng, so games replay exactly from their seed. Returns false to
+  // give up on the game.
+  bool (*pick)(void *state, Board *board, Move *move);
+} Policy;
+
+/**
+ * Settings for a batch of simulated games. Game i is played on a board seeded
+ * with seed + i, so results don't depend on how many threads play them.
+ */
+typedef struct SimConfig {
+  int width;
+  int height;
+  int64_t mines;
+  uint64_t seed;
+  // Whether the mines wait for the first tile exposed, so it's a blank
+  bool first_zero;
+  unsigned long long games;
+  // Worker threads to play on, or 0 for one per core
+  int threads;
+  const Policy *policy;
+  // Pool to take boards from and give them back to, so batches run one
+  // after another share their boards, or NULL for one just for this batch
+  BoardPool *pool;
+} SimConfig;
+
+/**
+ * Totals from a batch of simulated games.
+ */
+typedef struct SimResult {
+  unsigned long long games;
+  unsigned long long wins;
+  unsigned long long losses;
+  // Games the policy gave up on, or that ran past the move limit
+  unsigned long long stuck;
+  int threads;
+  // Wall clock time for the whole batch
+  double seconds;
+  // Time per game, in microseconds, at the 50th, 90th, and 99th percentiles
+  // and the slowest game
+  double p50_us;
+  double p90_us;
+  double p99_us;
+  double max_us;
+} SimResult;
+
+/**
+ * Finds a built-in policy by name.
+ *
+ * @param name the name of the policy
+ * @return the policy, or NULL if there isn't one by that name
+ */
+const Policy *sim_find_policy(const char *name);
+
+/**
+ * Lists the built-in policies, one per line, with their descriptions.
+ *
+ * @param out where to print the list
+ */
+void sim_list_policies(FILE *out);
+
+/**
+ * Plays a batch of games headlessly, spread across worker threads. Each
+ * worker takes one board from the pool and resets it for each of its games,
+ * so no memory is allocated per game.
+ *
+ * @param config the games to play
+ * @param result where to place the totals
+ * @return 0 if successful, else 1 if the workers couldn't be started or
+ *  couldn't get or set up boards, in which case only the games played are
+ *  counted
+ */
+int sim_run(const SimConfig *config, SimResult *result);
+
+/**
+ * Prints a report of a batch of simulated games.
+ *
+ * @param config the games that were played
+ * @param result the totals from playing them
+ * @param out where to print the report
+ */
+void sim_print(const SimConfig *config, const SimResult *result, FILE *out);
+
+#endif
@@ -0,0 +1,404 @@
+#define _XOPEN_SOURCE 700
+
+#include "snapshot.h"
+#include "log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/** Bytes every snapshot starts with. */
+static const char MAGIC[8] = { 'M', 'I', 'N', 'E', 'S', 'N', 'A', 'P' };
+/** Where the checksum sits in the header. */
+#define CHECKSUM_AT 88
+/** Starting value and multiplier for the checksum. */
+#define CHECKSUM_BASIS 0xcbf29ce484222325ull
+#define CHECKSUM_PRIME 0x100000001b3ull
+
+/**
+ * The header of a snapshot, decoded.
+ */
+typedef struct Header {
+  uint32_t version;
+  uint32_t size;
+  uint32_t width;
+  uint32_t height;
+  uint32_t cur_x;
+  uint32_t cur_y;
+  uint64_t mineCount;
+  uint64_t exposed;
+  uint64_t seed;
+  uint64_t rng_state[4];
+  uint64_t checksum;
+} Header;
+
+/** Stores a 32-bit number, little-endian. */
+static void store32(unsigned char *at, uint32_t value) {
+  for ( int i = 0; i < 4; i++ ) {
+    at[i] = value >> ( 8 * i );
+  }
+}
+
+/** Stores a 64-bit number, little-endian. */
+static void store64(unsigned char *at, uint64_t value) {
+  for ( int i = 0; i < 8; i++ ) {
+    at[i] = value >> ( 8 * i );
+  }
+}
+
+/** @return the little-endian 32-bit number at at */
+static uint32_t load32(const unsigned char *at) {
+  return (uint32_t) at[0] | (uint32_t) at[1] << 8 | (uint32_t) at[2] << 16 |
+    (uint32_t) at[3] << 24;
+}
+
+/** @return the little-endian 64-bit number at at */
+static uint64_t load64(const unsigned char *at) {
+  return (uint64_t) load32(at) | (uint64_t) load32(at + 4) << 32;
+}
+
+/**
+ * Adds bytes to a checksum. Takes them eight at a time, so it runs at close
+ * to memory speed; any single changed word always changes the result.
+ *
+ * @param hash the checksum so far
+ * @param bytes the bytes to add
+ * @param length the number of bytes, a multiple of 8 except at the very end
+ * @return the new checksum
+ */
+static uint64_t checksum_add(uint64_t hash, const unsigned char *bytes,
+    size_t length) {
+  size_t i = 0;
+  for ( ; i + 8 <= length; i += 8 ) {
+    hash = ( hash ^ load64(bytes + i) ) * CHECKSUM_PRIME;
+    hash ^= hash >> 29;
+  }
+  for ( ; i < length; i++ ) {
+    hash = ( hash ^ bytes[i] ) * CHECKSUM_PRIME;
+  }
+  return hash;
+}
+
+/**
+ * Encodes a header, with its checksum field zeroed.
+ *
+ * @param header the header to encode
+ * @param bytes where to place the encoded header
+ */
+static void header_encode(const Header *header,
+    unsigned char bytes[SNAPSHOT_HEADER]) {
+  memset(bytes, 0, SNAPSHOT_HEADER);
+  memcpy(bytes, MAGIC, sizeof(MAGIC));
+  store32(bytes + 8, header -> version);
+  store32(bytes + 12, header -> size);
+  store32(bytes + 16, header -> width);
+  store32(bytes + 20, header -> height);
+  store32(bytes + 24, header -> cur_x);
+  store32(bytes + 28, header -> cur_y);
+  store64(bytes + 32, header -> mineCount);
+  store64(bytes + 40, header -> exposed);
+  store64(bytes + 48, header -> seed);
+  for ( int i = 0; i < 4; i++ ) {
+    store64(bytes + 56 + 8 * i, header -> rng_state[i]);
+  }
+}
+
+/**
+ * Decodes and checks a header. The checksum can't be checked until the tiles
+ * are read, so it's only decoded.
+ *
+ * @param bytes the encoded header
+ * @param header where to place the decoded header
+ * @return 0 if it's a header this version can read, else 1
+ */
+static int header_decode(const unsigned char bytes[SNAPSHOT_HEADER],
+    Header *header) {
+  if ( memcmp(bytes, MAGIC, sizeof(MAGIC)) != 0 ) {
+    LOG_ERROR("Not a saved board.");
+    return EXIT_FAILURE;
+  }
+  header -> version = load32(bytes + 8);
+  header -> size = load32(bytes + 12);
+  header -> width = load32(bytes + 16);
+  header -> height = load32(bytes + 20);
+  header -> cur_x = load32(bytes + 24);
+  header -> cur_y = load32(bytes + 28);
+  header -> mineCount = load64(bytes + 32);
+  header -> exposed = load64(bytes + 40);
+  header -> seed = load64(bytes + 48);
+  for ( int i = 0; i < 4; i++ ) {
+    header -> rng_state[i] = load64(bytes + 56 + 8 * i);
+  }
+  header -> checksum = load64(bytes + CHECKSUM_AT);
+
+  if ( header -> version != SNAPSHOT_VERSION ||
+      header -> size != SNAPSHOT_HEADER ) {
+    LOG_ERROR("Saved board is version %u, only version %d can be read.",
+        header -> version, SNAPSHOT_VERSION);
+    return EXIT_FAILURE;
+  }
+  uint64_t tiles = (uint64_t) header -> width * header -> height;
+  if ( header -> width < 1 || header -> width > BOARD_SIDE_MAX ||
+      header -> height < 1 || header -> height > BOARD_SIDE_MAX ||
+      header -> mineCount > tiles || header -> exposed > tiles ||
+      header -> cur_x >= header -> width ||
+      header -> cur_y >= header -> height ) {
+    LOG_ERROR("Saved board's header is corrupt.");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+/** @return the number of tile bytes after a header, border ring included */
+static size_t header_tiles(const Header *header) {
+  return (size_t) ( header -> width + 2 ) * ( (size_t) header -> height + 2 );
+}
+
+/**
+ * Checks a header and tiles against the header's checksum.
+ *
+ * @param bytes the encoded header
+ * @param header the decoded header
+ * @param cells the tiles
+ * @return true if they match
+ */
+static bool checksum_matches(const unsigned char bytes[SNAPSHOT_HEADER],
+    const Header *header, const Tile *cells) {
+  unsigned char zeroed[SNAPSHOT_HEADER];
+  memcpy(zeroed, bytes, SNAPSHOT_HEADER);
+  memset(zeroed + CHECKSUM_AT, 0, 8);
+  uint64_t hash = checksum_add(CHECKSUM_BASIS, zeroed, SNAPSHOT_HEADER);
+  hash = checksum_add(hash, cells, header_tiles(header));
+  if ( hash != header -> checksum ) {
+    LOG_ERROR("Saved board is corrupt: checksum doesn't match.");
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Checks that loaded tiles keep the board's invariants: every tile in the
+ * border ring is an exposed border tile with no mine or flag, no tile in play
+ * is marked as border, every tile in play counts the mines around it, and
+ * the mines add up to the header's count. The flood fill and the counts
+ * around each tile rely on the ring, and the game on the counts, so a file
+ * that breaks them is rejected even if its checksum matches.
+ *
+ * @param board the board the tiles were read into
+ * @param mineCount the number of mines the header says there are
+ * @return true if the tiles are sound
+ */
+static bool cells_valid(const Board *board, uint64_t mineCount) {
+  uint64_t mines = 0;
+  for ( int y = -1; y <= board -> height; y++ ) {
+    const Tile *row = board -> cells + (size_t) ( y + 1 ) * board -> stride;
+    bool ring_row = y < 0 || y == board -> height;
+    for ( int x = 0; x < board -> stride; x++ ) {
+      Tile tile = row[x];
+      bool ring = ring_row || x == 0 || x == board -> stride - 1;
+      if ( ring ? ( tile & ( TILE_BORDER | TILE_EXPOSED | TILE_MINE
+          | TILE_FLAGGED ) ) != ( TILE_BORDER | TILE_EXPOSED )
+          : ( tile & TILE_BORDER ) != 0 ) {
+        LOG_ERROR("Saved board is corrupt: tile (%d, %d) breaks the border.",
+            x - 1, y);
+        return false;
+      }
+      mines += ( tile & TILE_MINE ) != 0;
+    }
+  }
+  if ( mines != mineCount ) {
+    LOG_ERROR("Saved board is corrupt: it has %llu mines, not %llu.",
+        (unsigned long long) mines, (unsigned long long) mineCount);
+    return false;
+  }
+
+  // With the ring sound, every tile in play has eight neighbors to count
+  for ( int y = 0; y < board -> height; y++ ) {
+    for ( int x = 0; x < board -> width; x++ ) {
+      size_t index = board_index(board, x, y);
+      short around = 0;
+      for ( int i = 0; i < 8; i++ ) {
+        around += tile_is_mine(board -> cells[index + board -> nearby[i]]);
+      }
+      short count = tile_count(board -> cells[index]);
+      if ( count != around ) {
+        LOG_ERROR("Saved board is corrupt: tile (%d, %d) counts %d mines"
+            " around it, not %d.", x, y, count, around);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Saves a board to a file, replacing it all at once so a crash never leaves
+ * half a snapshot behind.
+ *
+ * @param board the board to save
+ * @param path the path of the file to save to
+ * @return 0 if successful, else 1
+ */
+int board_save(const Board *board, const char *path) {
+  // Build the header and checksum
+  Header header = { SNAPSHOT_VERSION, SNAPSHOT_HEADER, board -> width,
+    board -> height, board -> cur_x, board -> cur_y, board -> mineCount,
+    board -> exposed, board -> seed, { 0 }, 0 };
+  memcpy(header.rng_state, board -> rng.state, sizeof(header.rng_state));
+  unsigned char bytes[SNAPSHOT_HEADER];
+  header_encode(&header, bytes);
+  size_t tiles = header_tiles(&header);
+  uint64_t hash = checksum_add(CHECKSUM_BASIS, bytes, SNAPSHOT_HEADER);
+  hash = checksum_add(hash, board -> cells, tiles);
+  store64(bytes + CHECKSUM_AT, hash);
+
+  // Write it all to a temporary file, then move it over the old one
+  size_t path_len = strlen(path);
+  char temp[path_len + 5];
+  snprintf(temp, sizeof(temp), "%s.tmp", path);
+  FILE *file = fopen(temp, "wb");
+  if ( !file ) {
+    LOG_ERROR("Couldn't open %s to save the board.", temp);
+    return EXIT_FAILURE;
+  }
+  bool written = fwrite(bytes, 1, SNAPSHOT_HEADER, file) == SNAPSHOT_HEADER &&
+    fwrite(board -> cells, 1, tiles, file) == tiles;
+  if ( fclose(file) != 0 || !written || rename(temp, path) != 0 ) {
+    LOG_ERROR("Couldn't save the board to %s.", path);
+    remove(temp);
+    return EXIT_FAILURE;
+  }
+  LOG_DEBUG("Saved %zu bytes to %s.", SNAPSHOT_HEADER + tiles, path);
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Loads a board saved with board_save, ready to play on from where it was
+ * saved. Checks the whole file against its checksum first, then that the
+ * border ring is intact and the mines match the saved count.
+ *
+ * @param path the path of the file to load
+ * @return the loaded board, or NULL if the file couldn't be read or is
+ *  corrupt
+ */
+Board *board_load(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if ( !file ) {
+    LOG_ERROR("Couldn't open saved board %s.", path);
+    return NULL;
+  }
+  unsigned char bytes[SNAPSHOT_HEADER];
+  Header header;
+  if ( fread(bytes, 1, SNAPSHOT_HEADER, file) != SNAPSHOT_HEADER ||
+      header_decode(bytes, &header) != EXIT_SUCCESS ) {
+    fclose(file);
+    return NULL;
+  }
+
+  // Read the tiles straight into a fresh board of the same size
+  Board *board = newBoardSeeded(header.width, header.height, 0, header.seed);
+  if ( !board ) {
+    fclose(file);
+    return NULL;
+  }
+  size_t tiles = header_tiles(&header);
+  size_t got = fread(board -> cells, 1, tiles, file);
+  bool extra = fgetc(file) != EOF;
+  fclose(file);
+  if ( got != tiles || extra ) {
+    LOG_ERROR("Saved board %s is the wrong size.", path);
+    board_free(board);
+    return NULL;
+  }
+  if ( !checksum_matches(bytes, &header, board -> cells)
+      || !cells_valid(board, header.mineCount) ) {
+    board_free(board);
+    return NULL;
+  }
+
+  // Restore the rest of the game
+  board -> mineCount = header.mineCount;
+  board -> cur_x = header.cur_x;
+  board -> cur_y = header.cur_y;
+  board_recount(board);
+  memcpy(board -> rng.state, header.rng_state, sizeof(header.rng_state));
+  if ( (uint64_t) board -> exposed != header.exposed ) {
+    LOG_ERROR("Saved board %s is corrupt: exposed count doesn't match.", path);
+    board_free(board);
+    return NULL;
+  }
+  LOG_DEBUG("Loaded a %dx%d board from %s.", board -> width, board -> height,
+      path);
+  return board;
+}
+
+/**
+ * Maps a saved board into memory, read-only.
+ *
+ * @param path the path of the file to map
+ * @param snapshot where to place the mapped snapshot
+ * @param verify whether to check the tiles against the checksum, which reads
+ *  the whole file. The header is always checked.
+ * @return 0 if successful, else 1 if the file couldn't be mapped or is corrupt
+ */
+int snapshot_map(const char *path, Snapshot *snapshot, bool verify) {
+  memset(snapshot, 0, sizeof(*snapshot));
+  int fd = open(path, O_RDONLY);
+  if ( fd < 0 ) {
+    LOG_ERROR("Couldn't open saved board %s.", path);
+    return EXIT_FAILURE;
+  }
+  struct stat info;
+  if ( fstat(fd, &info) != 0 || info.st_size < SNAPSHOT_HEADER ) {
+    LOG_ERROR("Saved board %s is too short.", path);
+    close(fd);
+    return EXIT_FAILURE;
+  }
+  size_t size = info.st_size;
+  void *map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if ( map == MAP_FAILED ) {
+    LOG_ERROR("Couldn't map saved board %s.", path);
+    return EXIT_FAILURE;
+  }
+
+  // Check the header, and that the tiles fill the rest of the file
+  const unsigned char *bytes = map;
+  Header header;
+  if ( header_decode(bytes, &header) != EXIT_SUCCESS ||
+      SNAPSHOT_HEADER + header_tiles(&header) != size ||
+      ( verify && !checksum_matches(bytes, &header, bytes + SNAPSHOT_HEADER) ) ) {
+    munmap(map, size);
+    return EXIT_FAILURE;
+  }
+
+  snapshot -> width = header.width;
+  snapshot -> height = header.height;
+  snapshot -> stride = header.width + 2;
+  snapshot -> cur_x = header.cur_x;
+  snapshot -> cur_y = header.cur_y;
+  snapshot -> mineCount = header.mineCount;
+  snapshot -> exposed = header.exposed;
+  snapshot -> seed = header.seed;
+  memcpy(snapshot -> rng_state, header.rng_state, sizeof(header.rng_state));
+  snapshot -> cells = bytes + SNAPSHOT_HEADER;
+  snapshot -> map = map;
+  snapshot -> map_size = size;
+  return EXIT_SUCCESS;
+}
+
+/**
+ * Unmaps a snapshot mapped with snapshot_map.
+ *
+ * @param snapshot the snapshot to unmap
+ */
+void snapshot_unmap(Snapshot *snapshot) {
+  if ( snapshot -> map ) {
+    munmap(snapshot -> map, snapshot -> map_size);
+  }
+  memset(snapshot, 0, sizeof(*snapshot));
+}
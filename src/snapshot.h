@@ -0,0 +1,98 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "board.h"
+
+/** Version of the snapshot format written by board_save. */
+#define SNAPSHOT_VERSION 1
+/** Size of a snapshot's header, in bytes. The tiles start right after it. */
+#define SNAPSHOT_HEADER 96
+
+/**
+ * A saved board, mapped into memory read-only straight from its file. Nothing
+ * is copied or parsed past the header, so even huge boards open instantly.
+ *
+ * A snapshot file is a header, with every number stored little-endian:
+ *  - 0:  the magic bytes "MINESNAP"
+ *  - 8:  format version, 32 bits
+ *  - 12: header size, 32 bits
+ *  - 16: width, height, cursor x, and cursor y, 32 bits each
+ *  - 32: mine count, exposed count, and seed, 64 bits each
+ *  - 56: the board's random generator state, four 64-bit words
+ *  - 88: checksum of the header, with this field zeroed, and the tiles
+ * followed by one byte per tile, laid out like board -> cells: row by row,
+ * inside a one-tile ring of border tiles.
+ */
+typedef struct Snapshot {
+  int width;
+  int height;
+  int stride;
+  int cur_x;
+  int cur_y;
+  uint64_t mineCount;
+  uint64_t exposed;
+  uint64_t seed;
+  uint64_t rng_state[4];
+  // Tiles, indexed like board -> cells
+  const Tile *cells;
+  // The whole mapped file
+  void *map;
+  size_t map_size;
+} Snapshot;
+
+
+/**
+ * Gets the tile at a position in a snapshot. The position must be in bounds.
+ *
+ * @param snapshot the snapshot to read from
+ * @param x the x position of the tile
+ * @param y the y position of the tile
+ * @return the tile at (x, y)
+ */
+static inline Tile snapshot_tile(const Snapshot *snapshot, int x, int y) {
+  return snapshot -> cells[(size_t) ( y + 1 ) * snapshot -> stride + x + 1];
+}
+
+/**
+ * Saves a board to a file, replacing it all at once so a crash never leaves
+ * half a snapshot behind.
+ *
+ * @param board the board to save
+ * @param path the path of the file to save to
+ * @return 0 if successful, else 1
+ */
+int board_save(const Board *board, const char *path);
+
+/**
+ * Loads a board saved with board_save, ready to play on from where it was
+ * saved. Checks the whole file against its checksum first, then that the
+ * border ring is intact and the mines match the saved count.
+ *
+ * @param path the path of the file to load
+ * @return the loaded board, or NULL if the file couldn't be read or is
+ *  corrupt
+ */
+Board *board_load(const char *path);
+
+/**
+ * Maps a saved board into memory, read-only.
+ *
+ * @param path the path of the file to map
+ * @param snapshot where to place the mapped snapshot
+ * @param verify whether to check the tiles against the checksum, which reads
+ *  the whole file. The header is always checked.
+ * @return 0 if successful, else 1 if the file couldn't be mapped or is corrupt
+ */
+int snapshot_map(const char *path, Snapshot *snapshot, bool verify);
+
+/**
+ * Unmaps a snapshot mapped with snapshot_map.
+ *
+ * @param snapshot the snapshot to unmap
+ */
+void snapshot_unmap(Snapshot *snapshot);
+
+#endif
@@ -0,0 +1,517 @@
+#include "solver.h"
+#include "log.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/** Entries an IndexList starts with once something is added to it. */
+#define INDEX_LIST_MIN 64
+
+/**
+ * Adds an index to the end of a list, growing it if it's full.
+ *
+ * @param list the list to add to
+ * @param index the index to add
+ */
+static void index_push(IndexList *list, size_t index) {
+  if ( list -> length == list -> capacity ) {
+    size_t capacity = list -> capacity ? list -> capacity * 2 : INDEX_LIST_MIN;
+    size_t *items = realloc(list -> items, sizeof(size_t) * capacity);
+    if ( !items ) {
+      LOG_ERROR("Out of memory growing a solver list to %zu entries.", capacity);
+      exit(EXIT_FAILURE);
+    }
+    list -> items = items;
+    list -> capacity = capacity;
+  }
+  list -> items[list -> length++] = index;
+}
+
+/**
+ * Counts the hidden tiles around a tile, flagged or not.
+ *
+ * @param board the board the tile is on
+ * @param index the index of the tile
+ * @return the number of nearby tiles that aren't exposed, 0-8
+ */
+static inline short nearby_hidden(const Board *board, size_t index) {
+  return board_nearby_blanks(board, index) + board_nearby_flags(board, index);
+}
+
+/**
+ * Puts a frontier tile on the work list to be checked, unless it's already
+ * waiting there.
+ *
+ * @param solver the solver to queue work on
+ * @param index the index of the tile to check
+ */
+static inline void queue_check(Solver *solver, size_t index) {
+  unsigned char marks = solver -> marks[index];
+  if ( ( marks & ( SOLVE_FRONTIER | SOLVE_QUEUED ) ) == SOLVE_FRONTIER ) {
+    solver -> marks[index] = marks | SOLVE_QUEUED;
+    index_push(&solver -> work, index);
+  }
+}
+
+/**
+ * Adds a tile to the frontier, if it's an exposed number with hidden tiles
+ * around it, and queues it to be checked.
+ *
+ * @param solver the solver to add to
+ * @param index the index of the tile
+ */
+static void join_frontier(Solver *solver, size_t index) {
+  Tile tile = solver -> board -> cells[index];
+  if ( ( tile & ( TILE_EXPOSED | TILE_MINE | TILE_BORDER ) ) != TILE_EXPOSED
+      || tile_count(tile) == 0
+      || ( solver -> marks[index] & SOLVE_FRONTIER )
+      || nearby_hidden(solver -> board, index) == 0 ) {
+    return;
+  }
+  solver -> marks[index] |= SOLVE_FRONTIER;
+  index_push(&solver -> frontier, index);
+  queue_check(solver, index);
+}
+
+/**
+ * Drops any tiles that have left the frontier from its list.
+ *
+ * @param solver the solver to sweep
+ */
+static void sweep_frontier(Solver *solver) {
+  IndexList *frontier = &solver -> frontier;
+  size_t kept = 0;
+  for ( size_t i = 0; i < frontier -> length; i++ ) {
+    if ( solver -> marks[frontier -> items[i]] & SOLVE_FRONTIER ) {
+      frontier -> items[kept++] = frontier -> items[i];
+    }
+  }
+  frontier -> length = kept;
+  solver -> frontier_stale = 0;
+}
+
+/**
+ * Takes a tile off the frontier, once it has no hidden tiles left around it.
+ * Tiles never come back, since tiles never get hidden again.
+ *
+ * @param solver the solver to take from
+ * @param index the index of the tile
+ */
+static void leave_frontier(Solver *solver, size_t index) {
+  solver -> marks[index] &= ~( SOLVE_FRONTIER | SOLVE_QUEUED );
+  // Sweep once the list is mostly tiles that have left, so it stays
+  // proportional to the frontier
+  if ( ++solver -> frontier_stale > solver -> frontier.length / 2 ) {
+    sweep_frontier(solver);
+  }
+}
+
+/**
+ * Builds the frontier from scratch by reading the whole board. Anything
+ * already proven stays proven.
+ *
+ * @param solver the solver to rebuild
+ */
+static void read_board(Solver *solver) {
+  Board *board = solver -> board;
+  for ( size_t i = 0; i < solver -> frontier.length; i++ ) {
+    solver -> marks[solver -> frontier.items[i]] &=
+      ~( SOLVE_FRONTIER | SOLVE_QUEUED );
+  }
+  solver -> frontier.length = 0;
+  solver -> frontier_stale = 0;
+  solver -> work.length = 0;
+  for ( int y = 0; y < board -> height; y++ ) {
+    for ( int x = 0; x < board -> width; x++ ) {
+      join_frontier(solver, board_index(board, x, y));
+    }
+  }
+}
+
+/**
+ * Records that a tile is proven safe or mined, and queues the numbers around
+ * it to be checked again.
+ *
+ * @param solver the solver that proved it
+ * @param index the index of the tile
+ * @param mark SOLVE_SAFE or SOLVE_MINE
+ * @return 1 if this is news, else 0 if it was already proven
+ */
+static size_t prove(Solver *solver, size_t index, unsigned char mark) {
+  if ( solver -> marks[index] & ( SOLVE_SAFE | SOLVE_MINE ) ) {
+    return 0;
+  }
+  LOG_TRACE("Proved (%d, %d) %s.", board_x(solver -> board, index),
+      board_y(solver -> board, index), mark == SOLVE_MINE ? "mined" : "safe");
+  solver -> marks[index] |= mark;
+  index_push(mark == SOLVE_MINE ? &solver -> mines : &solver -> safe, index);
+  for ( int i = 0; i < 8; i++ ) {
+    queue_check(solver, index + solver -> board -> nearby[i]);
+  }
+  return 1;
+}
+
+/**
+ * Finds the hidden tiles around a number that aren't proven yet, and how many
+ * of them must be mines.
+ *
+ * @param solver the solver to check with
+ * @param index the index of the number
+ * @param unknown where to place the indices of the unproven tiles
+ * @param mines where to place how many of them are mines
+ * @return the number of unproven tiles, 0-8
+ */
+int solver_unknown_around(const Solver *solver, size_t index, size_t unknown[8],
+    int *mines) {
+  const Board *board = solver -> board;
+  int length = 0;
+  *mines = tile_count(board -> cells[index]);
+  for ( int i = 0; i < 8; i++ ) {
+    size_t near = index + board -> nearby[i];
+    if ( tile_is_exposed(board -> cells[near]) ) {
+      continue;
+    }
+    unsigned char marks = solver -> marks[near];
+    if ( marks & SOLVE_MINE ) {
+      (*mines)--;
+    } else if ( !( marks & SOLVE_SAFE ) ) {
+      unknown[length++] = near;
+    }
+  }
+  return length;
+}
+
+/**
+ * Compares two numbers whose unproven tiles are a subset and superset. The
+ * tiles only around the superset hold the rest of its mines.
+ *
+ * @param solver the solver to record proofs on
+ * @param inner the unproven tiles around the first number
+ * @param inner_length how many there are
+ * @param inner_mines how many of them are mines
+ * @param outer the unproven tiles around the second number
+ * @param outer_length how many there are
+ * @param outer_mines how many of them are mines
+ * @return the number of tiles newly proven
+ */
+static size_t compare_subset(Solver *solver, const size_t *inner,
+    int inner_length, int inner_mines, const size_t *outer, int outer_length,
+    int outer_mines) {
+  // Find the outer tiles that aren't inner ones, giving up if any inner tile
+  // isn't an outer one
+  size_t rest[8];
+  int rest_length = 0;
+  int shared = 0;
+  for ( int o = 0; o < outer_length; o++ ) {
+    bool found = false;
+    for ( int i = 0; i < inner_length && !found; i++ ) {
+      found = inner[i] == outer[o];
+    }
+    if ( found ) {
+      shared++;
+    } else {
+      rest[rest_length++] = outer[o];
+    }
+  }
+  if ( shared != inner_length || rest_length == 0 ) {
+    return 0;
+  }
+
+  int rest_mines = outer_mines - inner_mines;
+  if ( rest_mines != 0 && rest_mines != rest_length ) {
+    return 0;
+  }
+  size_t found = 0;
+  for ( int r = 0; r < rest_length; r++ ) {
+    found += prove(solver, rest[r], rest_mines == 0 ? SOLVE_SAFE : SOLVE_MINE);
+  }
+  return found;
+}
+
+/**
+ * Applies every deduction a frontier tile takes part in: on its own, and
+ * against each frontier tile near enough to share hidden tiles with it.
+ *
+ * @param solver the solver to check with
+ * @param index the index of the frontier tile
+ */
+static void check_tile(Solver *solver, size_t index) {
+  const Board *board = solver -> board;
+  size_t unknown[8];
+  int mines;
+  int length = solver_unknown_around(solver, index, unknown, &mines);
+  if ( length == 0 ) {
+    return;
+  }
+
+  // On its own: all mines, or all safe
+  if ( mines == 0 || mines == length ) {
+    for ( int i = 0; i < length; i++ ) {
+      solver -> found_single += prove(solver, unknown[i],
+          mines == 0 ? SOLVE_SAFE : SOLVE_MINE);
+    }
+    return;
+  }
+
+  // Against each nearby frontier tile, in both directions. Comparing with
+  // this tile as the superset can prove tiles around it, so its list is
+  // read again after that, to keep comparing with what's still unproven.
+  int x = board_x(board, index);
+  int y = board_y(board, index);
+  for ( int k = 0; k < 24; k++ ) {
+    int other_x = x + solver -> reach_dx[k];
+    int other_y = y + solver -> reach_dy[k];
+    if ( other_x < 0 || other_x >= board -> width
+        || other_y < 0 || other_y >= board -> height ) {
+      continue;
+    }
+    size_t other = index + solver -> reach[k];
+    if ( !( solver -> marks[other] & SOLVE_FRONTIER ) ) {
+      continue;
+    }
+    size_t other_unknown[8];
+    int other_mines;
+    int other_length = solver_unknown_around(solver, other, other_unknown,
+        &other_mines);
+    if ( other_length == 0 ) {
+      continue;
+    }
+    solver -> found_subset += compare_subset(solver, unknown, length, mines,
+        other_unknown, other_length, other_mines);
+    size_t proven = compare_subset(solver, other_unknown, other_length,
+        other_mines, unknown, length, mines);
+    if ( proven > 0 ) {
+      solver -> found_subset += proven;
+      length = solver_unknown_around(solver, index, unknown, &mines);
+      if ( length == 0 ) {
+        return;
+      }
+    }
+  }
+}
+
+/**
+ * Works out how much memory a solver for a board of a given size takes up
+ * front: a byte of marks per tile. Its work lists grow with the frontier.
+ *
+ * @param width the horizontal count of tiles across the board
+ * @param height the vertical count of tiles across the board
+ * @return the number of bytes, or 0 if the size is out of range or too big to
+ *  address
+ */
+size_t solver_bytes(int width, int height) {
+  if ( board_bytes(width, height) == 0 ) {
+    return 0;
+  }
+  // Marks cover the border ring too
+  return sizeof(Solver) + ( (size_t) width + 2 ) * ( (size_t) height + 2 );
+}
+
+/**
+ * Constructor for a Solver. Reads the board as it is now.
+ *
+ * @param board the board to solve
+ * @return the newly created Solver, or NULL if there isn't enough memory
+ */
+Solver *newSolver(Board *board) {
+  size_t len_total = (size_t) board -> stride * ( board -> height + 2 );
+  Solver *solver = calloc(1, sizeof(Solver));
+  unsigned char *marks = calloc(len_total, sizeof(unsigned char));
+  if ( !solver || !marks ) {
+    LOG_ERROR("Not enough memory to solve a %dx%d board.", board -> width,
+        board -> height);
+    free(solver);
+    free(marks);
+    return NULL;
+  }
+  solver -> board = board;
+  solver -> marks = marks;
+
+  // Build the table of offsets to tiles within two steps
+  int k = 0;
+  for ( int dy = -2; dy <= 2; dy++ ) {
+    for ( int dx = -2; dx <= 2; dx++ ) {
+      if ( dx == 0 && dy == 0 ) {
+        continue;
+      }
+      solver -> reach[k] = (ptrdiff_t) dy * board -> stride + dx;
+      solver -> reach_dx[k] = dx;
+      solver -> reach_dy[k] = dy;
+      k++;
+    }
+  }
+
+  read_board(solver);
+  return solver;
+}
+
+/**
+ * Frees a Solver and everything it holds. Leaves its board alone.
+ *
+ * @param solver the solver to free
+ */
+void solver_free(Solver *solver) {
+  free(solver -> marks);
+  free(solver -> frontier.items);
+  free(solver -> work.items);
+  free(solver -> safe.items);
+  free(solver -> mines.items);
+  free(solver);
+}
+
+/**
+ * Forgets everything proven, and reads the board from scratch. Use after the
+ * board is reset for a new game.
+ *
+ * @param solver the solver to reset
+ */
+void solver_reset(Solver *solver) {
+  Board *board = solver -> board;
+  size_t len_total = (size_t) board -> stride * ( board -> height + 2 );
+  memset(solver -> marks, 0, len_total);
+  solver -> frontier.length = 0;
+  solver -> safe.length = 0;
+  solver -> mines.length = 0;
+  solver -> found_single = 0;
+  solver -> found_subset = 0;
+  read_board(solver);
+}
+
+/**
+ * Catches up with the tiles on the board's change list. Doesn't clear the
+ * list, which belongs to whoever drives the board. If the list overflowed,
+ * reads the whole board again instead.
+ *
+ * @param solver the solver to update
+ */
+void solver_update(Solver *solver) {
+  Board *board = solver -> board;
+  if ( board -> changes_overflow ) {
+    LOG_DEBUG("Too many changes to follow, reading the whole board.");
+    read_board(solver);
+    return;
+  }
+
+  for ( size_t c = 0; c < board -> changes_len; c++ ) {
+    size_t index = board -> changes[c];
+    // Flags don't change what's proven, so only exposed tiles matter
+    if ( !tile_is_exposed(board -> cells[index]) ) {
+      continue;
+    }
+    // Numbers around it have one less hidden tile
+    for ( int i = 0; i < 8; i++ ) {
+      size_t near = index + board -> nearby[i];
+      if ( !( solver -> marks[near] & SOLVE_FRONTIER ) ) {
+        continue;
+      }
+      if ( nearby_hidden(board, near) == 0 ) {
+        leave_frontier(solver, near);
+      } else {
+        queue_check(solver, near);
+      }
+    }
+    // And it may be a number with hidden tiles around it itself
+    join_frontier(solver, index);
+  }
+}
+
+/**
+ * Applies deductions until no more tiles can be proven. See solver.h for the
+ * deductions made.
+ *
+ * @param solver the solver to run
+ * @return the number of tiles newly proven safe or mined
+ */
+size_t solver_solve(Solver *solver) {
+  size_t before = solver -> found_single + solver -> found_subset;
+  while ( solver -> work.length > 0 ) {
+    size_t index = solver -> work.items[--solver -> work.length];
+    solver -> marks[index] &= ~SOLVE_QUEUED;
+    if ( solver -> marks[index] & SOLVE_FRONTIER ) {
+      check_tile(solver, index);
+    }
+  }
+  return solver -> found_single + solver -> found_subset - before;
+}
+
+/**
+ * Hands out a tile proven safe that's still hidden. It may be flagged.
+ *
+ * @param solver the solver to take from
+ * @param index where to place the index of the safe tile
+ * @return true if there was one, false if none are left
+ */
+bool solver_next_safe(Solver *solver, size_t *index) {
+  while ( solver -> safe.length > 0 ) {
+    size_t next = solver -> safe.items[--solver -> safe.length];
+    if ( !tile_is_exposed(solver -> board -> cells[next]) ) {
+      *index = next;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Hands out a tile proven to be a mine that isn't flagged yet.
+ *
+ * @param solver the solver to take from
+ * @param index where to place the index of the mine
+ * @return true if there was one, false if none are left
+ */
+bool solver_next_mine(Solver *solver, size_t *index) {
+  while ( solver -> mines.length > 0 ) {
+    size_t next = solver -> mines.items[--solver -> mines.length];
+    if ( !( solver -> board -> cells[next] & ( TILE_EXPOSED | TILE_FLAGGED ) ) ) {
+      *index = next;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Plays a board from where it stands with only the moves the solver proves
+ * safe, exposing each batch of proven tiles before solving again, until the
+ * board is cleared or nothing more can be proven. Reads the board from
+ * scratch first, so it can follow a reset.
+ *
+ * @param solver the solver to play with
+ * @return true if the board was cleared, false if a guess is needed
+ */
+bool solver_clear(Solver *solver) {
+  Board *board = solver -> board;
+  int64_t goal = board_safe_tiles(board);
+  solver_reset(solver);
+  size_t index;
+  while ( board -> exposed < goal ) {
+    solver_update(solver);
+    solver_solve(solver);
+    // Expose everything proven so far before solving again, so the solver
+    // catches up on all of it at once instead of a tile at a time
+    board_changes_clear(board);
+    if ( !solver_next_safe(solver, &index) ) {
+      return false;
+    }
+    do {
+      board_expose_pick(board, board_x(board, index), board_y(board, index));
+    } while ( solver_next_safe(solver, &index) );
+  }
+  return true;
+}
+
+/**
+ * Gets the current frontier: exposed numbers that still have hidden tiles
+ * around them.
+ *
+ * @param solver the solver to check
+ * @param length where to place the number of frontier tiles
+ * @return the indices of the frontier tiles
+ */
+const size_t *solver_frontier(Solver *solver, size_t *length) {
+  if ( solver -> frontier_stale > 0 ) {
+    sweep_frontier(solver);
+  }
+  *length = solver -> frontier.length;
+  return solver -> frontier.items;
+}
@@ -0,0 +1,169 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "board.h"
+
+/** Mark on a tile the solver has proven safe. */
+#define SOLVE_SAFE 0x01
+/** Mark on a tile the solver has proven to be a mine. */
+#define SOLVE_MINE 0x02
+/** Mark on an exposed number that still has hidden tiles next to it. */
+#define SOLVE_FRONTIER 0x04
+/** Mark on a frontier tile waiting in the work list to be checked. */
+#define SOLVE_QUEUED 0x08
+
+/**
+ * A list of tile indices that grows as needed. Once it has grown to fit, it's
+ * reused without allocating.
+ */
+typedef struct IndexList {
+  size_t *items;
+  size_t length;
+  size_t capacity;
+} IndexList;
+
+/**
+ * Finds every tile on a board that can be proven safe or mined from the
+ * numbers showing. Keeps a frontier of the exposed numbers that still have
+ * hidden tiles around them, and updates it from the board's change list, so
+ * the work after each move depends on how much changed, not on the board's
+ * size.
+ *
+ * Flags are the player's guesses, so the solver doesn't trust them: a
+ * flagged tile is just another hidden tile until it's proven to be a mine.
+ */
+typedef struct Solver {
+  // Board being solved
+  Board *board;
+  // SOLVE_* marks for each tile in board -> cells
+  unsigned char *marks;
+  // Tiles marked SOLVE_FRONTIER. Tiles leave the frontier by losing the mark,
+  // and are swept out of the list once enough of them have.
+  IndexList frontier;
+  size_t frontier_stale;
+  // Frontier tiles whose neighborhood changed since they were last checked
+  IndexList work;
+  // Tiles proven safe or mined that haven't been handed out yet
+  IndexList safe;
+  IndexList mines;
+  // Offsets from a tile's index to every tile within two steps of it, the
+  // only ones that can share hidden neighbors with it
+  ptrdiff_t reach[24];
+  signed char reach_dx[24];
+  signed char reach_dy[24];
+  // How many tiles were proven by a single number, or by comparing two
+  size_t found_single;
+  size_t found_subset;
+} Solver;
+
+
+/**
+ * Constructor for a Solver. Reads the board as it is now.
+ *
+ * @param board the board to solve
+ * @return the newly created Solver, or NULL if there isn't enough memory
+ */
+Solver *newSolver(Board *board);
+
+/**
+ * Frees a Solver and everything it holds. Leaves its board alone.
+ *
+ * @param solver the solver to free
+ */
+void solver_free(Solver *solver);
+
+/**
+ * Works out how much memory a solver for a board of a given size takes up
+ * front: a byte of marks per tile. Its work lists grow with the frontier.
+ *
+ * @param width the horizontal count of tiles across the board
+ * @param height the vertical count of tiles across the board
+ * @return the number of bytes, or 0 if the size is out of range or too big to
+ *  address
+ */
+size_t solver_bytes(int width, int height);
+
+/**
+ * Forgets everything proven, and reads the board from scratch. Use after the
+ * board is reset for a new game.
+ *
+ * @param solver the solver to reset
+ */
+void solver_reset(Solver *solver);
+
+/**
+ * Catches up with the tiles on the board's change list. Doesn't clear the
+ * list, which belongs to whoever drives the board. If the list overflowed,
+ * reads the whole board again instead.
+ *
+ * @param solver the solver to update
+ */
+void solver_update(Solver *solver);
+
+/**
+ * Applies deductions until no more tiles can be proven:
+ *  - A number with as many unproven mines left as unproven hidden neighbors
+ *    has only mines around it; one with none left has only safe tiles.
+ *  - If one number's hidden neighbors are all around a second number, the
+ *    second number's other neighbors hold the difference of their mines.
+ *
+ * @param solver the solver to run
+ * @return the number of tiles newly proven safe or mined
+ */
+size_t solver_solve(Solver *solver);
+
+/**
+ * Hands out a tile proven safe that's still hidden.
+ *
+ * @param solver the solver to take from
+ * @param index where to place the index of the safe tile
+ * @return true if there was one, false if none are left
+ */
+bool solver_next_safe(Solver *solver, size_t *index);
+
+/**
+ * Hands out a tile proven to be a mine that isn't flagged yet.
+ *
+ * @param solver the solver to take from
+ * @param index where to place the index of the mine
+ * @return true if there was one, false if none are left
+ */
+bool solver_next_mine(Solver *solver, size_t *index);
+
+/**
+ * Plays a board from where it stands with only the moves the solver proves
+ * safe, exposing each batch of proven tiles before solving again, until the
+ * board is cleared or nothing more can be proven. Reads the board from
+ * scratch first, so it can follow a reset.
+ *
+ * @param solver the solver to play with
+ * @return true if the board was cleared, false if a guess is needed
+ */
+bool solver_clear(Solver *solver);
+
+/**
+ * Finds the hidden tiles around a number that aren't proven yet, and how many
+ * of them must be mines.
+ *
+ * @param solver the solver to check with
+ * @param index the index of the number
+ * @param unknown where to place the indices of the unproven tiles
+ * @param mines where to place how many of them are mines
+ * @return the number of unproven tiles, 0-8
+ */
+int solver_unknown_around(const Solver *solver, size_t index, size_t unknown[8],
+    int *mines);
+
+/**
+ * Gets the current frontier: exposed numbers that still have hidden tiles
+ * around them.
+ *
+ * @param solver the solver to check
+ * @param length where to place the number of frontier tiles
+ * @return the indices of the frontier tiles
+ */
+const size_t *solver_frontier(Solver *solver, size_t *length);
+
+#endif
@@ -4,62 +4,33 @@
 #include <stdbool.h>
 
 
-/**
- * Tile display status:
- *  - BLANK: User has not flagged or exposed this tile.
- *  - FLAGGED: User has flagged this tile as a possible bomb.
- *  - EXPOSED: User has exposed this tile
- */
-
-/**
- * Tile data structure, holding its position, whether it has a bomb,
- * and its display status.
- */
-
-
-/**
- * Allocates and initializes a new Tile with the given data.
- *
- * @param x the x position (from the left) of the new Tile.
- * @param y the y position (from the top) of the new Tile.
- * @param bomb BOMB_HERE (9) if this tile is a bomb, else 0-8 indicating nearby
- *  bombs
- * @return a Tile pointer to a created Tile struct
- */
-Tile *newTile(short x, short y, short bomb) {
-  Tile *tile = malloc(sizeof(Tile));
-  tile -> x = x;
-  tile -> y = y;
-  tile -> bomb = bomb;
-  tile -> flagged = false;
-  tile -> exposed = false;
-  return tile;
-}
-
 /**
  * Returns a string representation of this Tile's data.
  * If it is blank or flagged, hides bomb data.
  *
  * @param tile the tile to print data for
- * @return a String of the form ( x, y, display)
+ * @param x the x position (from the left) of the tile
+ * @param y the y position (from the top) of the tile
+ * @param string where to place a string of the form ( x, y, display), at
+ *  least TILE_STRING_MAX characters
+ * @return string
  */
-char *tile_toString(Tile *tile) {
+char *tile_toString(Tile tile, int x, int y, char *string) {
   char status[8];
-  if (tile -> exposed) {
-    if (tile -> bomb == BOMB_HERE) {
+  if ( tile_is_exposed(tile) ) {
+    if ( tile_is_mine(tile) ) {
       sprintf(status, "BOMB");
     } else {
-      sprintf(status, "%d", tile -> bomb);
+      sprintf(status, "%d", tile_count(tile));
     }
   } else {
-    if (tile -> flagged) {
+    if ( tile_is_flagged(tile) ) {
       sprintf(status, "flagged");
     } else {
       sprintf(status, "blank");
     }
   }
-  char *string = malloc(sizeof(char) * 16);
-  sprintf(string, "(%2d,%2d,%s)", tile->x, tile->y, status);
+  snprintf(string, TILE_STRING_MAX, "(%2d,%2d,%s)", x, y, status);
   return string;
 }
 
@@ -74,30 +45,30 @@ char *tile_toString(Tile *tile) {
  * 
  * @returns the character representing this space on the minesweeper board.
  */
-char tile_toChar(Tile *tile) {
+char tile_toChar(Tile tile) {
   // If the tile is already exposed
-  if ( tile -> exposed ) {
+  if ( tile_is_exposed(tile) ) {
     // If flagged and NOT a bomb, show as X
-    if ( tile -> flagged && tile -> bomb != BOMB_HERE ) {
+    if ( tile_is_flagged(tile) && !tile_is_mine(tile) ) {
       return 'X';
     }
     // If bomb, show as '*'
-    if ( tile -> bomb == BOMB_HERE ) {
+    if ( tile_is_mine(tile) ) {
       return '*';
     }
     // If empty, show as ' '
-    else if ( tile -> bomb == 0 ) {
+    else if ( tile_count(tile) == 0 ) {
       return ' ';
     }
     // Otherwise, show the number itself
     else {
-      return '0' + tile -> bomb;
+      return '0' + tile_count(tile);
     }
   }
   // Otherwise, look at whether or not it's flagged
   else {
     // If flagged, show as '!'
-    if ( tile -> flagged ) {
+    if ( tile_is_flagged(tile) ) {
       return '!';
     }
     // If not touched, show as '.'
@@ -1,39 +1,75 @@
-// Stored in Tile -> bomb indicating that a bomb is at this tile
+#ifndef TILE_H
+#define TILE_H
+
+// Returned by tile_bomb() indicating that a bomb is at this tile
 #define BOMB_HERE 9
 
+/** Bits of a Tile holding the count of nearby bombs, 0-8. */
+#define TILE_COUNT 0x0F
+/** Bit of a Tile set when a bomb is at this tile. */
+#define TILE_MINE 0x10
+/** Bit of a Tile set when the user has exposed this tile. */
+#define TILE_EXPOSED 0x20
+/** Bit of a Tile set when the user has flagged this tile as a possible bomb. */
+#define TILE_FLAGGED 0x40
+/**
+ * Bit of a Tile set on the ring of tiles around the edge of a Board. Border
+ * tiles are also marked exposed, so they are never counted or exposed.
+ */
+#define TILE_BORDER 0x80
+
 
 /**
- * Tile data structure, holding its position, whether it has a bomb,
- * and its display status.
+ * Tile data, packed into a single byte: the count of nearby bombs in the low
+ * bits, plus one bit each for whether it has a bomb, is exposed, or is
+ * flagged. A Tile's position is given by where it sits on its Board.
  */
-typedef struct Tile {
-  short x;
-  short y;
-  short bomb; // BOMB_HERE (9) for bomb, otherwise 0-8 for nearby
-  _Bool exposed;
-  _Bool flagged;
-} Tile;
+typedef unsigned char Tile;
+
+
+/** @return true if the tile has a bomb on it. */
+static inline _Bool tile_is_mine(Tile tile) {
+  return ( tile & TILE_MINE ) != 0;
+}
 
+/** @return true if the tile has been exposed by the user. */
+static inline _Bool tile_is_exposed(Tile tile) {
+  return ( tile & TILE_EXPOSED ) != 0;
+}
+
+/** @return true if the tile has been flagged by the user. */
+static inline _Bool tile_is_flagged(Tile tile) {
+  return ( tile & TILE_FLAGGED ) != 0;
+}
+
+/** @return the number of bombs next to this tile, 0-8. */
+static inline short tile_count(Tile tile) {
+  return tile & TILE_COUNT;
+}
 
 /**
- * Allocates and initializes a new Tile with the given data.
- *
- * @param x the x position (from the left) of the new Tile.
- * @param y the y position (from the top) of the new Tile.
- * @param bomb BOMB_HERE (9) if this tile is a bomb, else 0-8 indicating nearby
+ * @return BOMB_HERE (9) if this tile is a bomb, else 0-8 indicating nearby
  *  bombs
- * @return a Tile pointer to a created Tile struct
  */
-struct Tile *newTile(short x, short y, short bomb);
+static inline short tile_bomb(Tile tile) {
+  return tile_is_mine(tile) ? BOMB_HERE : tile_count(tile);
+}
 
 
+/** Size of a buffer big enough for any string from tile_toString. */
+#define TILE_STRING_MAX 32
+
 /**
  * Prints out a Tile's data. If it is blank or flagged, hides bomb data.
  *
  * @param tile the tile to print data for
- * @return a String of the form ( x, y, display)
+ * @param x the x position (from the left) of the tile
+ * @param y the y position (from the top) of the tile
+ * @param string where to place a string of the form ( x, y, display), at
+ *  least TILE_STRING_MAX characters
+ * @return string
  */
-char *tile_toString(struct Tile *tile);
+char *tile_toString(Tile tile, int x, int y, char *string);
 
 /**
  * Returns a character representation of this Tile's data.
@@ -43,8 +79,9 @@ char *tile_toString(struct Tile *tile);
  *  '*' for bomb
  *  ' ' for empty
  *  1-9 for nearby
- * 
+ *
  * @returns the character representing this space on the minesweeper board.
  */
-char tile_toChar(struct Tile *tile);
+char tile_toChar(Tile tile);
 
+#endif
@@ -0,0 +1,58 @@
+#ifndef WORDS_H
+#define WORDS_H
+
+#include <stdint.h>
+#include <string.h>
+#include "tile.h"
+
+/**
+ * Helpers for working on tiles and bits a 64-bit word at a time, shared by
+ * the board and the bitboard. Internal: nothing outside src uses them.
+ */
+
+/** The low bit of every byte in a word, to copy a byte across it. */
+#define BYTE_LOWS 0x0101010101010101ULL
+
+/**
+ * Reads up to 8 tiles into a word, the first tile in the low byte.
+ *
+ * @param tiles the tiles to read
+ * @param count how many to read, 1-8
+ * @param pad the tile to read in place of each one past count
+ * @return the tiles
+ */
+static inline uint64_t load_tiles(const Tile *tiles, int count, Tile pad) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  // The low byte is already first in memory
+  if ( count == 8 ) {
+    uint64_t word;
+    memcpy(&word, tiles, sizeof(word));
+    return word;
+  }
+#endif
+  uint64_t word = 0;
+  for ( int i = 0; i < 8; i++ ) {
+    word |= (uint64_t) ( i < count ? tiles[i] : pad ) << ( 8 * i );
+  }
+  return word;
+}
+
+/**
+ * Counts the set bits in a word.
+ *
+ * @param word the word to count
+ * @return the number of bits set
+ */
+static inline int bit_count(uint64_t word) {
+#if defined(__GNUC__)
+  return __builtin_popcountll(word);
+#else
+  word = word - ( ( word >> 1 ) & 0x5555555555555555ULL );
+  word = ( word & 0x3333333333333333ULL )
+    + ( ( word >> 2 ) & 0x3333333333333333ULL );
+  word = ( word + ( word >> 4 ) ) & 0x0F0F0F0F0F0F0F0FULL;
+  return ( word * BYTE_LOWS ) >> 56;
+#endif
+}
+
+#endif